@@ -0,0 +1,24 @@
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+
+// 原子地替换文件：先写入同一目录下的临时文件（<文件名>.tmp），刷到磁盘（fsync）后改名
+// 覆盖目标文件，再刷新目录项。任何时候目标文件要么是完整的旧内容，要么是完整的新内容；
+// 写入中途崩溃或磁盘写满只会留下临时文件，不会损坏原文件。
+namespace AtomicFile {
+
+// writer 向流中写入文件内容；失败时删除临时文件并抛出异常，原文件不变
+void write(const std::filesystem::path& path, const std::function<void(std::ostream&)>& writer);
+
+// 把目录项（新建、改名、硬链接的文件）刷到磁盘
+void syncDirectory(const std::filesystem::path& dir);
+
+// 删除目录下之前崩溃时残留的临时文件
+void removeLeftovers(const std::filesystem::path& dir);
+
+} // namespace AtomicFile
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef BACKUP_H
+#define BACKUP_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// 数据库备份目录：<备份路径>/<数据库名>/<时间>/，每个备份都是完整的数据库目录（可以直接
+// 复制到数据目录下作为一个数据库打开），另有 backup.manifest 记录其中每个文件的来源。
+//
+// 表文件和统计文件保存后不再被原地修改（保存时写入临时文件再改名替换，见 AtomicFile），
+// 打开的表文件之后被替换也仍读到原来的内容，复制不需要持有表锁。备份中的文件不与数据目录
+// 共享（数据目录所在的磁盘损坏时备份仍然可用）。增量备份比较文件的身份（设备号、inode、
+// 大小、修改时间），与上一个备份相同的文件从上一个备份硬链接过来（不支持硬链接时复制），
+// 只复制变化了的表。
+namespace Backup {
+
+constexpr const char* MANIFEST_NAME = "backup.manifest";
+
+struct FileEntry {
+    std::string name;        // 备份目录中的文件名
+    std::string identity;    // 来源文件的身份，从内存写出的文件为空（不与任何文件相同）
+    uint64_t size = 0;
+};
+
+struct Manifest {
+    std::string database;
+    uint64_t commitTs = 0;   // 备份的快照版本
+    std::vector<FileEntry> files;
+};
+
+// 文件的身份：内容相同的文件身份不一定相同，但身份相同的文件内容一定相同
+// （前提是文件只会被整体替换）；文件不存在时返回空
+std::string fileIdentity(const std::filesystem::path& path);
+
+// 硬链接 from 到 to，返回 true；不支持硬链接（跨文件系统等）时返回 false，不抛出异常
+bool link(const std::filesystem::path& from, const std::filesystem::path& to);
+
+void writeManifest(const std::filesystem::path& dir, const Manifest& manifest);
+// 读取备份目录的清单，不是完整的备份时返回 false
+bool readManifest(const std::filesystem::path& dir, Manifest& manifest);
+
+// 数据库的备份中最新的完整备份，没有时返回空路径
+std::filesystem::path latestBackup(const std::filesystem::path& databaseRoot);
+// 新备份的目录名（按时间，不与已有的重复），不创建目录
+std::filesystem::path newBackupDir(const std::filesystem::path& databaseRoot);
+
+} // namespace Backup
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "forward_declarations.h"
+
+// 布隆过滤器：每个值约 10 位、7 个哈希函数，容量内的误判率约 1%，不会漏判
+class BloomFilter {
+public:
+    static constexpr size_t BITS_PER_VALUE = 10;
+    static constexpr int HASHES = 7;
+
+    BloomFilter() = default;
+    explicit BloomFilter(size_t capacity);
+
+    void add(const std::string& value);
+    bool mayContain(const std::string& value) const;
+
+    size_t getCapacity() const { return capacity; }
+    size_t getCount() const { return count; }
+
+private:
+    std::vector<uint64_t> bits;
+    size_t capacity = 0;
+    size_t count = 0;
+
+    static uint64_t hash(const std::string& value);
+};
+
+// 一列的布隆过滤器：整张表一个，按区域映射的分块每块一个。只在内存中，加载表时随插入重建。
+// 值（包括表示 NULL 的空字符串）按存储的文本精确匹配，与 WHERE 中的等值比较一致。
+class ColumnBloomFilter {
+public:
+    void rebuild(const TableRows& data, size_t column);
+    // 插入第 rowIndex 行；整张表的过滤器超出容量时按两倍容量用 data 重建
+    void addRow(const TableRows& data, size_t column, size_t rowIndex);
+    // 更新后的值加入过滤器，旧值无法移除（只会增加误判）
+    void updateRow(size_t rowIndex, const std::string& value);
+
+    bool mayContain(const std::string& value) const { return table.mayContain(value); }
+    bool blockMayContain(size_t block, const std::string& value) const;
+
+private:
+    BloomFilter table;
+    std::vector<BloomFilter> blocks;
+};
+
+#endif
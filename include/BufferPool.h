@@ -0,0 +1,79 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "Table.h"
+
+// 数据页缓冲池：缓存从表文件中读出的数据块（页），每页是一个只含这一块的行、已建好区域映射、
+// 布隆过滤器和字典编码的小表。页由 (文件编号, 块号) 标识，容量按页占用的内存计算。
+//
+// fetch() 返回的句柄固定（pin）这一页，持有句柄期间页不会被淘汰，句柄全部释放即解除固定。
+// 页只读：表的修改按 MVCC 写时复制整张表并重写表文件，缓冲池中没有需要写回的脏页，
+// 旧文件编号的页由 dropFile() 丢弃。
+//
+// 超出容量时按 LRU-K（K = 2）淘汰：比较每页倒数第 K 次访问的时间，最早的先淘汰；访问
+// 不足 K 次的页视为最早，彼此之间按最近一次访问淘汰。一次性的大表扫描只访问每页一次，
+// 不会挤掉被反复访问的页。
+// 比缓冲池大的文件被顺序扫描时，按最近一次访问淘汰会让每次扫描都在读入后面的页时挤掉前面的
+// 页，反复扫描永远不命中。因此要淘汰的页恰好属于正在读入的文件时，改为淘汰最近读入的那一页：
+// 文件前部的页留在缓冲池中，下次扫描时命中并成为访问过 K 次的页。
+class BufferPool {
+public:
+    using PageHandle = std::shared_ptr<const Table>;
+    static constexpr size_t K = 2;
+
+    // capacityBytes 为 0 表示不缓存，每次都重新读取
+    explicit BufferPool(size_t capacityBytes);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 缩小容量时立即淘汰未固定的页
+    void setCapacity(size_t bytes);
+    size_t getCapacity() const;
+
+    // 累计的命中、未命中和淘汰次数，以及当前缓存的页
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t pages = 0;
+        size_t bytes = 0;
+    };
+    Stats getStats() const;
+
+    // 取出并固定一页；不在缓冲池中时调用 load 读取（不持有缓冲池的锁），hit 返回是否命中
+    PageHandle fetch(uint64_t fileId, uint64_t pageNo, const std::function<Table()>& load,
+                     bool* hit = nullptr);
+
+    // 文件已被替换或删除，丢弃它的页（仍被固定的页在句柄释放后回收）
+    void dropFile(uint64_t fileId);
+
+private:
+    using PageId = std::pair<uint64_t, uint64_t>;
+    struct Frame {
+        PageHandle page;
+        size_t bytes = 0;
+        uint64_t history[K] = {};   // 最近 K 次访问的时钟值，history[0] 为最近一次，0 表示没有
+    };
+
+    mutable std::mutex mutex;
+    std::map<PageId, Frame> frames;
+    size_t capacity;
+    size_t usedBytes = 0;
+    uint64_t clock = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    void recordAccess(Frame& frame);
+    // 调用者需持有 mutex；loadingFile 为正在读入页的文件编号（见上面顺序扫描的说明），0 表示没有
+    void evictLocked(uint64_t loadingFile = 0);
+};
+
+#endif
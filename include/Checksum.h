@@ -0,0 +1,21 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C（Castagnoli 多项式），用于检查表文件的每一块是否损坏
+//
+// x86-64 上在运行时检测 SSE4.2，支持时使用 crc32 指令每次处理 8 字节；ARM 在编译器启用
+// CRC 扩展时使用对应指令；其他情况按字节查表计算。各种实现的结果相同。
+namespace Checksum {
+
+// crc 为之前部分的结果，可以分段计算：crc32c(b, n2, crc32c(a, n1)) == crc32c(a + b, n1 + n2)
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+// 当前使用的实现，用于基准测试的输出
+const char* crc32cImplementation();
+
+} // namespace Checksum
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef COLUMNDICTIONARY_H
+#define COLUMNDICTIONARY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "forward_declarations.h"
+
+// 文本列的字典编码：每个不同的值分配一个编码，每行记录值的编码。等值条件、GROUP BY
+// 和连接按编码比较，不再逐行比较字符串。
+//
+// 只在不同值较少时启用：不超过 MAX_VALUES 个，并且不超过 SMALL_DICTIONARY 个或平均
+// 每个值至少出现 MIN_REPEAT 次。插入或更新使不同值过多时停用，行数翻倍后重新尝试。
+// 更新后不再出现的值留在字典中，删除后整体重建。只在内存中，加载表时随插入重建。
+// 值（包括表示 NULL 的空字符串）按存储的文本精确匹配，与 WHERE 中的等值比较一致。
+class ColumnDictionary {
+public:
+    static constexpr uint32_t NO_CODE = UINT32_MAX;
+    static constexpr size_t MAX_VALUES = 4096;
+    static constexpr size_t SMALL_DICTIONARY = 64;
+    static constexpr size_t MIN_REPEAT = 4;
+
+    void rebuild(const TableRows& data, size_t column);
+    // 插入第 rowIndex 行（已追加到 data 末尾）
+    void addRow(const TableRows& data, size_t column, size_t rowIndex);
+    // 第 rowIndex 行的值改变后调用
+    void updateRow(const TableRows& data, size_t column, size_t rowIndex);
+
+    // 已启用并且编码与表的行数一致
+    bool isActive(size_t rowCount) const { return active && codes.size() == rowCount; }
+
+    uint32_t code(size_t rowIndex) const { return codes[rowIndex]; }
+    // 值的编码，不在字典中时返回 NO_CODE
+    uint32_t find(const std::string& value) const;
+    const std::string& value(uint32_t code) const { return values[code]; }
+    size_t size() const { return values.size(); }
+
+private:
+    bool active = false;
+    size_t retryAt = 0;                                  // 停用后行数达到这个值时重新尝试
+    std::vector<std::string> values;                     // 编码 -> 值
+    std::unordered_map<std::string, uint32_t> lookup;    // 值 -> 编码
+    std::vector<uint32_t> codes;                         // 行号 -> 编码
+
+    static bool withinLimit(size_t valueCount, size_t rowCount);
+    // 值的编码，新值分配编码；超出限制时停用并返回 NO_CODE
+    uint32_t encode(const std::string& value, size_t rowCount);
+    void disable(size_t rowCount);
+};
+
+#endif
@@ -4,12 +4,62 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <filesystem>
+#include <chrono>
+#include <condition_variable>
+#include <set>
+#include <thread>
 #include "Table.h"
 #include "SQLParser.h"
+#include "QueryProfile.h"
+#include "QueryStats.h"
+#include "JoinPlanner.h"
+#include "ThreadPool.h"
+#include "BufferPool.h"
+#include "Backup.h"
 
 class DatabaseManager {
 public:
+    // 表句柄：持有表的一个已提交版本，句柄存活期间该版本不会被回收或卸载
+    using TableHandle = std::shared_ptr<const Table>;
+    
+    // 一张表的一个已提交版本。打开数据库时只读取表文件中的列定义，表数据在第一次访问时
+    // 才加载（tableData()）。同一个版本被之后的各个快照共享，加载一次后对它们都可见。
+    // 已加载的表数据超出内存上限时可以卸载（只卸载已写入表文件的当前版本），下次访问时重新加载
+    struct TableVersion {
+        std::string name;
+        std::filesystem::path file;                       // 保存这个版本的表文件
+        std::vector<ColumnDef> columns;
+        uint64_t id = 0;                                  // 版本编号，也是缓冲池中页的文件编号
+        uint64_t rowCount = 0;                            // 行数，用于估算加载后占用的内存
+        mutable std::mutex mutex;                         // 保护 table 和 memoryBytes
+        mutable TableHandle table;                        // 未加载或已卸载时为空
+        mutable size_t memoryBytes = 0;                   // 行数据占用的内存，卸载时按需计算
+        mutable std::atomic<uint64_t> lastAccess{0};      // 最近一次访问的时钟值
+        mutable std::atomic<uint64_t> previousAccess{0};  // 倒数第二次访问的时钟值（LRU-2）
+        mutable std::atomic<bool> persisted{false};       // 表文件已写入这个版本
+    };
+    using TableVersionPtr = std::shared_ptr<const TableVersion>;
+    
+    // MVCC: 一个已提交的数据库版本（不可变）
+    // 读者持有快照期间看到的始终是同一组表版本，写者通过写时复制提交新版本，
+    // 旧版本在最后一个持有者释放后自动回收
+    struct Snapshot {
+        uint64_t commitTs = 0;
+        std::string database;
+        std::map<std::string, TableVersionPtr> tables;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+    
     DatabaseManager(const std::string& path);
+    // 延迟保存模式下先把未保存的表写入表文件
+    ~DatabaseManager();
     
     // 数据库操作
     bool createDatabase(const std::string& dbName);
@@ -19,19 +69,28 @@ public:
     // 表操作
     bool createTable(const std::string& tableName, const std::vector<ColumnDef>& columns);
     bool dropTable(const std::string& tableName);
+    // ANALYZE：重新计算表的统计信息，保存在表文件旁的 <表名>.stats 中
+    bool analyzeTable(const std::string& tableName);
+    // ALTER TABLE ... ADD/DROP BLOOM FILTER：开启或关闭列的布隆过滤器，设置保存在表文件的列定义中
+    bool setBloomFilter(const std::string& tableName, const std::vector<std::string>& columns, bool enabled);
     bool insertInto(const std::string& tableName, const std::vector<std::string>& values);
     std::vector<std::vector<std::string>> select(const std::string& tableName, 
                                                 const std::vector<std::string>& columns,
                                                 const std::string& whereClause = "");
     
-    const Table& getTable(const std::string& tableName) const;
+    TableHandle getTable(const std::string& tableName) const;
+    bool replaceTable(const std::string& tableName, Table newTable);
     bool insertIntoTable(const std::string& tableName,
                         const std::vector<std::string>& columns,
                         const std::vector<std::string>& values);
     
     // 查询执行
-    std::vector<std::vector<std::string>> executeSelect(const SQLParser::ParsedQuery& query);
+    // EXPLAIN [ANALYZE] 查询返回执行计划，列名见 getResultHeaders()
+    std::vector<std::vector<std::string>> executeSelect(const SQLParser::ParsedQuery& query,
+                                                        QueryProfile* profile = nullptr);
     bool executeNonQuery(const SQLParser::ParsedQuery& query);
+    // SELECT 结果的列名（SELECT * 时使用表的全部列名）
+    std::vector<std::string> getResultHeaders(const SQLParser::ParsedQuery& query) const;
     
     // 工具方法
     void setDbPath(const std::string& path);
@@ -39,27 +98,169 @@ public:
     std::vector<std::string> getDatabaseList();
     std::string getCurrentDatabase() const;
     
-    std::string getDbPath() const { return dbPath; }
+    std::string getDbPath() const;
+    
+    // 获取当前已提交的快照（无锁读取）
+    SnapshotPtr acquireSnapshot() const;
+    // 表版本的数据，未加载时从表文件加载
+    TableHandle tableData(const TableVersion& version) const;
+    
+    // 已加载的表数据的内存上限（字节），超出时按 LRU-2 卸载表，0 表示不限制。
+    // 估计加载后会超出上限或缓冲池容量的大表不整张加载，单表查询经缓冲池逐页扫描
+    void setTableMemoryLimit(size_t bytes);
+    // 数据页缓冲池的容量（字节），0 表示不缓存页
+    static constexpr size_t DEFAULT_BUFFER_POOL_BYTES = 64 << 20;
+    void setBufferPoolSize(size_t bytes);
+    BufferPool::Stats getBufferPoolStats() const;
+    // 加载表数据使用的线程数，0 表示按 CPU 核数，1 表示在调用线程中依次加载；
+    // 需在第一次加载表之前设置
+    void setLoadThreads(size_t threads);
+    // 并行加载当前数据库中所有未加载的表（启动时预热），受内存上限约束
+    void preloadTables();
+    // 自动保存间隔。为 0（默认）时每次修改都同步写入表文件；大于 0 时修改只提交到内存并
+    // 把表标记为未保存，由后台线程每隔 interval 写入表文件，切换或重新读取数据库、关闭
+    // 时也会写入。崩溃时最多丢失最近一个间隔内的修改。改回 0 时立即写入未保存的表
+    void setAutoSaveInterval(std::chrono::milliseconds interval);
+    // 立即写入所有未保存的表，写入失败时抛出异常（失败的表仍标记为未保存）
+    void flush();
+    
+    // 在线备份当前数据库到 <backupPath>/<数据库名>/<时间>/（格式见 Backup.h）。备份的是调用时
+    // 的一致快照（包括延迟保存模式下还未写入的修改），不阻塞写入：每张表只在打开它的表文件
+    // 时短暂持有表锁，复制和写出都在锁外进行。incremental 为 true 时与上一个备份相同的文件
+    // 从上一个备份硬链接，只复制变化了的表；与上一个备份完全相同时不创建新备份
+    struct BackupResult {
+        std::string path;          // 备份目录
+        bool created = false;      // 与上一个备份相同时为 false，path 为上一个备份
+        size_t files = 0;
+        size_t linkedFiles = 0;    // 硬链接（没有复制数据）的文件数
+        uint64_t copiedBytes = 0;  // 复制或写出的字节数
+    };
+    BackupResult backupDatabase(const std::string& backupPath, bool incremental = true);
+    // 自动备份：后台线程每隔 interval 增量备份当前数据库到 backupPath，
+    // backupPath 为空或 interval 为 0 时关闭
+    void setAutoBackup(const std::string& backupPath, std::chrono::milliseconds interval);
+    
+    // 查询统计和慢查询日志（日志位于数据目录下的 slow_query.log）
+    // 统计可以通过系统表 sys_query_stats 查询
+    static constexpr const char* SYS_QUERY_STATS = "sys_query_stats";
+    // 当前数据库各表的列统计信息（ANALYZE 之后才有内容）
+    static constexpr const char* SYS_COLUMN_STATS = "sys_column_stats";
+    QueryStats& getQueryStats();
     
 private:
+    // 并发模型（加锁顺序: catalogMutex -> 表锁 -> commitMutex / autoSaveMutex）：
+    //   读者只读取快照，不加锁；
+    //   建表/删表/切换数据库独占 catalogMutex；
+    //   DML 共享 catalogMutex 并持有该表的写锁，不同表的写入可以并行
     std::string dbPath;
     std::string currentDatabase;
-    std::map<std::string, Table> tables;
+    SnapshotPtr snapshot;                 // 只通过 std::atomic_load/atomic_store 访问
+    mutable std::shared_mutex catalogMutex;
+    using TableLocks = std::map<std::string, std::shared_ptr<std::mutex>>;
+    TableLocks tableLocks;                // 受 catalogMutex 保护
+    std::mutex commitMutex;               // 发布新快照
+    std::atomic<size_t> tableMemoryLimit{0};
+    mutable std::atomic<uint64_t> accessClock{0};   // 表版本的访问计数，用于选出最久未访问的表
+    mutable std::atomic<uint64_t> nextVersionId{0};
+    mutable BufferPool bufferPool{DEFAULT_BUFFER_POOL_BYTES};
+    
+    // 加载表数据的线程池，第一次加载时创建：tablePool 中每个任务加载一张表，blockPool 中
+    // 并行解码数据块、重建各列的结构。分成两个池，等待块任务的表任务不会占满 blockPool
+    size_t loadThreads = 0;
+    mutable std::mutex loadPoolMutex;
+    mutable std::unique_ptr<ThreadPool> tablePool;
+    mutable std::unique_ptr<ThreadPool> blockPool;
+    // 返回加载用的线程池，单线程加载时返回 nullptr
+    ThreadPool* loadPool(bool tables) const;
+    
+    // 打开过的其他数据库（不含当前数据库）：切换回来时不重新读取，已加载的表数据也保留。
+    // 跨数据库引用（db.table）只读取，缓存中的数据库不会被修改。最多保留 OPEN_DATABASE_LIMIT 个，
+    // 超出时关闭最久未使用的；其中已加载的表数据与当前数据库的一起受内存上限约束
+    struct OpenDatabase {
+        SnapshotPtr snapshot;
+        TableLocks tableLocks;
+        uint64_t lastUse = 0;
+    };
+    static constexpr size_t OPEN_DATABASE_LIMIT = 8;
+    mutable std::mutex openDatabasesMutex;    // 保护 openDatabases；修改 currentDatabase 时同时持有
+    mutable std::map<std::string, OpenDatabase> openDatabases;
+    mutable uint64_t databaseClock = 0;
+    
+    // 延迟保存和自动备份：未保存的表和后台线程，autoSaveMutex 保护以下成员（加锁顺序在表锁之后）
+    std::mutex autoSaveMutex;
+    std::condition_variable autoSaveCondition;
+    std::chrono::milliseconds autoSaveInterval{0};
+    std::chrono::milliseconds autoBackupInterval{0};
+    std::string autoBackupPath;
+    std::set<std::string> dirtyTables;    // 当前数据库中有未写入表文件的版本的表
+    bool stopBackground = false;
+    std::mutex backgroundThreadMutex;     // 启动和停止后台线程
+    std::thread backgroundThread;
+    std::mutex backupMutex;               // 同时只进行一个备份
+    // 按设置停止或重新启动后台线程
+    void restartBackgroundThread();
+    void backgroundLoop();
+    // 写入未保存的表；调用者需持有 catalogMutex（共享或独占），不能持有表锁
+    void flushDirtyTables();
     
     bool loadFromFile();
-    bool saveToFile();
+    // 读取数据库目录中各表文件的列定义，目录不存在时返回 false
+    bool readCatalog(const std::string& database, std::map<std::string, TableVersionPtr>& catalog,
+                     TableLocks& locks) const;
+    // 切换到另一个数据库：当前数据库放入缓存，目标数据库从缓存中取出或从文件读取；
+    // 调用者需独占持有 catalogMutex
+    bool switchDatabase(const std::string& dbName);
+    // 数据库的快照：当前数据库返回当前快照，其他数据库从缓存中取出（未打开时打开），
+    // 数据库不存在时返回空
+    SnapshotPtr databaseSnapshot(const std::string& dbName) const;
+    // 调用者需持有 openDatabasesMutex
+    void trimOpenDatabases() const;
+    bool saveTableToFile(const std::string& tableName, const Table& table) const;
+    std::mutex& lockForTable(const std::string& tableName) const;
+    
+    // 写时复制修改一张表，mutator 返回 true 时提交新版本并保存该表
+    bool modifyTable(const std::string& tableName,
+                     const std::function<bool(Table&)>& mutator);
+    // 发布新版本，newVersion 为空表示删除该表；返回发布的版本
+    TableVersionPtr commitTable(const std::string& tableName,
+                                std::shared_ptr<const Table> newVersion);
+    void commitTables(std::map<std::string, TableVersionPtr> tables);
+    // 发布新版本并保存表文件，保存成功后这个版本可以被卸载；延迟保存模式下只标记为未保存
+    bool commitAndSave(const std::string& tableName, std::shared_ptr<const Table> newVersion);
+    // 已加载的表数据超出内存上限时卸载最久未访问的表；调用者不能持有 catalogMutex 或表锁
+    void evictColdTables() const;
     
+    // 查找表版本，表名可以带数据库名（db.table）；表不存在时返回空
+    TableVersionPtr findVersion(const Snapshot& snap, const std::string& tableName) const;
+    TableHandle findTable(const Snapshot& snap, const std::string& tableName) const;
+    // 大表的单表查询：不加载整张表，持有表锁按块经缓冲池扫描。表已加载、估计大小未超出
+    // 内存上限或版本已不是当前版本时返回 false，由调用者照常加载；调用者不能持有锁
+    bool selectByPages(const SQLParser::ParsedQuery& query, const TableVersion& version,
+                       QueryProfile* profile, std::vector<std::vector<std::string>>& result);
+    // 在线程池中同时加载多个表版本的数据
+    void loadTables(const std::vector<const TableVersion*>& versions) const;
+    
+    std::vector<std::vector<std::string>> selectFromSnapshot(
+        const SQLParser::ParsedQuery& query, const Snapshot& snap, QueryProfile* profile);
     std::vector<std::vector<std::string>> executeMultiTableSelect(
-        const SQLParser::ParsedQuery& query);
-    
-    std::vector<std::vector<std::string>> generateCartesianProduct(
-        const std::vector<const Table*>& tables);
-        
-    bool evaluateJoinCondition(
-        const std::vector<std::string>& row,
-        const std::string& condition,
-        const std::vector<std::string>& tableNames,
-        const std::vector<std::string>& tableAliases);
+        const SQLParser::ParsedQuery& query, const Snapshot& snap, QueryProfile* profile);
+    static void collectQueryTables(const SQLParser::ParsedQuery& query,
+                                   std::vector<std::string>& tableNames,
+                                   std::vector<std::string>& tableAliases);
+    // 多表查询的表和 WHERE/ON 条件交给连接计划器
+    JoinPlanner makeJoinPlanner(const SQLParser::ParsedQuery& query, const Snapshot& snap) const;
+    
+    // EXPLAIN: 只描述执行计划；EXPLAIN ANALYZE: 执行查询并返回各阶段统计
+    std::vector<std::vector<std::string>> explainSelect(
+        const SQLParser::ParsedQuery& query, const Snapshot& snap);
+    
+    // 查询统计与系统表
+    QueryStats queryStats;
+    void recordQuery(const SQLParser::ParsedQuery& query, QueryProfile::Clock::time_point start,
+                     size_t rowsExamined, size_t rowsReturned);
+    static bool isSystemTable(const std::string& tableName);
+    TableHandle buildSystemTable(const std::string& tableName) const;
+    SnapshotPtr withSystemTables(const SQLParser::ParsedQuery& query, SnapshotPtr snap) const;
 };
 
 #endif 
\ No newline at end of file
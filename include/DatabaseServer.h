@@ -0,0 +1,45 @@
+#ifndef DATABASESERVER_H
+#define DATABASESERVER_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include "DatabaseManager.h"
+#include "ThreadPool.h"
+
+// 通过 Unix 域套接字向本机多个客户端提供 SQL 服务
+// 每个连接是一个会话，由大小为 maxConnections 的工作线程池处理，
+// 所有会话共享同一个 DatabaseManager（同一份已加载的数据）
+class DatabaseServer {
+public:
+    DatabaseServer(DatabaseManager& dbManager,
+                   const std::string& socketPath,
+                   int maxConnections);
+    ~DatabaseServer();
+    
+    // 监听并接受连接，直到 stop() 被调用
+    void run();
+    void stop();
+    
+private:
+    DatabaseManager& dbManager;
+    std::string socketPath;
+    int maxConnections;
+    
+    std::atomic<int> listenFd{-1};
+    std::atomic<bool> running{false};
+    ThreadPool workers;
+    
+    std::mutex sessionMutex;
+    std::set<int> activeSessions;  // 用于 stop() 时中断阻塞中的会话
+    // 已接受的会话数（包括已提交、还未开始执行的），在接受连接时计数：每个会话在结束前
+    // 一直占用一个工作线程，达到 maxConnections 时新连接立即被拒绝，不在队列中等待
+    int sessionCount = 0;
+    
+    void serveSession(int clientFd);
+    void rejectConnection(int clientFd, const std::string& reason);
+};
+
+#endif
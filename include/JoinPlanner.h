@@ -0,0 +1,175 @@
+#ifndef JOINPLANNER_H
+#define JOINPLANNER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Table.h"
+#include "QueryProfile.h"
+
+// 多表查询的基于代价的连接计划
+//
+// WHERE 和内连接的 ON 条件按 AND 拆分为谓词：两张表的列之间的等值条件作为连接键，
+// 其他跨表谓词在所引用的表都连接之后求值。只引用一张表的谓词下推到该表的扫描，
+// 外连接中可能被补齐为 NULL 的表除外（这些谓词在全部连接完成后过滤）。
+// 下推前按等值条件推导传递的谓词，例如由 a.id = b.id AND a.id = 5 得到 b.id = 5，
+// 由 a.x = b.y AND b.y = c.z 得到 a.x = c.z。
+// 连接顺序为左深树：不超过 DP_TABLE_LIMIT 张表时用动态规划枚举，更多时贪心地每次
+// 加入代价最小的表，两者都尽量避免笛卡尔积。每一步按代价在哈希连接、索引嵌套循环、
+// 排序合并和嵌套循环中选择。含外连接的查询保持书写顺序，只选择每一步的连接算法。
+//
+// 哈希连接只有一个连接键、两侧的列都有字典编码时按编码匹配，不再对每行的值求哈希。
+// 连接键所在的列有布隆过滤器时，键值不在过滤器中的已连接行不参与匹配；
+// 内连接和左外连接中所有行都被排除时不再读取新表。
+//
+// 谓词按列的类型比较（Table::compareValues，与单表的连接和排序相同）：两侧都是列时按左侧列的
+// 类型，列与字面值比较时按列的类型，数值列上 "9" < "10"、"1" = "01"。数值键的哈希和排序合并
+// 按规范化后的值匹配；索引、字典编码、布隆过滤器和下推扫描时的区域映射按存储的文本精确匹配，
+// 只用于非数值类型。条件中不支持 OR 和括号，未加引号的字面值必须是数字。
+//
+// 行数估计使用表统计信息（ANALYZE）中的不同值个数；未分析的表按主键唯一、
+// 其他列最多 DEFAULT_DISTINCT 个不同值估算。
+class JoinPlanner {
+public:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+    static constexpr size_t DP_TABLE_LIMIT = 10;
+    static constexpr size_t MAX_TABLES = 64;
+    static constexpr double DEFAULT_DISTINCT = 200;
+
+    enum class Method {
+        NESTED_LOOP,
+        HASH,
+        INDEX_NESTED_LOOP,
+        SORT_MERGE
+    };
+
+    struct Relation {
+        std::string name;
+        std::string alias;
+        std::shared_ptr<const Table> table;   // 计划和执行期间持有，表不会被卸载
+        JoinType joinType = JoinType::INNER;   // 与之前各表的连接方式
+    };
+
+    // 谓词的一侧：列引用或字面值
+    struct Operand {
+        bool isColumn = false;
+        size_t relation = 0;
+        size_t column = 0;
+        std::string literal;
+        std::string text;            // 原始表达式
+    };
+
+    struct Predicate {
+        std::string text;
+        std::string op;
+        Operand left;
+        Operand right;
+        std::string type;            // 比较使用的列类型，两侧都是字面值时为 TEXT
+        uint64_t relations = 0;      // 引用的表（位掩码）
+        size_t onRelation = NONE;    // 外连接 ON 条件所属的表，WHERE 和内连接条件为 NONE
+        size_t equivalence = NONE;   // 两列相等的谓词所属的等价类
+        bool derived = false;        // 由传递关系推导，不影响结果，只用于下推和选择连接顺序
+        bool pushedDown = false;     // 在表扫描时求值
+    };
+
+    // 左深计划中的一步：把一张表连接到之前的结果上
+    struct Step {
+        size_t relation = 0;
+        JoinType joinType = JoinType::INNER;
+        Method method = Method::NESTED_LOOP;
+        std::vector<size_t> keys;        // 作为连接键的等值谓词
+        std::vector<size_t> conditions;  // 匹配时求值的其他谓词
+        std::vector<size_t> filters;     // 外连接补齐之后才能求值的 WHERE 谓词
+        bool buildLeft = false;          // 哈希连接在已连接的结果上建表
+        size_t indexKey = 0;             // 索引嵌套循环使用的连接键
+        double rows = 0;                 // 估计输出行数
+        double cost = 0;                 // 到本步为止的累计代价
+    };
+
+    struct Plan {
+        size_t first = 0;                // 最先读取的表
+        std::vector<Step> steps;
+        std::vector<size_t> finalFilters;
+        double rows = 0;
+        double cost = 0;
+        std::string strategy;            // 动态规划、贪心或书写顺序
+    };
+
+    using Row = TableRow;
+
+    // 连接结果中的一行：各表中一行的指针（与 relations 顺序相同），外连接补齐的一侧为 nullptr
+    using Tuple = std::vector<const Row*>;
+
+    explicit JoinPlanner(std::vector<Relation> relations);
+
+    // 按 AND 拆分条件并解析为谓词，onRelation 为外连接 ON 条件所属的表
+    void addConditions(const std::string& clause, size_t onRelation = NONE);
+
+    // 第一次调用时推导传递谓词并把单表谓词下推到扫描
+    Plan optimize();
+    std::vector<Tuple> execute(const Plan& plan, QueryProfile* profile) const;
+
+    // 查找 [别名.]列名，没有别名时取第一张包含该列的表
+    bool resolveColumn(const std::string& expr, size_t& relation, size_t& column) const;
+
+    const std::vector<Relation>& getRelations() const { return relations; }
+    // 应用下推的谓词之后表的估计行数
+    double scanRows(size_t relation) const { return baseRows[relation]; }
+
+    // EXPLAIN 中的说明文字
+    static const char* methodName(Method method);
+    std::string describeScan(size_t relation) const;
+    std::string describeStep(const Step& step) const;
+    std::string describeOrder(const Plan& plan) const;
+    std::string describePredicates(const std::vector<size_t>& indices) const;
+
+private:
+    struct State {
+        bool valid = false;
+        size_t first = 0;
+        uint64_t joined = 0;
+        double rows = 0;
+        double cost = 0;
+        std::vector<Step> steps;
+        std::vector<Operand> sortedOn;   // 结果按这些列（等价）有序
+    };
+
+    std::vector<Relation> relations;
+    std::vector<Predicate> predicates;
+    std::vector<double> tableRows;
+    std::vector<double> baseRows;                    // 下推过滤之后的估计行数
+    std::vector<std::vector<size_t>> scanFilters;    // 每张表扫描时求值的谓词
+    bool rewritten = false;
+
+    Operand parseOperand(const std::string& expr) const;
+    std::string columnText(const Operand& operand) const;
+    std::string comparisonType(const Predicate& pred) const;
+    uint64_t nullableRelations() const;
+    void deriveTransitivePredicates(uint64_t nullable);
+    void pushDownPredicates();
+    bool isEquiJoin(const Predicate& pred) const;
+    bool connected(uint64_t joined, size_t relation) const;
+    double distinctValues(const Operand& operand) const;
+    double selectivity(const Predicate& pred) const;
+
+    State initialState(size_t relation) const;
+    State extend(const State& state, size_t relation, JoinType joinType) const;
+    Plan finish(const State& state, const std::string& strategy) const;
+    Plan orderByDynamicProgramming() const;
+    Plan orderGreedily() const;
+    Plan orderAsWritten() const;
+
+    static const std::string* operandValue(const Operand& operand, const Tuple& tuple);
+    bool evaluate(const Predicate& pred, const Tuple& tuple) const;
+    bool passesScanFilters(size_t relation, const Row& row, Tuple& scratch) const;
+    bool joinedKey(const Step& step, const Tuple& tuple, std::string& key) const;
+    std::string newKey(const Step& step, const Row& row) const;
+    std::vector<size_t> bloomKeys(const Step& step) const;
+    bool encodedKey(const Step& step, const ColumnDictionary*& joined, const ColumnDictionary*& added) const;
+    bool rejectedByBloom(const Step& step, const std::vector<size_t>& keys, const Tuple& tuple) const;
+    std::vector<Tuple> joinStep(std::vector<Tuple> left, const Step& step,
+                                const std::vector<const Row*>& rightRows, size_t& examined) const;
+};
+
+#endif
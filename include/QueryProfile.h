@@ -0,0 +1,89 @@
+#ifndef QUERYPROFILE_H
+#define QUERYPROFILE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+// EXPLAIN ANALYZE 的分阶段统计
+// 执行器在各阶段结束时调用 addStage()，未请求统计时传入 nullptr，不产生额外开销
+// 查询统计只需要扫描行数，可以关闭内存估算（估算需要遍历中间结果）
+class QueryProfile {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Rows = std::vector<std::vector<std::string>>;
+
+    struct Stage {
+        std::string operation;    // 操作，例如 "全表扫描"
+        std::string detail;       // 访问路径、条件等说明
+        size_t rowsIn = 0;
+        size_t rowsOut = 0;
+        double elapsedMs = 0;
+        size_t memoryBytes = 0;   // 阶段输出的中间结果占用的内存（估算）
+    };
+
+    explicit QueryProfile(bool estimateMemory = true) : estimateMemory(estimateMemory) {}
+
+    static Clock::time_point now() { return Clock::now(); }
+
+    // 记录从 start 到现在的一个阶段，output 为该阶段物化的中间结果
+    void addStage(const std::string& operation, const std::string& detail,
+                  size_t rowsIn, size_t rowsOut, Clock::time_point start,
+                  const Rows* output = nullptr) {
+        Stage stage;
+        stage.operation = operation;
+        stage.detail = detail;
+        stage.rowsIn = rowsIn;
+        stage.rowsOut = rowsOut;
+        stage.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        stage.memoryBytes = (output && estimateMemory) ? estimateBytes(*output) : 0;
+        stages.push_back(stage);
+    }
+
+    // 记录一个已经计好时的阶段（例如解析）
+    void addStage(const Stage& stage) { stages.push_back(stage); }
+
+    const std::vector<Stage>& getStages() const { return stages; }
+
+    // 执行器实际检查过的行数（被扫描或参与条件判断的行）
+    void addRowsExamined(size_t rows) { rowsExamined += rows; }
+    size_t getRowsExamined() const { return rowsExamined; }
+
+    double totalMs() const {
+        double total = 0;
+        for (const auto& stage : stages) {
+            total += stage.elapsedMs;
+        }
+        return total;
+    }
+
+    size_t peakMemoryBytes() const {
+        size_t peak = 0;
+        for (const auto& stage : stages) {
+            peak = std::max(peak, stage.memoryBytes);
+        }
+        return peak;
+    }
+
+    static size_t estimateBytes(const Rows& rows) {
+        size_t bytes = rows.capacity() * sizeof(std::vector<std::string>);
+        for (const auto& row : rows) {
+            bytes += row.capacity() * sizeof(std::string);
+            for (const auto& value : row) {
+                // 短字符串存放在对象内部，不另外分配
+                if (value.capacity() >= sizeof(std::string)) {
+                    bytes += value.capacity() + 1;
+                }
+            }
+        }
+        return bytes;
+    }
+
+private:
+    bool estimateMemory;
+    size_t rowsExamined = 0;
+    std::vector<Stage> stages;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef QUERYSTATS_H
+#define QUERYSTATS_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// 查询统计注册表和慢查询日志
+//
+// 语句先归一化为指纹（字面量替换为 ?，关键字大写，空白合并），
+// 同一指纹的语句累计调用次数、耗时和行数。耗时分布记录在对数直方图中，
+// 用于估算 p99，内存占用与调用次数无关。
+class QueryStats {
+public:
+    struct Entry {
+        std::string fingerprint;
+        uint64_t calls = 0;
+        double totalMs = 0;
+        double meanMs = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+        uint64_t rowsExamined = 0;
+        uint64_t rowsReturned = 0;
+    };
+
+    static std::string fingerprint(const std::string& sql);
+
+    void record(const std::string& sql, double elapsedMs,
+                uint64_t rowsExamined, uint64_t rowsReturned);
+
+    // 按总耗时降序
+    std::vector<Entry> getEntries() const;
+
+    // 超过阈值（毫秒）的语句写入慢查询日志，小于 0 时关闭
+    void setSlowQueryThreshold(double ms);
+    double getSlowQueryThreshold() const;
+    void setSlowLogPath(const std::string& path);
+
+private:
+    static constexpr size_t HISTOGRAM_BUCKETS = 256;
+    static constexpr size_t MAX_FINGERPRINTS = 1000;  // 超出后的新指纹合并计入 "<其他>"
+
+    struct Accumulator {
+        Entry entry;
+        std::vector<uint32_t> histogram = std::vector<uint32_t>(HISTOGRAM_BUCKETS, 0);
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Accumulator> accumulators;
+    double slowQueryThreshold = 100;
+    std::string slowLogPath;
+
+    std::mutex logMutex;
+
+    static size_t bucketFor(double ms);
+    static double bucketUpperBound(size_t bucket);
+    void writeSlowLog(const std::string& path, const std::string& sql, double elapsedMs,
+                      uint64_t rowsExamined, uint64_t rowsReturned);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef ROWSTORE_H
+#define ROWSTORE_H
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "forward_declarations.h"
+
+// 表的行存储：行数组和每行的 vector 从表自己的内存池中按块顺序分配（单调缓冲区，
+// 分配只移动指针），不再每行单独向堆申请。删除的行占用的内存不单独归还，表被销毁或
+// 替换（DROP、重新加载）时整块释放。
+//
+// 复制时按源表的大小一次申请内存池，逐行复制进去。MVCC 修改的是表的副本，所以每次
+// 修改都顺带去掉了之前删除的行留下的空洞。
+// 超过短字符串长度的值仍由 std::string 自己在堆上分配。
+class RowStore {
+public:
+    RowStore();
+    RowStore(const RowStore& other);
+    RowStore(RowStore&& other);
+    RowStore& operator=(const RowStore& other);
+    RowStore& operator=(RowStore&& other);
+
+    const TableRows& rows() const { return storage->rows; }
+
+    size_t size() const { return storage->rows.size(); }
+    bool empty() const { return storage->rows.empty(); }
+    TableRow& operator[](size_t i) { return storage->rows[i]; }
+    const TableRow& operator[](size_t i) const { return storage->rows[i]; }
+    TableRows::iterator begin() { return storage->rows.begin(); }
+    TableRows::iterator end() { return storage->rows.end(); }
+    TableRows::const_iterator begin() const { return storage->rows.begin(); }
+    TableRows::const_iterator end() const { return storage->rows.end(); }
+
+    // 追加一行（复制或移入值）
+    void push_back(const std::vector<std::string>& values);
+    void push_back(std::vector<std::string>&& values);
+    void erase(TableRows::iterator pos) { storage->rows.erase(pos); }
+
+    // 预计还要追加 rowCount 行、每行 columnCount 个值；表为空时按这个大小重新申请内存池
+    void reserve(size_t rowCount, size_t columnCount);
+
+    // 行和值占用的内存（估算，包括超过短字符串长度的值），需要遍历全部行
+    size_t memoryBytes() const;
+
+private:
+    struct Storage {
+        explicit Storage(size_t initialBytes) : arena(initialBytes) {}
+        // 内存池先于行构造、后于行销毁
+        std::pmr::monotonic_buffer_resource arena;
+        TableRows rows{&arena};
+    };
+
+    static constexpr size_t INITIAL_BYTES = 4096;
+    static size_t bytesFor(size_t rowCount, size_t columnCount);
+
+    std::unique_ptr<Storage> storage;
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cctype>
 #include "forward_declarations.h"
 
 namespace SQLParser {
@@ -11,7 +13,8 @@ enum class JoinType {
     NONE,
     INNER,
     LEFT,
-    RIGHT
+    RIGHT,
+    FULL
 };
 
 enum class AggregateFunction {
@@ -30,6 +33,7 @@ struct Column {
     std::string type;
     bool nullable = true;
     bool primaryKey = false;
+    bool bloomFilter = false;
     bool isForeignKey = false;
     std::string referenceTable;
     std::string referenceColumn;
@@ -38,6 +42,7 @@ struct Column {
 };
 
 struct ParsedQuery {
+    std::string sql;             // 原始语句（去掉末尾分号），用于查询统计
     std::string type;
     std::string tableName;
     std::string tableAlias;      // 主表别名
@@ -54,9 +59,19 @@ struct ParsedQuery {
     bool orderDesc = false;
     int limit = -1;
     
-    // 连接查询
+    // 连接查询（FROM 中逗号分隔的多张表保存在 tableName 中，例如 "A a, B b"）
     std::vector<std::string> joinTables;
-    std::vector<std::string> joinConditions;
+    std::vector<std::string> joinTableAliases;   // 未指定别名时为空
+    std::vector<JoinType> joinTypes;
+    std::vector<std::string> joinConditions;     // ON 条件，CROSS JOIN 为空
+    
+    // ALTER TABLE 的操作（"ADD BLOOM FILTER" / "DROP BLOOM FILTER"），涉及的列在 columns 中
+    std::string alterAction;
+    
+    // EXPLAIN / EXPLAIN ANALYZE
+    bool explain = false;
+    bool explainAnalyze = false;
+    double parseTimeMs = 0;      // 解析耗时，仅 EXPLAIN ANALYZE 时记录
 };
 
 class SQLParser {
@@ -66,12 +81,16 @@ public:
     
 private:
     ParsedQuery parseSelect(const std::string& sql);
+    ParsedQuery parseExplain(const std::string& sql);
     ParsedQuery parseCreate(const std::string& sql);
     ParsedQuery parseInsert(const std::string& sql);
     ParsedQuery parseUpdate(const std::string& sql);
     ParsedQuery parseDelete(const std::string& sql);
     ParsedQuery parseDrop(const std::string& sql);
+    ParsedQuery parseAnalyze(const std::string& sql);
+    ParsedQuery parseAlter(const std::string& sql);
     std::vector<Column> parseColumns(const std::string& columnsStr);
+    void parseFrom(const std::string& fromStr, ParsedQuery& query);
     
     // 辅助方法
     static size_t findKeyword(const std::string& sql, const std::string& keyword, size_t startPos = 0) {
@@ -82,6 +101,23 @@ private:
         return upperSql.find(upperKeyword, startPos);
     }
     
+    // 只匹配独立的单词（前后不是字母、数字或下划线），例如表名 JoinStudents 中的 JOIN 不算
+    static size_t findKeywordToken(const std::string& sql, const std::string& keyword, size_t startPos = 0) {
+        auto isWordChar = [](char c) {
+            unsigned char u = static_cast<unsigned char>(c);
+            return std::isalnum(u) || c == '_' || u >= 0x80;
+        };
+        size_t pos = findKeyword(sql, keyword, startPos);
+        while (pos != std::string::npos) {
+            size_t end = pos + keyword.length();
+            if ((pos == 0 || !isWordChar(sql[pos - 1])) && (end >= sql.length() || !isWordChar(sql[end]))) {
+                return pos;
+            }
+            pos = findKeyword(sql, keyword, pos + 1);
+        }
+        return pos;
+    }
+    
     static std::string trim(const std::string& str) {
         size_t first = str.find_first_not_of(" \t\n\r");
         if (first == std::string::npos) return "";
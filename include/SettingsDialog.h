@@ -65,6 +65,9 @@ private:
     // 性能设置
     QSpinBox* maxConnectionsBox;
     QSpinBox* queryTimeoutBox;
+    QSpinBox* slowQueryThresholdBox;
+    QSpinBox* tableMemoryBox;
+    QSpinBox* bufferPoolBox;
     QComboBox* encodingCombo;
     QCheckBox* useTransactionsCheck;
     
@@ -8,6 +8,14 @@
 #include <sstream>
 #include "forward_declarations.h"
 #include "SQLParser.h"
+#include "TableStats.h"
+#include "ZoneMap.h"
+#include "BloomFilter.h"
+#include "ColumnDictionary.h"
+#include "RowStore.h"
+
+class QueryProfile;
+class ThreadPool;
 
 // 前向声明
 enum class JoinType {
@@ -18,6 +26,17 @@ enum class JoinType {
     FULL
 };
 
+// 两表连接的算法
+enum class JoinMethod {
+    AUTO,               // 两侧连接列都有字典编码时按编码连接；文本键且右表连接列有索引时索引嵌套循环；
+                        // 左表也有索引或数据量较大时排序合并，否则嵌套循环
+    NESTED_LOOP,
+    SORT_MERGE,
+    INDEX_NESTED_LOOP,  // 每个左表行在右表连接列的索引中查找（按存储的文本精确匹配，只用于文本键，
+                        // 数值键改为排序合并）
+    DICTIONARY          // 右表的编码转换为左表字典的编码后按编码分组（文本列，按存储的文本精确匹配）
+};
+
 // 条件结构
 struct Condition {
     std::string column;
@@ -32,32 +51,50 @@ public:
     
     // 基本操作
     bool insertRow(const std::vector<std::string>& values);
+    bool insertRow(std::vector<std::string>&& values);   // 值移入表的行存储
+    // 加载前预留 rowCount 行的空间
+    void reserveRows(size_t rowCount) { data.reserve(rowCount, columns.size()); }
+    // 批量加载：先用 checkRow() 检查各行的列数、类型和非空约束（不满足时抛出异常；不修改表，
+    // 可以在多个线程中同时调用），再按顺序 appendRows()，追加时不维护索引等结构，
+    // 全部追加后调用一次 rebuildStructures()
+    void checkRow(const std::vector<std::string>& values) const;
+    void appendRows(std::vector<std::vector<std::string>>& rows);   // 值移入行存储
+    // 重建索引、区域映射、布隆过滤器和字典编码；给出 pool 时区域映射和各列的布隆过滤器、
+    // 字典编码在线程池中并行重建
+    void rebuildStructures(ThreadPool* pool = nullptr);
     std::vector<std::vector<std::string>> select(
         const std::vector<std::string>& columns,
         const std::string& whereClause = "",
         const std::string& orderByColumn = "",
-        bool orderDesc = false) const;
+        bool orderDesc = false,
+        QueryProfile* profile = nullptr) const;
     bool updateRows(
         const std::vector<std::string>& columns,
         const std::vector<std::string>& values,
         const std::string& whereClause = "");
     bool deleteRows(const std::string& whereClause);
     
-    // JOIN操作
+    // JOIN操作：连接键按左表列的类型比较（compareValues），空值不参与匹配，
+    // 外连接未匹配的一侧补 "NULL"
     std::vector<std::vector<std::string>> join(
         const Table& otherTable,
         const std::string& leftCol,
         const std::string& rightCol,
-        JoinType joinType = JoinType::INNER);
+        JoinType joinType = JoinType::INNER,
+        JoinMethod method = JoinMethod::AUTO) const;
     
     // 索引操作
     bool createIndex(const std::string& columnName);
     bool dropIndex(const std::string& columnName);
+    // 列上的索引（值 -> 行号，按值的字典序），没有索引时返回 nullptr
+    const std::map<std::string, std::set<size_t>>* getIndex(const std::string& columnName) const;
     
     // Getter方法
     const std::vector<ColumnDef>& getColumns() const { return columns; }
-    const std::vector<std::vector<std::string>>& getData() const { return data; }
+    const TableRows& getData() const { return data.rows(); }
     const std::string& getName() const { return name; }
+    // 行数据占用的内存（估算）
+    size_t memoryBytes() const { return data.memoryBytes(); }
     
     // 添加新的查询方法
     std::vector<std::vector<std::string>> selectWithGroupBy(
@@ -75,20 +112,75 @@ public:
         const std::vector<SQLParser::Column>& columns,
         const std::string& whereClause,
         const std::vector<std::string>& groupByColumns,
-        const std::string& havingClause) const;
+        const std::string& havingClause,
+        QueryProfile* profile = nullptr) const;
+    
+    // EXPLAIN 中各阶段的说明文字
+    std::string describeScan(const std::string& whereClause) const;
+    std::string describeSkipped(size_t examined) const;
+    static std::string describeSort(const std::string& orderByColumn, bool desc);
+    static std::string describeAggregates(
+        const std::vector<SQLParser::Column>& columns,
+        const std::vector<std::string>& groupByColumns,
+        const std::string& havingClause);
+    
+    // 统计信息（ANALYZE），插入时增量维护
+    void analyze();
+    const TableStats& getStats() const { return stats; }
+    void setStats(TableStats newStats) { stats = std::move(newStats); }
+    // 按统计信息估算满足 WHERE 条件的行数（各条件视为相互独立），未 ANALYZE 时返回总行数
+    double estimateRows(const std::string& whereClause) const;
+    
+    // 布隆过滤器（CREATE TABLE 中的 BLOOM 或 ALTER TABLE ... ADD BLOOM FILTER）
+    void setBloomFilter(const std::string& columnName, bool enabled);
+    bool hasBloomFilter(const std::string& columnName) const;
+    // 列中是否可能有等于 value 的值，没有布隆过滤器时返回 true
+    bool mayContain(const std::string& columnName, const std::string& value) const;
+    
+    // 文本列的字典编码，列没有启用字典编码时返回 nullptr
+    const ColumnDictionary* getDictionary(size_t column) const;
+    
+    // 按 AND 拆分 WHERE 条件（与单表查询的求值规则相同）
+    std::vector<Condition> splitConditions(const std::string& whereClause) const;
+    // 按区域映射和布隆过滤器跳过不可能满足条件的块后，需要检查的行号区间 [begin, end)
+    std::vector<std::pair<size_t, size_t>> candidateRanges(const std::vector<Condition>& conditions) const;
+    
+    // 按列类型比较，空值排在前面
+    static bool compareValues(const std::string& a, const std::string& b,
+                            const std::string& type);
         
 private:
     std::string name;
     std::vector<ColumnDef> columns;
-    std::vector<std::vector<std::string>> data;
+    RowStore data;
     std::map<std::string, std::map<std::string, std::set<size_t>>> indices;
+    TableStats stats;
+    ZoneMap zoneMap;
+    std::map<size_t, ColumnBloomFilter> bloomFilters;   // 列位置 -> 布隆过滤器
+    std::map<size_t, ColumnDictionary> dictionaries;    // 文本列位置 -> 字典编码
+    
+    // 扫描前解析好的条件：列位置，以及字典编码列上 = 和 != 比较的值的编码
+    struct BoundCondition {
+        const Condition* condition;
+        size_t column;                                  // 列不存在时为 npos，求值时报错
+        const ColumnDictionary* dictionary;
+        uint32_t code;
+    };
 
     // 辅助方法
-    bool validateDataType(const std::string& value, const std::string& type);
-    bool evaluateCondition(const std::vector<std::string>& row, const std::string& whereClause) const;
+    static bool validateDataType(const std::string& value, const std::string& type);
+    bool evaluateCondition(const TableRow& row, const std::string& whereClause) const;
+    bool evaluateCondition(const TableRow& row, const std::vector<Condition>& conditions) const;
+    std::vector<BoundCondition> bindConditions(const std::vector<Condition>& conditions) const;
+    bool evaluateCondition(size_t rowIndex, const std::vector<BoundCondition>& conditions) const;
     std::vector<Condition> parseWhereClause(const std::string& whereClause) const;
     bool evaluateSingleCondition(const std::string& value, const Condition& cond) const;
-    void updateIndices(size_t rowIndex, const std::vector<std::string>& values);
+    void updateIndices(size_t rowIndex, const TableRow& values);
+    // 新行已追加到 data 末尾后，维护索引、统计信息、区域映射、布隆过滤器和字典编码
+    void addedRow(size_t rowIndex);
+    // 按列排序的行号；有索引时按索引分组，只对不同的值排序
+    std::vector<size_t> sortedRowIds(size_t colIndex, const std::string& type) const;
+    static constexpr size_t NESTED_LOOP_JOIN_LIMIT = 4096;  // AUTO 时两表行数乘积的上限
     void removeFromIndices(size_t rowIndex);
     
     // 添加新的辅助方法
@@ -105,10 +197,6 @@ private:
                  const std::string& orderByColumn,
                  bool desc) const;
     
-    // 添加比较辅助方法
-    static bool compareValues(const std::string& a, const std::string& b,
-                            const std::string& type);
-    
     // 添加辅助方法
     static std::string trim(const std::string& str) {
         size_t first = str.find_first_not_of(" \t\n\r");
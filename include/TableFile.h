@@ -0,0 +1,83 @@
+#ifndef TABLEFILE_H
+#define TABLEFILE_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include "forward_declarations.h"
+
+// 表文件（<表名>.tbl）：按列分块存储，每块每列独立选择压缩编码
+//
+//   文件头: "DBMSTBL1" | 版本 | 头部字节数 | 头部 | CRC32C
+//   头部:   列数 | 每列: 列名 类型 标志位(可空/主键/布隆过滤器) | 行数 | 块数
+//   每块:   块字节数 | 行数 | 每列: 编码 | 数据字节数 | 数据 | CRC32C
+// 整数为 LEB128 变长编码，字符串为长度 + 字节，CRC32C 为 4 字节小端序，覆盖头部或块的内容。
+// 每块 BLOCK_ROWS 行，与区域映射的分块一致。读取时校验每一块，校验和不匹配时抛出异常；
+// 版本 1 的文件没有头部字节数和校验和，仍然可以读取，下次保存时转换。
+//
+// 写入时对每块的每列统计一遍（行程数、不同值、整数的范围和相邻差值的范围），按估算的
+// 大小选择最小的编码：
+//   PLAIN               逐个保存值
+//   RLE                 相同值的连续行程，适合有序或大量重复的列
+//   DICTIONARY          不同值的字典 + 按位打包的编码
+//   DELTA               INTEGER：首个值 + 相邻差值减去最小差值后按位打包
+//   FRAME_OF_REFERENCE  INTEGER：值减去块内最小值后按位打包
+// 整数编码要求块内的值都是规范写法的整数（如 "42"、"-7"），空值（NULL）另存位图；
+// 其他写法（"007"、"+5"）保存为文本编码，读出的值与写入时完全相同。
+namespace TableFile {
+
+enum class Codec : uint8_t {
+    PLAIN = 0,
+    RLE = 1,
+    DICTIONARY = 2,
+    DELTA = 3,
+    FRAME_OF_REFERENCE = 4
+};
+
+constexpr size_t BLOCK_ROWS = 1024;
+
+const char* codecName(Codec codec);
+
+// 为一列值选择编码并编码，返回编码后的数据
+std::string encodeColumn(const std::vector<const std::string*>& values, const std::string& type, Codec& codec);
+// 解码 count 个值，追加到 values
+void decodeColumn(Codec codec, const std::string& payload, size_t count, std::vector<std::string>& values);
+
+void write(std::ostream& out, const std::vector<ColumnDef>& columns,
+           const TableRows& data);
+
+// 按块读取，每次解码一块得到一批行
+class Reader {
+public:
+    // 读取并检查文件头，格式不对或校验和不匹配时抛出异常
+    explicit Reader(std::istream& in);
+
+    const std::vector<ColumnDef>& getColumns() const { return columns; }
+    uint64_t getRowCount() const { return rowCount; }
+    uint64_t getBlockCount() const { return blockCount; }
+
+    // 解码下一块，rows 被替换为这一块的行；没有更多的块时返回 false
+    bool nextBlock(std::vector<std::vector<std::string>>& rows);
+
+    // 分开读取和解码，以便多个线程同时解码不同的块：readBlock() 按顺序读出下一块的
+    // 原始字节并校验，decodeBlock() 不修改 Reader，可以并发调用
+    bool readBlock(std::string& block);
+    // 跳过下一块（它已在缓冲池中）
+    bool skipBlock();
+    void decodeBlock(const std::string& block, std::vector<std::vector<std::string>>& rows) const;
+
+private:
+    std::istream& in;
+    std::vector<ColumnDef> columns;
+    uint64_t rowCount = 0;
+    uint64_t blockCount = 0;
+    uint64_t blocksRead = 0;
+    bool checksummed = true;
+
+    void readHeader(std::istream& headerIn);
+};
+
+} // namespace TableFile
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef TABLESTATS_H
+#define TABLESTATS_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include "forward_declarations.h"
+
+// HyperLogLog 基数估计，1024 个寄存器，标准误差约 3%
+class HyperLogLog {
+public:
+    static constexpr int PRECISION = 10;
+    static constexpr size_t REGISTERS = size_t(1) << PRECISION;
+
+    HyperLogLog() : registers(REGISTERS, 0) {}
+
+    void add(const std::string& value);
+    double estimate() const;
+
+    // 持久化为十六进制字符串
+    std::string toHex() const;
+    bool fromHex(const std::string& hex);
+
+private:
+    std::vector<uint8_t> registers;
+};
+
+// 单列统计信息，空字符串视为 NULL
+struct ColumnStats {
+    std::string name;
+    std::string type;
+    uint64_t nullCount = 0;
+    HyperLogLog distinct;
+    std::string minValue;                  // 非空值中的最小值、最大值
+    std::string maxValue;
+    // 等深直方图：第 i 个桶包含 (上一个桶的上界, bucketBounds[i]] 之间的值
+    std::vector<std::string> bucketBounds;
+    std::vector<uint64_t> bucketCounts;
+};
+
+// 表统计信息，用于估算谓词选择率和连接基数
+//
+// ANALYZE 全量计算；之后插入的行增量计入行数、NULL 数、基数估计、最值和直方图，
+// 更新和删除只调整行数并累计修改行数，分布的变化要等下一次 ANALYZE。
+class TableStats {
+public:
+    static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+    static TableStats compute(const std::vector<ColumnDef>& columns,
+                              const TableRows& data);
+
+    // 未执行过 ANALYZE 时没有统计信息，插入等操作也不会维护
+    bool isAnalyzed() const { return analyzed; }
+
+    void addRow(const TableRow& row);
+    void removeRows(uint64_t count);
+    void recordModification(uint64_t count);
+
+    uint64_t getRowCount() const { return rowCount; }
+    uint64_t getModifiedRows() const { return modifiedRows; }
+    const std::vector<ColumnStats>& getColumns() const { return columns; }
+
+    // 列的不同值个数估计（不超过非空行数）
+    uint64_t estimateDistinct(size_t column) const;
+    // 估算 "列 op 值" 的选择率，op 为 =, !=, <, <=, >, >=，无法估算时返回 1
+    double estimateSelectivity(size_t column, const std::string& op, const std::string& value) const;
+
+    // 与表文件放在一起的 .stats 文件，列与表定义不一致时加载失败
+    void save(std::ostream& out) const;
+    bool load(std::istream& in, const std::vector<ColumnDef>& tableColumns);
+
+private:
+    bool analyzed = false;
+    uint64_t rowCount = 0;
+    uint64_t modifiedRows = 0;   // 上次 ANALYZE 之后更新和删除的行数
+    std::vector<ColumnStats> columns;
+
+    double nonNullFraction(const ColumnStats& stats) const;
+    double equalFraction(size_t column, const std::string& value) const;
+    static double fractionBelow(const ColumnStats& stats, const std::string& value);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+// 固定大小的工作线程池
+class ThreadPool {
+public:
+    // queueCapacity 为 0 表示不限制等待队列的长度
+    explicit ThreadPool(size_t threadCount, size_t queueCapacity = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // 提交任务，队列已满或线程池已关闭时返回 false
+    bool submit(std::function<void()> task);
+    
+    // 提交任务并返回它的结果（异常也经由 future 传回）；队列已满或线程池已关闭时
+    // 在调用线程中直接执行
+    template <typename F>
+    auto async(F task) -> std::future<decltype(task())> {
+        auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+        auto result = packaged->get_future();
+        if (!submit([packaged]() { (*packaged)(); })) {
+            (*packaged)();
+        }
+        return result;
+    }
+    
+    // 停止接收新任务，等待已提交的任务执行完毕
+    void shutdown();
+    
+    size_t size() const { return workers.size(); }
+    
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    size_t queueCapacity;
+    bool stopping = false;
+    
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    
+    void workerLoop();
+};
+
+#endif
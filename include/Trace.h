@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// 查询执行追踪，导出为 Chrome trace-event JSON（可在 chrome://tracing 或 Perfetto 中查看）
+//
+// 用法: TRACE_SCOPE("Table::select", "scan"); 在作用域结束时记录一个完整事件。
+// 关闭时每个追踪点只有一次对全局开关的读取和分支；开启后事件写入当前线程自己的
+// 环形缓冲区，记录路径上没有锁，缓冲区满时覆盖最旧的事件。
+namespace Trace {
+
+extern std::atomic<bool> enabledFlag;
+
+inline bool enabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+// 清空已有事件并开始记录
+void start();
+// 停止记录。导出前应先停止，避免导出时仍有线程写入
+void stop();
+// 写出所有线程缓冲区中的事件，失败时返回 false
+bool writeChromeTrace(const std::string& path);
+
+uint64_t nowNs();
+void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs,
+            const std::string* detail);
+
+class Span {
+public:
+    Span(const char* name, const char* category)
+        : name(name), category(category), startNs(enabled() ? nowNs() : 0) {}
+
+    // detail 只在追踪开启时复制（例如表名、SQL 语句）
+    Span(const char* name, const char* category, const std::string& detail)
+        : name(name), category(category), detail(&detail), startNs(enabled() ? nowNs() : 0) {}
+
+    ~Span() {
+        if (startNs != 0) {
+            record(name, category, startNs, nowNs(), detail);
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    const std::string* detail = nullptr;
+    uint64_t startNs;
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(...) Trace::Span TRACE_CONCAT(traceSpan_, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef WIREPROTOCOL_H
+#define WIREPROTOCOL_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 本地服务器的二进制协议
+//
+// 每个消息为一帧: uint32 长度（网络字节序，含类型字节） | uint8 类型 | 负载
+//   QUERY  (客户端): SQL 文本
+//   PING   (客户端): 空
+//   OK     (服务端): 空，非查询语句执行成功
+//   RESULT (服务端): uint32 列数 | 列名... | uint32 行数 | 单元格...
+//                    每个字符串编码为 uint32 长度 + UTF-8 字节
+//   ERROR  (服务端): 错误信息
+namespace WireProtocol {
+
+enum class MessageType : uint8_t {
+    QUERY = 0x01,
+    PING = 0x02,
+    OK = 0x80,
+    RESULT = 0x81,
+    ERROR = 0x82
+};
+
+struct Message {
+    MessageType type = MessageType::PING;
+    std::string payload;
+};
+
+// 单帧大小上限，防止异常的长度字段耗尽内存
+constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+// 读取一帧，对端正常关闭时返回 false，出错时抛出异常
+bool readMessage(int fd, Message& message);
+void writeMessage(int fd, const Message& message);
+
+std::string encodeResult(const std::vector<std::string>& headers,
+                         const std::vector<std::vector<std::string>>& rows);
+void decodeResult(const std::string& payload,
+                  std::vector<std::string>& headers,
+                  std::vector<std::vector<std::string>>& rows);
+
+} // namespace WireProtocol
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include <string>
+#include <vector>
+#include "forward_declarations.h"
+
+// 区域映射（zone map）：表按 BLOCK_ROWS 行分块，记录每块中每列非空值的最小值、
+// 最大值和空值个数，扫描时跳过不可能有行满足条件的块。
+//
+// 比较方式与 WHERE 条件相同（按字符串比较，空值按空字符串参与比较），跳过的块
+// 一定不包含满足条件的行。插入和更新只扩大范围，删除后整体重建。
+class ZoneMap {
+public:
+    static constexpr size_t BLOCK_ROWS = 1024;
+
+    struct ColumnZone {
+        bool hasValues = false;      // 块内有非空值
+        std::string minValue;
+        std::string maxValue;
+        size_t nullCount = 0;
+    };
+
+    void rebuild(const TableRows& data);
+    void addRow(const TableRow& row);
+    // 第 rowIndex 行的值改变后调用，旧值留下的范围不收缩
+    void updateRow(size_t rowIndex, const TableRow& row);
+
+    size_t getRowCount() const { return rowCount; }
+    size_t blockCount() const { return blocks.size(); }
+
+    // 块内是否可能有行满足 "列 op 值"，无法判断时返回 true
+    bool mayMatch(size_t block, size_t column, const std::string& op, const std::string& value) const;
+
+private:
+    std::vector<std::vector<ColumnZone>> blocks;
+    size_t rowCount = 0;
+
+    static void include(ColumnZone& zone, const std::string& value);
+};
+
+#endif
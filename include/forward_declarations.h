@@ -3,18 +3,24 @@
 
 #include <string>
 #include <vector>
+#include <memory_resource>
 
 struct ColumnDef {
     std::string name;
     std::string type;
     bool nullable = true;
     bool primaryKey = false;
+    bool bloomFilter = false;   // 为该列维护布隆过滤器
     // 外键相关
     bool isForeignKey = false;
     std::string referenceTable;
     std::string referenceColumn;
 };
 
+// 表中的一行和全部行，行的内存从所在表的内存池分配（见 RowStore）
+using TableRow = std::pmr::vector<std::string>;
+using TableRows = std::pmr::vector<TableRow>;
+
 class Table;
 
 #endif 
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include <QToolBar>
 #include <QToolButton>
 #include <QHBoxLayout>
+#include <QTabWidget>
 
 #include "DatabaseManager.h"
 #include "SQLParser.h"
@@ -67,12 +68,15 @@ private slots:
     void showSettingsDialog();
     void applySettings();
     void showBatchProcessDialog();
+    void toggleTracing(bool enabled);
     void showHelp();
     
 private:
     // UI组件
     QTextEdit* sqlInput;          // SQL输入框
+    QTabWidget* resultTabs;       // 结果/执行计划标签页
     QTableWidget* resultTable;    // 结果显示表格
+    QTableWidget* planTable;      // EXPLAIN 执行计划表格
     QPushButton* executeBtn;      // 执行按钮
     QComboBox* dbSelector;        // 数据库选择器
     QListWidget* tableList;       // 表列表
@@ -103,6 +107,9 @@ private:
     
     // 辅助函数
     void initializeDatabase();
+    void fillTable(QTableWidget* table,
+                   const std::vector<std::vector<std::string>>& results,
+                   const std::vector<std::string>& headers);
     bool eventFilter(QObject* obj, QEvent* event) override;
     
     // 新增辅助方法
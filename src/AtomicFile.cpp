@@ -0,0 +1,75 @@
+#include "AtomicFile.h"
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace AtomicFile {
+
+namespace {
+
+const char TEMP_SUFFIX[] = ".tmp";
+
+// 把文件（或目录项）刷到磁盘；Windows 上改名本身不能保证落盘，只依赖系统缓存
+bool syncPath(const std::filesystem::path& path, bool directory) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), directory ? O_RDONLY : O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok || directory;   // 有的文件系统不支持对目录 fsync
+#else
+    (void)path;
+    (void)directory;
+    return true;
+#endif
+}
+
+} // namespace
+
+void write(const std::filesystem::path& path, const std::function<void(std::ostream&)>& writer) {
+    std::filesystem::path tempPath = path;
+    tempPath += TEMP_SUFFIX;
+    try {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("无法创建文件: " + tempPath.string());
+        }
+        writer(file);
+        file.close();
+        if (!file) {
+            throw std::runtime_error("写入文件失败: " + tempPath.string());
+        }
+        if (!syncPath(tempPath, false)) {
+            throw std::runtime_error("文件刷新到磁盘失败: " + tempPath.string());
+        }
+        std::filesystem::rename(tempPath, path);
+    } catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        throw;
+    }
+    syncDirectory(path.parent_path().empty() ? std::filesystem::path(".") : path.parent_path());
+}
+
+void syncDirectory(const std::filesystem::path& dir) {
+    syncPath(dir, true);
+}
+
+void removeLeftovers(const std::filesystem::path& dir) {
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == TEMP_SUFFIX) {
+            std::error_code removeError;
+            std::filesystem::remove(it->path(), removeError);
+        }
+    }
+}
+
+} // namespace AtomicFile
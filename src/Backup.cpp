@@ -0,0 +1,143 @@
+#include "Backup.h"
+#include "AtomicFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace Backup {
+
+namespace {
+
+const char MANIFEST_MAGIC[] = "DBMSBACKUP 1";
+const char TEMP_SUFFIX[] = ".tmp";
+
+} // namespace
+
+std::string fileIdentity(const std::filesystem::path& path) {
+#ifndef _WIN32
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return "";
+    }
+    std::ostringstream out;
+    out << info.st_dev << ':' << info.st_ino << ':' << info.st_size << ':'
+        << info.st_mtim.tv_sec << '.' << info.st_mtim.tv_nsec;
+    return out.str();
+#else
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return "";
+    }
+    auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return "";
+    }
+    return std::to_string(size) + ':' + std::to_string(modified.time_since_epoch().count());
+#endif
+}
+
+bool link(const std::filesystem::path& from, const std::filesystem::path& to) {
+    std::error_code ec;
+    std::filesystem::create_hard_link(from, to, ec);
+    return !ec;
+}
+
+void writeManifest(const std::filesystem::path& dir, const Manifest& manifest) {
+    AtomicFile::write(dir / MANIFEST_NAME, [&manifest](std::ostream& out) {
+        out << MANIFEST_MAGIC << '\n';
+        out << "database " << manifest.database << '\n';
+        out << "commit " << manifest.commitTs << '\n';
+        for (const auto& file : manifest.files) {
+            out << "file " << file.size << ' ' << (file.identity.empty() ? "-" : file.identity)
+                << ' ' << file.name << '\n';
+        }
+    });
+}
+
+bool readManifest(const std::filesystem::path& dir, Manifest& manifest) {
+    std::ifstream in(dir / MANIFEST_NAME);
+    std::string line;
+    if (!std::getline(in, line) || line != MANIFEST_MAGIC) {
+        return false;
+    }
+    manifest = Manifest();
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "database") {
+            fields >> std::ws;
+            std::getline(fields, manifest.database);
+        } else if (kind == "commit") {
+            fields >> manifest.commitTs;
+        } else if (kind == "file") {
+            FileEntry file;
+            fields >> file.size >> file.identity >> std::ws;
+            std::getline(fields, file.name);
+            if (fields.fail() || file.name.empty()) {
+                return false;
+            }
+            if (file.identity == "-") {
+                file.identity.clear();
+            }
+            manifest.files.push_back(std::move(file));
+        }
+    }
+    return true;
+}
+
+std::filesystem::path latestBackup(const std::filesystem::path& databaseRoot) {
+    std::vector<std::filesystem::path> candidates;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(databaseRoot, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_directory() && it->path().extension() != TEMP_SUFFIX) {
+            candidates.push_back(it->path());
+        }
+    }
+    // 目录名按时间排列，从最新的开始找；没有清单的目录是没有完成的备份
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.filename() > b.filename();
+    });
+    for (const auto& path : candidates) {
+        Manifest manifest;
+        if (readManifest(path, manifest)) {
+            return path;
+        }
+    }
+    return std::filesystem::path();
+}
+
+std::filesystem::path newBackupDir(const std::filesystem::path& databaseRoot) {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    // std::localtime 的结果是共享的，其他线程（如慢查询日志）可能同时调用
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y%m%d-%H%M%S", &local);
+    char name[48];
+    std::snprintf(name, sizeof(name), "%s-%03d", time, static_cast<int>(millis));
+
+    std::filesystem::path dir = databaseRoot / name;
+    for (int suffix = 1; std::filesystem::exists(dir) ||
+                         std::filesystem::exists(std::filesystem::path(dir) += TEMP_SUFFIX); suffix++) {
+        dir = databaseRoot / (std::string(name) + "-" + std::to_string(suffix));
+    }
+    return dir;
+}
+
+} // namespace Backup
@@ -0,0 +1,88 @@
+#include "BloomFilter.h"
+#include "ZoneMap.h"
+#include <algorithm>
+#include <functional>
+
+BloomFilter::BloomFilter(size_t capacity)
+    : bits((std::max<size_t>(capacity, 1) * BITS_PER_VALUE + 63) / 64, 0),
+      capacity(std::max<size_t>(capacity, 1)) {
+}
+
+uint64_t BloomFilter::hash(const std::string& value) {
+    // 过滤器不持久化，可以使用 std::hash；再用 splitmix64 的混合步骤打散
+    uint64_t h = std::hash<std::string>()(value);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+void BloomFilter::add(const std::string& value) {
+    if (bits.empty()) {
+        return;
+    }
+    // 双重哈希：第 i 个位置为 h1 + i * h2
+    uint64_t h = hash(value);
+    uint64_t h1 = h & 0xffffffffULL;
+    uint64_t h2 = (h >> 32) | 1;
+    const uint64_t size = bits.size() * 64;
+    for (int i = 0; i < HASHES; i++) {
+        uint64_t bit = (h1 + i * h2) % size;
+        bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    count++;
+}
+
+bool BloomFilter::mayContain(const std::string& value) const {
+    if (bits.empty()) {
+        return true;
+    }
+    uint64_t h = hash(value);
+    uint64_t h1 = h & 0xffffffffULL;
+    uint64_t h2 = (h >> 32) | 1;
+    const uint64_t size = bits.size() * 64;
+    for (int i = 0; i < HASHES; i++) {
+        uint64_t bit = (h1 + i * h2) % size;
+        if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ColumnBloomFilter::rebuild(const TableRows& data, size_t column) {
+    table = BloomFilter(std::max<size_t>(data.size() * 2, ZoneMap::BLOCK_ROWS));
+    blocks.clear();
+    for (size_t i = 0; i < data.size(); i++) {
+        if (i % ZoneMap::BLOCK_ROWS == 0) {
+            blocks.emplace_back(ZoneMap::BLOCK_ROWS);
+        }
+        table.add(data[i][column]);
+        blocks.back().add(data[i][column]);
+    }
+}
+
+void ColumnBloomFilter::addRow(const TableRows& data, size_t column, size_t rowIndex) {
+    if (table.getCount() >= table.getCapacity()) {
+        rebuild(data, column);
+        return;
+    }
+    if (rowIndex / ZoneMap::BLOCK_ROWS >= blocks.size()) {
+        blocks.emplace_back(ZoneMap::BLOCK_ROWS);
+    }
+    table.add(data[rowIndex][column]);
+    blocks[rowIndex / ZoneMap::BLOCK_ROWS].add(data[rowIndex][column]);
+}
+
+void ColumnBloomFilter::updateRow(size_t rowIndex, const std::string& value) {
+    table.add(value);
+    if (rowIndex / ZoneMap::BLOCK_ROWS < blocks.size()) {
+        blocks[rowIndex / ZoneMap::BLOCK_ROWS].add(value);
+    }
+}
+
+bool ColumnBloomFilter::blockMayContain(size_t block, const std::string& value) const {
+    return block >= blocks.size() || blocks[block].mayContain(value);
+}
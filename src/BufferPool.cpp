@@ -0,0 +1,115 @@
+#include "BufferPool.h"
+#include "Trace.h"
+
+BufferPool::BufferPool(size_t capacityBytes) : capacity(capacityBytes) {}
+
+void BufferPool::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = bytes;
+    evictLocked();
+}
+
+size_t BufferPool::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    stats.pages = frames.size();
+    stats.bytes = usedBytes;
+    return stats;
+}
+
+BufferPool::PageHandle BufferPool::fetch(uint64_t fileId, uint64_t pageNo,
+                                         const std::function<Table()>& load, bool* hit) {
+    PageId id(fileId, pageNo);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = frames.find(id);
+        if (it != frames.end()) {
+            hits++;
+            recordAccess(it->second);
+            if (hit) {
+                *hit = true;
+            }
+            return it->second.page;
+        }
+        misses++;
+    }
+    if (hit) {
+        *hit = false;
+    }
+
+    PageHandle page = std::make_shared<const Table>(load());
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0) {
+        return page;
+    }
+    // 其他线程可能同时读入了同一页，使用先放入的那一份
+    auto [it, inserted] = frames.try_emplace(id);
+    if (inserted) {
+        it->second.page = std::move(page);
+        it->second.bytes = it->second.page->memoryBytes();
+        usedBytes += it->second.bytes;
+    }
+    recordAccess(it->second);
+    PageHandle pinned = it->second.page;
+    evictLocked(fileId);
+    return pinned;
+}
+
+void BufferPool::dropFile(uint64_t fileId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = frames.lower_bound(PageId(fileId, 0));
+    while (it != frames.end() && it->first.first == fileId) {
+        usedBytes -= it->second.bytes;
+        it = frames.erase(it);
+    }
+}
+
+void BufferPool::recordAccess(Frame& frame) {
+    for (size_t i = K - 1; i > 0; i--) {
+        frame.history[i] = frame.history[i - 1];
+    }
+    frame.history[0] = ++clock;
+}
+
+void BufferPool::evictLocked(uint64_t loadingFile) {
+    while (usedBytes > capacity) {
+        // 只有缓冲池自己持有的页未被固定；句柄只能经由 fetch() 在持有锁时复制出去
+        auto victim = frames.end();
+        auto newestCold = frames.end();   // 访问不足 K 次的页中最近访问的一页
+        for (auto it = frames.begin(); it != frames.end(); ++it) {
+            if (it->second.page.use_count() > 1) {
+                continue;
+            }
+            const uint64_t* a = it->second.history;
+            if (a[K - 1] == 0 && (newestCold == frames.end() || a[0] > newestCold->second.history[0])) {
+                newestCold = it;
+            }
+            if (victim == frames.end()) {
+                victim = it;
+                continue;
+            }
+            const uint64_t* b = victim->second.history;
+            if (a[K - 1] < b[K - 1] || (a[K - 1] == b[K - 1] && a[0] < b[0])) {
+                victim = it;
+            }
+        }
+        if (victim == frames.end()) {
+            return;   // 剩下的页都被固定
+        }
+        if (loadingFile != 0 && victim->first.first == loadingFile && victim->second.history[K - 1] == 0) {
+            victim = newestCold;
+        }
+        TRACE_SCOPE("BufferPool::evict", "persist");
+        usedBytes -= victim->second.bytes;
+        frames.erase(victim);
+        evictions++;
+    }
+}
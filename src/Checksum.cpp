@@ -0,0 +1,104 @@
+#include "Checksum.h"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CHECKSUM_X86_CRC 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHECKSUM_ARM_CRC 1
+#endif
+
+namespace Checksum {
+
+namespace {
+
+constexpr uint32_t POLYNOMIAL = 0x82f63b78;   // 0x1edc6f41 按位反转
+
+constexpr std::array<uint32_t, 256> makeTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> TABLE = makeTable();
+
+uint32_t softwareCrc(const unsigned char* p, size_t size, uint32_t crc) {
+    for (size_t i = 0; i < size; i++) {
+        crc = TABLE[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(CHECKSUM_X86_CRC)
+__attribute__((target("sse4.2")))
+uint32_t hardwareCrc(const unsigned char* p, size_t size, uint32_t crc) {
+    uint64_t value = crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        value = _mm_crc32_u64(value, word);
+    }
+    uint32_t rest = static_cast<uint32_t>(value);
+    for (; size > 0; p++, size--) {
+        rest = _mm_crc32_u8(rest, *p);
+    }
+    return rest;
+}
+
+bool detectHardwareCrc() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(CHECKSUM_ARM_CRC)
+uint32_t hardwareCrc(const unsigned char* p, size_t size, uint32_t crc) {
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+    }
+    for (; size > 0; p++, size--) {
+        crc = __crc32cb(crc, *p);
+    }
+    return crc;
+}
+
+bool detectHardwareCrc() {
+    return true;
+}
+#else
+uint32_t hardwareCrc(const unsigned char* p, size_t size, uint32_t crc) {
+    return softwareCrc(p, size, crc);
+}
+
+bool detectHardwareCrc() {
+    return false;
+}
+#endif
+
+bool hasHardwareCrc() {
+    static const bool supported = detectHardwareCrc();
+    return supported;
+}
+
+} // namespace
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    crc = hasHardwareCrc() ? hardwareCrc(p, size, crc) : softwareCrc(p, size, crc);
+    return ~crc;
+}
+
+const char* crc32cImplementation() {
+    return hasHardwareCrc() ? "hardware" : "software";
+}
+
+} // namespace Checksum
@@ -0,0 +1,87 @@
+#include "ColumnDictionary.h"
+#include <algorithm>
+
+bool ColumnDictionary::withinLimit(size_t valueCount, size_t rowCount) {
+    return valueCount <= MAX_VALUES &&
+           (valueCount <= SMALL_DICTIONARY || valueCount * MIN_REPEAT <= rowCount);
+}
+
+void ColumnDictionary::rebuild(const TableRows& data, size_t column) {
+    active = true;
+    values.clear();
+    lookup.clear();
+    codes.clear();
+    codes.reserve(data.size());
+
+    // 重建时按最终的行数判断，前面的行中不同值较多也不会提前停用
+    for (const auto& row : data) {
+        auto it = lookup.find(row[column]);
+        if (it == lookup.end()) {
+            if (values.size() >= MAX_VALUES) {
+                disable(data.size());
+                return;
+            }
+            it = lookup.emplace(row[column], static_cast<uint32_t>(values.size())).first;
+            values.push_back(row[column]);
+        }
+        codes.push_back(it->second);
+    }
+    if (!withinLimit(values.size(), data.size())) {
+        disable(data.size());
+    }
+}
+
+void ColumnDictionary::addRow(const TableRows& data, size_t column, size_t rowIndex) {
+    if (!active) {
+        if (data.size() >= retryAt) {
+            rebuild(data, column);
+        }
+        return;
+    }
+    if (codes.size() != rowIndex) {
+        rebuild(data, column);
+        return;
+    }
+    uint32_t c = encode(data[rowIndex][column], data.size());
+    if (c != NO_CODE) {
+        codes.push_back(c);
+    }
+}
+
+void ColumnDictionary::updateRow(const TableRows& data, size_t column, size_t rowIndex) {
+    if (!isActive(data.size())) {
+        return;
+    }
+    uint32_t c = encode(data[rowIndex][column], data.size());
+    if (c != NO_CODE) {
+        codes[rowIndex] = c;
+    }
+}
+
+uint32_t ColumnDictionary::find(const std::string& value) const {
+    auto it = lookup.find(value);
+    return it == lookup.end() ? NO_CODE : it->second;
+}
+
+uint32_t ColumnDictionary::encode(const std::string& value, size_t rowCount) {
+    auto it = lookup.find(value);
+    if (it != lookup.end()) {
+        return it->second;
+    }
+    if (!withinLimit(values.size() + 1, rowCount)) {
+        disable(rowCount);
+        return NO_CODE;
+    }
+    uint32_t c = static_cast<uint32_t>(values.size());
+    lookup.emplace(value, c);
+    values.push_back(value);
+    return c;
+}
+
+void ColumnDictionary::disable(size_t rowCount) {
+    active = false;
+    retryAt = std::max(rowCount * 2, SMALL_DICTIONARY);
+    values.clear();
+    lookup.clear();
+    codes = {};
+}
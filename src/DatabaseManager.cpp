@@ -1,10 +1,20 @@
 #include "DatabaseManager.h"
 #include "Table.h"
 #include "SQLParser.h"
+#include "Trace.h"
+#include "TableFile.h"
+#include "AtomicFile.h"
 #include <fstream>
+#include <iostream>
 #include <filesystem>
 #include <sstream>
+#include <iomanip>
+#include <cmath>
 #include <stdexcept>
+#include <deque>
+#include <set>
+#include <future>
+#include <thread>
 
 std::string trim(const std::string& str) {
     size_t first = str.find_first_not_of(" \t\n\r");
@@ -13,20 +23,493 @@ std::string trim(const std::string& str) {
     return str.substr(first, (last - first + 1));
 }
 
-DatabaseManager::DatabaseManager(const std::string& path) : dbPath(path) {
+// 含聚合函数或 GROUP BY 的单表查询走 selectWithAggregates
+static bool hasAggregation(const SQLParser::ParsedQuery& query) {
+    for (const auto& col : query.columns) {
+        if (col.aggregateFunc != SQLParser::AggregateFunction::NONE) {
+            return true;
+        }
+    }
+    return !query.groupByColumns.empty();
+}
+
+// 按顺序读出数据块（readChunk），在线程池中并行解码并检查各行（decodeChunk），再按读出的
+// 顺序追加到表中；最后重建索引、区域映射等结构。同时在解码的块数有上限，内存不会随文件增长
+template <typename ReadChunk, typename DecodeChunk>
+static void loadChunks(Table& table, ThreadPool* pool, ReadChunk readChunk, DecodeChunk decodeChunk) {
+    using Rows = std::vector<std::vector<std::string>>;
+    auto decodeAndCheck = [&table, &decodeChunk](const std::string& chunk) {
+        Rows rows = decodeChunk(chunk);
+        try {
+            for (const auto& row : rows) {
+                table.checkRow(row);
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("插入数据失败: " + std::string(e.what()));
+        }
+        return rows;
+    };
+    
+    std::string chunk;
+    if (!pool) {
+        while (readChunk(chunk)) {
+            Rows rows = decodeAndCheck(chunk);
+            table.appendRows(rows);
+        }
+        table.rebuildStructures();
+        return;
+    }
+    
+    std::deque<std::future<Rows>> pending;
+    try {
+        size_t window = pool->size() * 2;
+        while (readChunk(chunk)) {
+            pending.push_back(pool->async([&decodeAndCheck, chunk = std::move(chunk)]() {
+                return decodeAndCheck(chunk);
+            }));
+            if (pending.size() >= window) {
+                Rows rows = pending.front().get();
+                pending.pop_front();
+                table.appendRows(rows);
+            }
+        }
+        while (!pending.empty()) {
+            Rows rows = pending.front().get();
+            pending.pop_front();
+            table.appendRows(rows);
+        }
+    } catch (...) {
+        // 出错时先等还在解码的块结束，它们引用着这里的局部变量
+        for (auto& rows : pending) {
+            if (rows.valid()) {
+                rows.wait();
+            }
+        }
+        throw;
+    }
+    table.rebuildStructures(pool);
+}
+
+// 读取表文件：按块读取，各块并行解码
+static Table readTableFile(std::istream& in, const std::string& tableName, ThreadPool* pool) {
+    TableFile::Reader reader(in);
+    Table table(tableName, reader.getColumns());
+    table.reserveRows(reader.getRowCount());
+    loadChunks(table, pool,
+        [&reader](std::string& block) { return reader.readBlock(block); },
+        [&reader](const std::string& block) {
+            std::vector<std::vector<std::string>> rows;
+            reader.decodeBlock(block, rows);
+            return rows;
+        });
+    return table;
+}
+
+// 旧版本的文本格式：第一行为列定义（名称:类型:可空:主键[:布隆过滤器]），之后每行一条
+// 记录，值中的逗号写为 "\,"。读取列定义，文件为空时返回 false
+static bool readTextColumns(std::istream& file, std::vector<ColumnDef>& columns) {
+    std::string line;
+    if (!std::getline(file, line)) {
+        return false;
+    }
+    
+    std::istringstream iss(line);
+    std::string colDef;
+    while (std::getline(iss, colDef, ',')) {
+        std::istringstream colIss(colDef);
+        std::string name, type, nullable, primaryKey, bloomFilter;
+        std::getline(colIss, name, ':');
+        std::getline(colIss, type, ':');
+        std::getline(colIss, nullable, ':');
+        std::getline(colIss, primaryKey, ':');
+        std::getline(colIss, bloomFilter);  // 更早的文件没有这一项
+        
+        ColumnDef col;
+        col.name = name;
+        col.type = type;
+        col.nullable = nullable == "1";
+        col.primaryKey = primaryKey == "1";
+        col.bloomFilter = bloomFilter == "1";
+        columns.push_back(col);
+    }
+    return true;
+}
+
+// 表文件旁的 .stats 文件，文件缺失或与表结构不一致时返回 false（统计信息只是估算依据）
+static bool readStatsFile(const std::filesystem::path& tableFile, const std::vector<ColumnDef>& columns,
+                          TableStats& stats) {
+    std::ifstream in(std::filesystem::path(tableFile).replace_extension(".stats"));
+    return in && stats.load(in, columns);
+}
+
+// 文本格式的一段数据，每行一条记录，末尾的空值也算一列
+static std::vector<std::vector<std::string>> parseTextRows(const std::string& text) {
+    std::vector<std::vector<std::string>> rows;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::vector<std::string> values(1);
+        for (size_t i = pos; i < end; i++) {
+            if (text[i] == '\\' && i + 1 < end && text[i + 1] == ',') {
+                values.back() += ',';
+                i++;
+            } else if (text[i] == ',') {
+                values.emplace_back();
+            } else {
+                values.back() += text[i];
+            }
+        }
+        rows.push_back(std::move(values));
+        pos = end + 1;
+    }
+    return rows;
+}
+
+// 读取文本格式的表文件：按 TEXT_CHUNK_BYTES 分段读取，每段延伸到行尾，各段并行解析
+static bool readTextTableFile(std::istream& file, const std::string& tableName, Table& table, ThreadPool* pool) {
+    constexpr size_t TEXT_CHUNK_BYTES = 1 << 20;
+    std::vector<ColumnDef> columns;
+    if (!readTextColumns(file, columns)) {
+        return false;
+    }
+    table = Table(tableName, columns);
+    
+    loadChunks(table, pool,
+        [&file](std::string& chunk) {
+            chunk.assign(TEXT_CHUNK_BYTES, '\0');
+            file.read(chunk.data(), chunk.size());
+            chunk.resize(file.gcount());
+            if (chunk.empty()) {
+                return false;
+            }
+            std::string rest;
+            if (chunk.back() != '\n' && std::getline(file, rest)) {
+                chunk += rest;
+            }
+            return true;
+        },
+        parseTextRows);
+    return true;
+}
+
+DatabaseManager::DatabaseManager(const std::string& path)
+    : dbPath(path), snapshot(std::make_shared<Snapshot>()) {
     // 确保数据目录存在
     try {
         if (!std::filesystem::exists(path)) {
             std::filesystem::create_directories(path);
         }
+        queryStats.setSlowLogPath(path + "/slow_query.log");
         // 初始化时不需要loadFromFile，因为还没有选择数据库
     } catch (const std::exception& e) {
         throw std::runtime_error("无法创建数据库目录: " + std::string(e.what()));
     }
 }
 
+DatabaseManager::~DatabaseManager() {
+    {
+        std::lock_guard<std::mutex> lock(autoSaveMutex);
+        autoSaveInterval = std::chrono::milliseconds(0);
+        autoBackupInterval = std::chrono::milliseconds(0);
+    }
+    restartBackgroundThread();
+    try {
+        std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+        flushDirtyTables();
+    } catch (const std::exception& e) {
+        std::cerr << "自动保存失败: " << e.what() << std::endl;
+    }
+}
+
+void DatabaseManager::setAutoSaveInterval(std::chrono::milliseconds interval) {
+    bool flushNow;
+    {
+        std::lock_guard<std::mutex> lock(autoSaveMutex);
+        flushNow = interval.count() <= 0 && autoSaveInterval.count() > 0;
+        autoSaveInterval = std::max(interval, std::chrono::milliseconds(0));
+    }
+    restartBackgroundThread();
+    // 之后的修改同步写入，之前标记为未保存的表在这里写入
+    if (flushNow) {
+        flush();
+    }
+}
+
+void DatabaseManager::setAutoBackup(const std::string& backupPath, std::chrono::milliseconds interval) {
+    {
+        std::lock_guard<std::mutex> lock(autoSaveMutex);
+        autoBackupPath = backupPath;
+        autoBackupInterval = backupPath.empty() ? std::chrono::milliseconds(0)
+                                                : std::max(interval, std::chrono::milliseconds(0));
+    }
+    restartBackgroundThread();
+}
+
+void DatabaseManager::flush() {
+    std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+    flushDirtyTables();
+}
+
+void DatabaseManager::restartBackgroundThread() {
+    std::lock_guard<std::mutex> threadLock(backgroundThreadMutex);
+    if (backgroundThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(autoSaveMutex);
+            stopBackground = true;
+        }
+        autoSaveCondition.notify_all();
+        backgroundThread.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(autoSaveMutex);
+    stopBackground = false;
+    if (autoSaveInterval.count() > 0 || autoBackupInterval.count() > 0) {
+        backgroundThread = std::thread(&DatabaseManager::backgroundLoop, this);
+    }
+}
+
+void DatabaseManager::backgroundLoop() {
+    using Clock = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> lock(autoSaveMutex);
+    Clock::time_point nextSave = Clock::now() + autoSaveInterval;
+    Clock::time_point nextBackup = Clock::now() + autoBackupInterval;
+    while (!stopBackground) {
+        // 设置改变时线程会被重新启动，这里的间隔不变
+        Clock::time_point wake = autoSaveInterval.count() > 0 ? nextSave : nextBackup;
+        if (autoSaveInterval.count() > 0 && autoBackupInterval.count() > 0) {
+            wake = std::min(nextSave, nextBackup);
+        }
+        if (autoSaveCondition.wait_until(lock, wake, [this]() { return stopBackground; })) {
+            break;
+        }
+        Clock::time_point now = Clock::now();
+        bool save = autoSaveInterval.count() > 0 && now >= nextSave;
+        bool backup = autoBackupInterval.count() > 0 && now >= nextBackup;
+        if (save) {
+            nextSave = now + autoSaveInterval;
+            save = !dirtyTables.empty();
+        }
+        if (backup) {
+            nextBackup = now + autoBackupInterval;
+        }
+        std::string backupPath = autoBackupPath;
+        lock.unlock();
+        
+        if (save) {
+            try {
+                flush();
+            } catch (const std::exception& e) {
+                // 失败的表仍标记为未保存，下一个间隔重试
+                std::cerr << "自动保存失败: " << e.what() << std::endl;
+            }
+            // 写入后的版本可以卸载了
+            evictColdTables();
+        }
+        if (backup && !getCurrentDatabase().empty()) {
+            try {
+                backupDatabase(backupPath, true);
+            } catch (const std::exception& e) {
+                std::cerr << "自动备份失败: " << e.what() << std::endl;
+            }
+        }
+        lock.lock();
+    }
+}
+
+void DatabaseManager::flushDirtyTables() {
+    TRACE_SCOPE("DatabaseManager::flushDirtyTables", "persist");
+    std::set<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(autoSaveMutex);
+        names.swap(dirtyTables);
+    }
+    
+    std::string error;
+    for (const auto& name : names) {
+        auto lockIt = tableLocks.find(name);
+        if (lockIt == tableLocks.end()) {
+            continue;   // 表已被删除
+        }
+        std::lock_guard<std::mutex> tableLock(*lockIt->second);
+        auto current = acquireSnapshot();
+        auto it = current->tables.find(name);
+        if (it == current->tables.end() || it->second->persisted) {
+            continue;
+        }
+        try {
+            it->second->persisted = saveTableToFile(name, *tableData(*it->second));
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        if (!it->second->persisted) {
+            std::lock_guard<std::mutex> lock(autoSaveMutex);
+            dirtyTables.insert(name);
+        }
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+DatabaseManager::BackupResult DatabaseManager::backupDatabase(const std::string& backupPath, bool incremental) {
+    TRACE_SCOPE("DatabaseManager::backupDatabase", "persist");
+    std::lock_guard<std::mutex> backupLock(backupMutex);
+    
+    // 备份中的一个文件，来源为以下之一：上一个备份中相同的文件；已打开的表文件（之后被改名
+    // 替换也仍读到原来的内容）；内存中的表版本
+    struct PlannedFile {
+        Backup::FileEntry entry;
+        std::filesystem::path previous;
+        bool linked = false;
+        std::shared_ptr<std::ifstream> source;
+        TableHandle table;
+        bool stats = false;
+    };
+    std::vector<PlannedFile> files;
+    Backup::Manifest manifest;
+    std::filesystem::path previousDir;
+    std::filesystem::path staging;
+    bool unchanged;
+    
+    // 在快照上确定每个文件的来源。共享目录锁使表不会在这期间被删除，每张表只在检查和打开
+    // 它的表文件时持有表锁，不等待复制
+    {
+        std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+        if (currentDatabase.empty()) {
+            throw std::runtime_error("未选择数据库");
+        }
+        auto snap = acquireSnapshot();
+        manifest.database = currentDatabase;
+        manifest.commitTs = snap->commitTs;
+        
+        std::filesystem::path root = std::filesystem::path(backupPath) / currentDatabase;
+        std::filesystem::create_directories(root);
+        std::map<std::string, std::string> previousFiles;
+        Backup::Manifest previousManifest;
+        if (incremental) {
+            previousDir = Backup::latestBackup(root);
+            if (!previousDir.empty() && Backup::readManifest(previousDir, previousManifest)) {
+                for (const auto& file : previousManifest.files) {
+                    previousFiles[file.name] = file.identity;
+                }
+            }
+        }
+        staging = Backup::newBackupDir(root);
+        staging += ".tmp";
+        std::filesystem::create_directories(staging);
+        
+        std::filesystem::path dbDir = std::filesystem::path(dbPath) / currentDatabase;
+        for (const auto& [name, version] : snap->tables) {
+            std::lock_guard<std::mutex> tableLock(lockForTable(name));
+            auto latest = acquireSnapshot();
+            auto current = latest->tables.find(name);
+            if (current->second != version || !version->persisted) {
+                // 还没有写入表文件，或者之后已被新的版本替换：从内存写出快照中的版本
+                PlannedFile table;
+                table.entry.name = name + ".tbl";
+                table.table = tableData(*version);
+                files.push_back(table);
+                if (table.table->getStats().isAnalyzed()) {
+                    table.entry.name = name + ".stats";
+                    table.stats = true;
+                    files.push_back(table);
+                }
+                continue;
+            }
+            
+            for (const auto& path : {version->file, dbDir / (name + ".stats")}) {
+                PlannedFile file;
+                file.entry.name = path.filename().string();
+                file.entry.identity = Backup::fileIdentity(path);
+                if (file.entry.identity.empty()) {
+                    continue;   // 没有统计文件
+                }
+                file.entry.size = std::filesystem::file_size(path);
+                auto previous = previousFiles.find(file.entry.name);
+                if (previous != previousFiles.end() && previous->second == file.entry.identity) {
+                    file.previous = previousDir / file.entry.name;
+                } else {
+                    file.source = std::make_shared<std::ifstream>(path, std::ios::binary);
+                    if (!*file.source) {
+                        throw std::runtime_error("无法读取表文件: " + path.string());
+                    }
+                }
+                files.push_back(std::move(file));
+            }
+        }
+        unchanged = !previousDir.empty() && files.size() == previousManifest.files.size() &&
+                    std::all_of(files.begin(), files.end(), [](const PlannedFile& file) {
+                        return !file.previous.empty();
+                    });
+    }
+    
+    BackupResult result;
+    if (unchanged) {
+        std::error_code ec;
+        std::filesystem::remove_all(staging, ec);
+        result.path = previousDir.string();
+        return result;
+    }
+    
+    // 不持有锁：复制或写出各文件，写入清单后改名为正式的备份目录
+    try {
+        auto copyFrom = [](std::istream& in, const std::filesystem::path& target) {
+            AtomicFile::write(target, [&in](std::ostream& out) {
+                out << in.rdbuf();
+            });
+        };
+        for (auto& file : files) {
+            std::filesystem::path target = staging / file.entry.name;
+            if (!file.previous.empty()) {
+                if (Backup::link(file.previous, target)) {
+                    file.linked = true;
+                } else {
+                    std::ifstream in(file.previous, std::ios::binary);
+                    copyFrom(in, target);
+                }
+            } else if (file.source) {
+                copyFrom(*file.source, target);
+            } else if (file.table) {
+                AtomicFile::write(target, [&file](std::ostream& out) {
+                    if (file.stats) {
+                        file.table->getStats().save(out);
+                    } else {
+                        TableFile::write(out, file.table->getColumns(), file.table->getData());
+                    }
+                });
+                file.entry.size = std::filesystem::file_size(target);
+            }
+            result.files++;
+            if (file.linked) {
+                result.linkedFiles++;
+            } else {
+                result.copiedBytes += file.entry.size;
+            }
+            manifest.files.push_back(file.entry);
+        }
+        AtomicFile::syncDirectory(staging);
+        Backup::writeManifest(staging, manifest);
+        
+        std::filesystem::path target = staging;
+        target.replace_extension();
+        std::filesystem::rename(staging, target);
+        AtomicFile::syncDirectory(target.parent_path());
+        result.path = target.string();
+        result.created = true;
+    } catch (...) {
+        std::error_code ec;
+        std::filesystem::remove_all(staging, ec);
+        throw;
+    }
+    return result;
+}
+
 bool DatabaseManager::createDatabase(const std::string& dbName) {
     try {
+        std::unique_lock<std::shared_mutex> catalogLock(catalogMutex);
         std::filesystem::path dbDir = dbPath + "/" + dbName;
         if (std::filesystem::exists(dbDir)) {
             return false;
@@ -34,9 +517,12 @@ bool DatabaseManager::createDatabase(const std::string& dbName) {
         
         bool success = std::filesystem::create_directories(dbDir);
         if (success) {
-            // 创建成功后自动使用该数据库
-            currentDatabase = dbName;
-            tables.clear();  // 清除旧表
+            // 创建成功后自动使用该数据库；同名的数据库之前可能在外部被删除，不使用缓存
+            {
+                std::lock_guard<std::mutex> lock(openDatabasesMutex);
+                openDatabases.erase(dbName);
+            }
+            switchDatabase(dbName);
         }
         return success;
     } catch (const std::exception& e) {
@@ -46,6 +532,16 @@ bool DatabaseManager::createDatabase(const std::string& dbName) {
 
 bool DatabaseManager::dropDatabase(const std::string& dbName) {
     try {
+        std::unique_lock<std::shared_mutex> catalogLock(catalogMutex);
+        {
+            std::lock_guard<std::mutex> lock(openDatabasesMutex);
+            openDatabases.erase(dbName);
+        }
+        if (dbName == currentDatabase) {
+            // 表文件随目录一起删除，不再写入未保存的修改
+            std::lock_guard<std::mutex> lock(autoSaveMutex);
+            dirtyTables.clear();
+        }
         std::filesystem::path dbDir = dbPath + "/" + dbName;
         return std::filesystem::remove_all(dbDir) > 0;
     } catch (...) {
@@ -55,13 +551,17 @@ bool DatabaseManager::dropDatabase(const std::string& dbName) {
 
 bool DatabaseManager::useDatabase(const std::string& dbName) {
     try {
+        std::unique_lock<std::shared_mutex> catalogLock(catalogMutex);
         std::filesystem::path dbPath = this->dbPath + "/" + dbName;
         if (!std::filesystem::exists(dbPath)) {
             return false;
         }
         
-        currentDatabase = dbName;
-        return loadFromFile();
+        // 再次选择当前数据库时重新读取，切换到其他数据库时优先使用已打开的
+        if (dbName == currentDatabase) {
+            return loadFromFile();
+        }
+        return switchDatabase(dbName);
     } catch (const std::exception& e) {
         throw std::runtime_error("切换数据库失败: " + std::string(e.what()));
     }
@@ -70,13 +570,19 @@ bool DatabaseManager::useDatabase(const std::string& dbName) {
 bool DatabaseManager::createTable(const std::string& tableName, 
                                 const std::vector<ColumnDef>& columns) {
     try {
+        std::unique_lock<std::shared_mutex> catalogLock(catalogMutex);
+        
         // 检查数据库是否已选择
         if (currentDatabase.empty()) {
             throw std::runtime_error("未选择数据库");
         }
-
+        
+        if (isSystemTable(tableName)) {
+            throw std::runtime_error("表名已被系统表使用: " + tableName);
+        }
+        
         // 检查表名是否已存在
-        if (tables.find(tableName) != tables.end()) {
+        if (acquireSnapshot()->tables.count(tableName) > 0) {
             throw std::runtime_error("表已存在: " + tableName);
         }
 
@@ -86,37 +592,63 @@ bool DatabaseManager::createTable(const std::string& tableName,
         }
 
         // 创建表
-        tables.emplace(tableName, Table(tableName, columns));
+        tableLocks[tableName] = std::make_shared<std::mutex>();
 
-        // 保存到文件
-        return saveToFile();
+        // 发布并保存到文件
+        return commitAndSave(tableName, std::make_shared<Table>(tableName, columns));
     } catch (const std::exception& e) {
         throw std::runtime_error("创建表失败: " + std::string(e.what()));
     }
 }
 
 bool DatabaseManager::dropTable(const std::string& tableName) {
-    auto it = tables.find(tableName);
-    if (it == tables.end()) {
+    std::unique_lock<std::shared_mutex> catalogLock(catalogMutex);
+    if (acquireSnapshot()->tables.count(tableName) == 0) {
         return false;
     }
     
-    tables.erase(it);
-    return saveToFile();
+    commitTable(tableName, nullptr);
+    tableLocks.erase(tableName);
+    
+    // 删除表文件，否则重新加载时该表会再次出现
+    try {
+        std::filesystem::path dbDir = dbPath + "/" + currentDatabase;
+        std::filesystem::remove(dbDir / (tableName + ".tbl"));
+        std::filesystem::remove(dbDir / (tableName + ".txt"));
+        std::filesystem::remove(dbDir / (tableName + ".stats"));
+    } catch (const std::exception& e) {
+        throw std::runtime_error("删除表文件失败: " + std::string(e.what()));
+    }
+    return true;
+}
+
+bool DatabaseManager::analyzeTable(const std::string& tableName) {
+    TRACE_SCOPE("DatabaseManager::analyzeTable", "stats", tableName);
+    return modifyTable(tableName, [](Table& table) {
+        table.analyze();
+        return true;
+    });
+}
+
+bool DatabaseManager::setBloomFilter(const std::string& tableName,
+                                     const std::vector<std::string>& columns, bool enabled) {
+    return modifyTable(tableName, [&](Table& table) {
+        for (const auto& column : columns) {
+            table.setBloomFilter(column, enabled);
+        }
+        return true;
+    });
 }
 
 bool DatabaseManager::insertInto(const std::string& tableName, 
                                const std::vector<std::string>& values) {
-    auto it = tables.find(tableName);
-    if (it == tables.end()) {
+    if (acquireSnapshot()->tables.count(tableName) == 0) {
         return false;
     }
     
-    bool success = it->second.insertRow(values);
-    if (success) {
-        return saveToFile();
-    }
-    return false;
+    return modifyTable(tableName, [&](Table& table) {
+        return table.insertRow(values);
+    });
 }
 
 std::vector<std::vector<std::string>> DatabaseManager::select(
@@ -124,61 +656,44 @@ std::vector<std::vector<std::string>> DatabaseManager::select(
     const std::vector<std::string>& columns,
     const std::string& whereClause) {
     
-    auto it = tables.find(tableName);
-    if (it == tables.end()) {
+    auto version = findVersion(*acquireSnapshot(), tableName);
+    if (!version) {
         return std::vector<std::vector<std::string>>();
     }
     
-    return it->second.select(columns, whereClause);
+    auto result = tableData(*version)->select(columns, whereClause);
+    evictColdTables();
+    return result;
 }
 
-bool DatabaseManager::saveToFile() {
+// 调用者需持有 catalogMutex，并持有该表的写锁或独占目录锁
+bool DatabaseManager::saveTableToFile(const std::string& tableName, const Table& table) const {
+    TRACE_SCOPE("DatabaseManager::saveTableToFile", "persist", tableName);
     try {
         if (currentDatabase.empty()) {
             return false;
         }
 
         std::filesystem::path dbDir = dbPath + "/" + currentDatabase;
+        std::filesystem::path tablePath = dbDir / (tableName + ".tbl");
+        // 写入临时文件后改名替换，中途失败时原来的表文件保持完整
+        AtomicFile::write(tablePath, [&table](std::ostream& out) {
+            TableFile::write(out, table.getColumns(), table.getData());
+        });
         
-        // 遍历所有表并保存
-        for (const auto& [tableName, table] : tables) {
-            std::filesystem::path tablePath = dbDir / (tableName + ".txt");
-            std::ofstream file(tablePath);
-            if (!file) {
-                throw std::runtime_error("无法创建表文件: " + tablePath.string());
-            }
-            
-            // 保存列定义
-            const auto& columns = table.getColumns();
-            bool first = true;
-            for (const auto& col : columns) {
-                if (!first) file << ",";
-                file << col.name << ":" 
-                     << col.type << ":" 
-                     << (col.nullable ? "1" : "0") << ":" 
-                     << (col.primaryKey ? "1" : "0");
-                first = false;
-            }
-            file << "\n";
-            
-            // 保存数据
-            const auto& data = table.getData();
-            for (const auto& row : data) {
-                first = true;
-                for (const auto& value : row) {
-                    if (!first) file << ",";
-                    // 处理特殊字符
-                    std::string escapedValue = value;
-                    size_t pos = 0;
-                    while ((pos = escapedValue.find(',', pos)) != std::string::npos) {
-                        escapedValue.replace(pos, 1, "\\,");
-                        pos += 2;
-                    }
-                    file << escapedValue;
-                    first = false;
-                }
-                file << "\n";
-            }
+        // 旧的文本格式文件已被取代
+        std::error_code removeError;
+        std::filesystem::remove(dbDir / (tableName + ".txt"), removeError);
+        
+        // 保存统计信息，未分析过的表不保留旧的统计文件
+        std::filesystem::path statsPath = dbDir / (tableName + ".stats");
+        if (table.getStats().isAnalyzed()) {
+            AtomicFile::write(statsPath, [&table](std::ostream& out) {
+                table.getStats().save(out);
+            });
+        } else {
+            std::error_code ec;
+            std::filesystem::remove(statsPath, ec);
         }
         return true;
     } catch (const std::exception& e) {
@@ -186,79 +701,334 @@ bool DatabaseManager::saveToFile() {
     }
 }
 
+// 调用者需独占持有 catalogMutex
+// 只读取各表文件的列定义，表数据在第一次访问时才加载（见 tableData()）
 bool DatabaseManager::loadFromFile() {
+    TRACE_SCOPE("DatabaseManager::loadFromFile", "persist", currentDatabase);
+    // 重新读取前写入未保存的修改，否则它们会被表文件中的旧版本覆盖
+    flushDirtyTables();
+    tableLocks.clear();
     if (currentDatabase.empty()) {
         return false;
     }
     
     try {
-        tables.clear();
-        std::filesystem::path dbDir = dbPath + "/" + currentDatabase;
-        
-        // 检查数据库目录是否存在
-        if (!std::filesystem::exists(dbDir)) {
-            return false;
+        std::map<std::string, TableVersionPtr> catalog;
+        TableLocks locks;
+        bool exists = readCatalog(currentDatabase, catalog, locks);
+        if (exists) {
+            AtomicFile::removeLeftovers(dbPath + "/" + currentDatabase);
         }
-        
-        // 遍历数据库目录下的所有.txt文件
-        for (const auto& entry : std::filesystem::directory_iterator(dbDir)) {
-            if (entry.path().extension() == ".txt") {
-                std::string tableName = entry.path().stem().string();
-                std::ifstream file(entry.path());
-                if (!file) {
-                    continue;
-                }
-                
-                // 读取列定义
-                std::string line;
-                if (!std::getline(file, line)) {
-                    continue;
-                }
-                
-                std::vector<ColumnDef> columns;
-                std::istringstream iss(line);
-                std::string colDef;
-                while (std::getline(iss, colDef, ',')) {
-                    std::istringstream colIss(colDef);
-                    std::string name, type, nullable, primaryKey;
-                    std::getline(colIss, name, ':');
-                    std::getline(colIss, type, ':');
-                    std::getline(colIss, nullable, ':');
-                    std::getline(colIss, primaryKey);
-                    
-                    columns.push_back({
-                        name,
-                        type,
-                        nullable == "1",
-                        primaryKey == "1"
-                    });
+        tableLocks = std::move(locks);
+        commitTables(std::move(catalog));
+        return exists;
+    } catch (const std::exception& e) {
+        // 不保留旧数据库的表，避免之后被写入新数据库目录
+        commitTables({});
+        throw std::runtime_error("加载数据库失败: " + std::string(e.what()));
+    }
+}
+
+bool DatabaseManager::readCatalog(const std::string& database, std::map<std::string, TableVersionPtr>& catalog,
+                                  TableLocks& locks) const {
+    std::filesystem::path dbDir = dbPath + "/" + database;
+    
+    // 检查数据库目录是否存在
+    if (!std::filesystem::exists(dbDir)) {
+        return false;
+    }
+    
+    // 遍历数据库目录下的表文件；旧版本的 .txt 文件在没有同名 .tbl 时读取，下次保存时转换
+    for (const auto& entry : std::filesystem::directory_iterator(dbDir)) {
+        std::filesystem::path path = entry.path();
+        bool textFormat = path.extension() == ".txt";
+        if (path.extension() == ".tbl" ||
+            (textFormat && !std::filesystem::exists(std::filesystem::path(path).replace_extension(".tbl")))) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                continue;
+            }
+            
+            auto version = std::make_shared<TableVersion>();
+            version->name = path.stem().string();
+            version->file = path;
+            version->id = ++nextVersionId;
+            if (!textFormat) {
+                TableFile::Reader reader(file);
+                version->columns = reader.getColumns();
+                version->rowCount = reader.getRowCount();
+            } else if (!readTextColumns(file, version->columns)) {
+                continue;
+            }
+            version->persisted = true;
+            
+            locks[version->name] = std::make_shared<std::mutex>();
+            catalog.emplace(version->name, std::move(version));
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::switchDatabase(const std::string& dbName) {
+    TRACE_SCOPE("DatabaseManager::switchDatabase", "persist", dbName);
+    flushDirtyTables();
+    std::lock_guard<std::mutex> lock(openDatabasesMutex);
+    if (!currentDatabase.empty()) {
+        OpenDatabase& previous = openDatabases[currentDatabase];
+        previous.snapshot = acquireSnapshot();
+        previous.tableLocks = std::move(tableLocks);
+        previous.lastUse = ++databaseClock;
+    }
+    currentDatabase = dbName;
+    tableLocks.clear();
+    
+    auto cached = openDatabases.find(dbName);
+    if (cached == openDatabases.end()) {
+        trimOpenDatabases();
+        return loadFromFile();
+    }
+    tableLocks = std::move(cached->second.tableLocks);
+    {
+        std::lock_guard<std::mutex> commitLock(commitMutex);
+        std::atomic_store(&snapshot, cached->second.snapshot);
+    }
+    openDatabases.erase(cached);
+    trimOpenDatabases();
+    return true;
+}
+
+DatabaseManager::SnapshotPtr DatabaseManager::databaseSnapshot(const std::string& dbName) const {
+    if (dbName.empty() || dbName.find_first_of("/\\") != std::string::npos) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(openDatabasesMutex);
+    if (dbName == currentDatabase) {
+        return acquireSnapshot();
+    }
+    
+    auto it = openDatabases.find(dbName);
+    if (it == openDatabases.end()) {
+        TRACE_SCOPE("DatabaseManager::openDatabase", "persist", dbName);
+        auto snap = std::make_shared<Snapshot>();
+        snap->database = dbName;
+        TableLocks locks;
+        if (!readCatalog(dbName, snap->tables, locks)) {
+            return nullptr;
+        }
+        it = openDatabases.emplace(dbName, OpenDatabase{std::move(snap), std::move(locks), 0}).first;
+    }
+    it->second.lastUse = ++databaseClock;
+    SnapshotPtr snap = it->second.snapshot;
+    trimOpenDatabases();
+    return snap;
+}
+
+void DatabaseManager::trimOpenDatabases() const {
+    while (openDatabases.size() > OPEN_DATABASE_LIMIT) {
+        auto oldest = std::min_element(openDatabases.begin(), openDatabases.end(),
+            [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+        for (const auto& [name, version] : oldest->second.snapshot->tables) {
+            bufferPool.dropFile(version->id);
+        }
+        openDatabases.erase(oldest);
+    }
+}
+
+DatabaseManager::TableHandle DatabaseManager::tableData(const TableVersion& version) const {
+    version.previousAccess = version.lastAccess.exchange(++accessClock);
+    std::lock_guard<std::mutex> lock(version.mutex);
+    if (version.table) {
+        return version.table;
+    }
+    
+    TRACE_SCOPE("DatabaseManager::loadTable", "persist", version.name);
+    std::ifstream file(version.file, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("无法打开表文件: " + version.file.string());
+    }
+    Table table;
+    if (version.file.extension() == ".tbl") {
+        table = readTableFile(file, version.name, loadPool(false));
+    } else if (!readTextTableFile(file, version.name, table, loadPool(false))) {
+        throw std::runtime_error("表文件为空: " + version.file.string());
+    }
+    
+    TableStats stats;
+    if (readStatsFile(version.file, table.getColumns(), stats)) {
+        table.setStats(std::move(stats));
+    }
+    
+    version.table = std::make_shared<Table>(std::move(table));
+    version.memoryBytes = 0;
+    return version.table;
+}
+
+void DatabaseManager::setTableMemoryLimit(size_t bytes) {
+    tableMemoryLimit = bytes;
+    evictColdTables();
+}
+
+void DatabaseManager::setBufferPoolSize(size_t bytes) {
+    bufferPool.setCapacity(bytes);
+}
+
+BufferPool::Stats DatabaseManager::getBufferPoolStats() const {
+    return bufferPool.getStats();
+}
+
+void DatabaseManager::setLoadThreads(size_t threads) {
+    std::lock_guard<std::mutex> lock(loadPoolMutex);
+    loadThreads = threads;
+    tablePool.reset();
+    blockPool.reset();
+}
+
+ThreadPool* DatabaseManager::loadPool(bool tables) const {
+    std::lock_guard<std::mutex> lock(loadPoolMutex);
+    size_t threads = loadThreads > 0 ? loadThreads : std::thread::hardware_concurrency();
+    if (threads <= 1) {
+        return nullptr;
+    }
+    auto& pool = tables ? tablePool : blockPool;
+    if (!pool) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+    return pool.get();
+}
+
+void DatabaseManager::loadTables(const std::vector<const TableVersion*>& versions) const {
+    std::vector<const TableVersion*> unloaded;
+    for (const TableVersion* version : versions) {
+        std::lock_guard<std::mutex> lock(version->mutex);
+        if (!version->table) {
+            unloaded.push_back(version);
+        }
+    }
+    ThreadPool* pool = unloaded.size() > 1 ? loadPool(true) : nullptr;
+    if (!pool) {
+        for (const TableVersion* version : unloaded) {
+            tableData(*version);
+        }
+        return;
+    }
+    
+    std::vector<std::future<TableHandle>> results;
+    for (const TableVersion* version : unloaded) {
+        results.push_back(pool->async([this, version]() { return tableData(*version); }));
+    }
+    for (auto& result : results) {
+        result.wait();
+    }
+    for (auto& result : results) {
+        result.get();
+    }
+}
+
+void DatabaseManager::preloadTables() {
+    TRACE_SCOPE("DatabaseManager::preloadTables", "persist", currentDatabase);
+    auto snap = acquireSnapshot();
+    std::vector<const TableVersion*> versions;
+    for (const auto& [name, version] : snap->tables) {
+        versions.push_back(version.get());
+    }
+    loadTables(versions);
+    evictColdTables();
+}
+
+void DatabaseManager::evictColdTables() const {
+    size_t limit = tableMemoryLimit;
+    if (limit == 0) {
+        return;
+    }
+    
+    // 当前数据库和缓存中打开的数据库一起计算；缓存中的数据库在持有 catalogMutex 期间不会
+    // 变成当前数据库，不会被修改
+    std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+    std::vector<SnapshotPtr> snapshots{acquireSnapshot()};
+    {
+        std::lock_guard<std::mutex> lock(openDatabasesMutex);
+        for (const auto& [name, database] : openDatabases) {
+            snapshots.push_back(database.snapshot);
+        }
+    }
+    std::vector<const TableVersion*> loaded;
+    std::set<const TableVersion*> cached;
+    size_t total = 0;
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        for (const auto& [name, version] : snapshots[i]->tables) {
+            std::lock_guard<std::mutex> lock(version->mutex);
+            if (version->table) {
+                if (version->memoryBytes == 0) {
+                    version->memoryBytes = version->table->memoryBytes();
                 }
-                
-                // 创建表并插入到map中
-                Table table(tableName, columns);
-                
-                // 读取数据
-                while (std::getline(file, line)) {
-                    std::vector<std::string> values;
-                    std::istringstream rowIss(line);
-                    std::string value;
-                    while (std::getline(rowIss, value, ',')) {
-                        values.push_back(value);
-                    }
-                    table.insertRow(values);
+                total += version->memoryBytes;
+                loaded.push_back(version.get());
+                if (i > 0) {
+                    cached.insert(version.get());
                 }
-                
-                tables.emplace(tableName, std::move(table));
             }
         }
-        return true;
-    } catch (const std::exception& e) {
-        throw std::runtime_error("加载数据库失败: " + std::string(e.what()));
+    }
+    if (total <= limit) {
+        return;
+    }
+    
+    // 最近访问的一张表总是保留，其余按 LRU-2 卸载：倒数第二次访问最早的先卸载，只访问过
+    // 一次的表最先卸载（彼此之间按最近一次访问），一次性查询的大表不会挤掉常用的表
+    auto mostRecent = std::max_element(loaded.begin(), loaded.end(),
+        [](const TableVersion* a, const TableVersion* b) { return a->lastAccess < b->lastAccess; });
+    loaded.erase(mostRecent);
+    std::sort(loaded.begin(), loaded.end(), [](const TableVersion* a, const TableVersion* b) {
+        uint64_t aPrevious = a->previousAccess, bPrevious = b->previousAccess;
+        if (aPrevious != bPrevious) {
+            return aPrevious < bPrevious;
+        }
+        return a->lastAccess < b->lastAccess;
+    });
+    for (const TableVersion* version : loaded) {
+        if (total <= limit) {
+            break;
+        }
+        if (!version->persisted) {
+            continue;
+        }
+        
+        // 当前数据库中正在被修改的表跳过；持有表锁时当前版本与表文件一致（已保存的版本）才能卸载
+        std::unique_lock<std::mutex> tableLock;
+        if (cached.count(version) == 0) {
+            auto lockIt = tableLocks.find(version->name);
+            if (lockIt == tableLocks.end()) {
+                continue;
+            }
+            tableLock = std::unique_lock<std::mutex>(*lockIt->second, std::try_to_lock);
+            if (!tableLock.owns_lock() || !version->persisted) {
+                continue;
+            }
+            auto current = acquireSnapshot();
+            auto it = current->tables.find(version->name);
+            if (it == current->tables.end() || it->second.get() != version) {
+                continue;
+            }
+        }
+        
+        TRACE_SCOPE("DatabaseManager::evictTable", "persist", version->name);
+        std::lock_guard<std::mutex> lock(version->mutex);
+        total -= version->memoryBytes;
+        version->table.reset();
+        version->memoryBytes = 0;
     }
 }
 
 void DatabaseManager::setDbPath(const std::string& path) {
+    std::unique_lock<std::shared_mutex> catalogLock(catalogMutex);
+    flushDirtyTables();
     dbPath = path;
+    queryStats.setSlowLogPath(path + "/slow_query.log");
+    {
+        // 缓存中的数据库属于原来的数据目录
+        std::lock_guard<std::mutex> lock(openDatabasesMutex);
+        openDatabases.clear();
+    }
     
     try {
         // 确保数据目录存在
@@ -277,190 +1047,429 @@ void DatabaseManager::setDbPath(const std::string& path) {
 
 std::vector<std::string> DatabaseManager::getTableList() {
     std::vector<std::string> tableNames;
-    for (const auto& [name, _] : tables) {
+    auto snap = acquireSnapshot();
+    for (const auto& [name, _] : snap->tables) {
         tableNames.push_back(name);
     }
     return tableNames;
 }
 
 std::vector<std::vector<std::string>> DatabaseManager::executeSelect(
-    const SQLParser::ParsedQuery& query) {
+    const SQLParser::ParsedQuery& query, QueryProfile* profile) {
     
+    TRACE_SCOPE("DatabaseManager::executeSelect", "query", query.sql);
     try {
-        // 检查是否是多表查询
-        if (!query.joinTables.empty() || query.tableName.find(',') != std::string::npos) {
-            return executeMultiTableSelect(query);
-        }
+        auto start = QueryProfile::now();
         
-        // 单表查询的原有逻辑
-        const Table& table = getTable(query.tableName);
+        // 整个查询读取同一个快照，不受并发写入影响
+        auto snap = withSystemTables(query, acquireSnapshot());
         
-        // 检查是否有聚合函数或分组
-        bool hasAggregates = false;
-        for (const auto& col : query.columns) {
-            if (col.aggregateFunc != SQLParser::AggregateFunction::NONE) {
-                hasAggregates = true;
-                break;
-            }
+        if (query.explain) {
+            auto plan = explainSelect(query, *snap);
+            evictColdTables();
+            return plan;
         }
         
-        if (hasAggregates || !query.groupByColumns.empty()) {
-            return table.selectWithAggregates(
-                query.columns,
-                query.whereClause,
-                query.groupByColumns,
-                query.havingClause
-            );
-        }
-        
-        // 普通查询
-        std::vector<std::string> columnNames;
-        for (const auto& col : query.columns) {
-            columnNames.push_back(col.name);
-        }
-        
-        return table.select(
-            columnNames,
-            query.whereClause,
-            query.orderByColumn,
-            query.orderDesc
-        );
+        // 查询统计只需要扫描行数
+        QueryProfile statsProfile(false);
+        QueryProfile* activeProfile = profile ? profile : &statsProfile;
+        auto result = selectFromSnapshot(query, *snap, activeProfile);
+        recordQuery(query, start, activeProfile->getRowsExamined(), result.size());
+        evictColdTables();
+        return result;
     } catch (const std::exception& e) {
         throw std::runtime_error("查询执行失败: " + std::string(e.what()));
     }
 }
 
-// 添加新方法处理多表查询
-std::vector<std::vector<std::string>> DatabaseManager::executeMultiTableSelect(
-    const SQLParser::ParsedQuery& query) {
+std::vector<std::vector<std::string>> DatabaseManager::selectFromSnapshot(
+    const SQLParser::ParsedQuery& query, const Snapshot& snap, QueryProfile* profile) {
     
-    try {
-        // 解析所有表名
-        std::vector<std::string> tableNames;
-        std::vector<std::string> tableAliases;
-        
-        // 处理主表
-        size_t pos = 0;
-        std::string tables = query.tableName;
-        while (pos < tables.length()) {
-            size_t commaPos = tables.find(',', pos);
-            if (commaPos == std::string::npos) commaPos = tables.length();
-            
-            std::string tableDef = trim(tables.substr(pos, commaPos - pos));
-            std::istringstream iss(tableDef);
-            std::string tableName, alias;
-            iss >> tableName >> alias;
-            
-            tableNames.push_back(tableName);
-            tableAliases.push_back(alias.empty() ? tableName : alias);
-            
-            pos = commaPos + 1;
+    // 检查是否是多表查询
+    if (!query.joinTables.empty() || query.tableName.find(',') != std::string::npos) {
+        return executeMultiTableSelect(query, snap, profile);
+    }
+    
+    // 单表查询的原有逻辑
+    auto version = findVersion(snap, query.tableName);
+    std::vector<std::vector<std::string>> result;
+    if (version && selectByPages(query, *version, profile, result)) {
+        return result;
+    }
+    auto table = findTable(snap, query.tableName);
+    
+    if (hasAggregation(query)) {
+        return table->selectWithAggregates(
+            query.columns,
+            query.whereClause,
+            query.groupByColumns,
+            query.havingClause,
+            profile
+        );
+    }
+    
+    // 普通查询
+    std::vector<std::string> columnNames;
+    for (const auto& col : query.columns) {
+        columnNames.push_back(col.name);
+    }
+    
+    return table->select(
+        columnNames,
+        query.whereClause,
+        query.orderByColumn,
+        query.orderDesc,
+        profile
+    );
+}
+
+bool DatabaseManager::selectByPages(const SQLParser::ParsedQuery& query, const TableVersion& version,
+                                    QueryProfile* profile, std::vector<std::vector<std::string>>& result) {
+    // 按行存储的最小开销估算加载后的大小；超出已加载表数据的上限或缓冲池的容量时不整张加载
+    // （缓冲池容量为 0 表示不缓存页，此时只按上限判断）
+    size_t limit = tableMemoryLimit;
+    size_t poolBytes = bufferPool.getCapacity();
+    size_t estimate = version.rowCount * (sizeof(TableRow) + version.columns.size() * sizeof(std::string));
+    bool overLimit = limit != 0 && estimate > limit;
+    bool overPool = poolBytes != 0 && estimate > poolBytes;
+    if ((!overLimit && !overPool) || version.file.extension() != ".tbl") {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(version.mutex);
+        if (version.table) {
+            return false;
         }
-        
-        // 添加 JOIN 的表
-        for (const auto& joinTable : query.joinTables) {
-            tableNames.push_back(joinTable);
-            tableAliases.push_back(joinTable); // 可以根据需要处理别名
+    }
+    
+    // 只在打开表文件时短暂持有表锁：表文件整体替换（见 AtomicFile），打开的文件之后被替换
+    // 或删除也仍读到这个版本的内容，扫描不阻塞写入。当前版本以外的版本都已加载（修改前会先加载）
+    auto isCurrent = [this, &version]() {
+        auto current = acquireSnapshot();
+        auto it = current->tables.find(version.name);
+        return it != current->tables.end() && it->second.get() == &version;
+    };
+    std::ifstream file;
+    {
+        // 共享目录锁期间表不会被删除，表锁期间表文件不会被替换
+        std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+        if (!isCurrent()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> tableLock(lockForTable(version.name));
+        if (!isCurrent()) {
+            return false;
         }
+        file.open(version.file, std::ios::binary);
+    }
+    
+    TRACE_SCOPE("DatabaseManager::selectByPages", "scan", version.name);
+    auto scanStart = QueryProfile::now();
+    if (!file) {
+        throw std::runtime_error("无法打开表文件: " + version.file.string());
+    }
+    TableFile::Reader reader(file);
+    
+    // 没有聚合和排序时逐页投影；否则先收集满足条件的行，再在它们上执行原查询
+    std::vector<std::string> columnNames;
+    for (const auto& col : query.columns) {
+        columnNames.push_back(col.name);
+    }
+    bool materialize = hasAggregation(query) || !query.orderByColumn.empty();
+    Table matched(version.name, version.columns);
+    QueryProfile pageProfile(false);
+    size_t pages = 0;
+    size_t hits = 0;
+    for (uint64_t pageNo = 0; pageNo < reader.getBlockCount(); pageNo++) {
+        bool hit = false;
+        auto page = bufferPool.fetch(version.id, pageNo, [&]() {
+            std::string bytes;
+            std::vector<std::vector<std::string>> rows;
+            reader.readBlock(bytes);
+            reader.decodeBlock(bytes, rows);
+            Table block(version.name, version.columns);
+            block.appendRows(rows);
+            block.rebuildStructures();
+            return block;
+        }, &hit);
+        if (hit) {
+            reader.skipBlock();
+        }
+        pages++;
+        hits += hit ? 1 : 0;
         
-        // 获取所有表的数据
-        std::vector<const Table*> tables_ptrs;
-        for (const auto& name : tableNames) {
-            tables_ptrs.push_back(&getTable(name));
+        if (materialize) {
+            auto rows = page->select({"*"}, query.whereClause, "", false, &pageProfile);
+            matched.appendRows(rows);
+        } else {
+            auto rows = page->select(columnNames, query.whereClause, "", false, &pageProfile);
+            result.insert(result.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
         }
+    }
+    // 扫描期间这个版本被替换时，替换时丢弃的页可能又被读入，不会再被访问
+    if (!isCurrent()) {
+        bufferPool.dropFile(version.id);
+    }
+    if (profile) {
+        profile->addRowsExamined(pageProfile.getRowsExamined());
+        profile->addStage("分页扫描", "缓冲池 " + std::to_string(pages) + " 页，命中 " + std::to_string(hits) + " 页",
+                          version.rowCount, materialize ? matched.getData().size() : result.size(), scanStart);
+    }
+    if (!materialize) {
+        return true;
+    }
+    
+    matched.rebuildStructures();
+    if (hasAggregation(query)) {
+        result = matched.selectWithAggregates(query.columns, "", query.groupByColumns, query.havingClause, profile);
+    } else {
+        result = matched.select(columnNames, "", query.orderByColumn, query.orderDesc, profile);
+    }
+    return true;
+}
+
+std::vector<std::vector<std::string>> DatabaseManager::explainSelect(
+    const SQLParser::ParsedQuery& query, const Snapshot& snap) {
+    
+    TRACE_SCOPE("DatabaseManager::explainSelect", "plan");
+    std::vector<std::vector<std::string>> plan;
+    auto addRow = [&plan](const std::vector<std::string>& row) {
+        plan.push_back(row);
+        plan.back().insert(plan.back().begin(), std::to_string(plan.size()));
+    };
+    
+    if (query.explainAnalyze) {
+        SQLParser::ParsedQuery plainQuery = query;
+        plainQuery.explain = false;
+        plainQuery.explainAnalyze = false;
         
-        // 生成笛卡尔积
-        std::vector<std::vector<std::string>> result = generateCartesianProduct(tables_ptrs);
+        QueryProfile profile;
+        QueryProfile::Stage parse;
+        parse.operation = "解析";
+        parse.detail = "SQL 文本";
+        parse.elapsedMs = query.parseTimeMs;
+        profile.addStage(parse);
         
-        // 应用 WHERE 条件
-        std::vector<std::vector<std::string>> filtered;
-        for (const auto& row : result) {
-            if (evaluateJoinCondition(row, query.whereClause, tableNames, tableAliases)) {
-                filtered.push_back(row);
-            }
+        auto result = selectFromSnapshot(plainQuery, snap, &profile);
+        
+        auto formatMs = [](double ms) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(3) << ms;
+            return out.str();
+        };
+        auto formatKb = [](size_t bytes) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(1) << bytes / 1024.0;
+            return out.str();
+        };
+        
+        for (const auto& stage : profile.getStages()) {
+            addRow({stage.operation, stage.detail,
+                    std::to_string(stage.rowsIn), std::to_string(stage.rowsOut),
+                    formatMs(stage.elapsedMs), formatKb(stage.memoryBytes)});
         }
+        plan.push_back({"", "总计", "内存为中间结果的估算值，此行为峰值",
+                        "", std::to_string(result.size()),
+                        formatMs(profile.totalMs()), formatKb(profile.peakMemoryBytes())});
+        return plan;
+    }
+    
+    // 只描述计划，不执行查询
+    if (!query.joinTables.empty() || query.tableName.find(',') != std::string::npos) {
+        JoinPlanner planner = makeJoinPlanner(query, snap);
+        JoinPlanner::Plan joinPlan = planner.optimize();
         
-        // 选择需要的列
-        std::vector<std::vector<std::string>> finalResult;
-        for (const auto& row : filtered) {
-            std::vector<std::string> selectedRow;
-            for (const auto& col : query.columns) {
-                // 处理表别名
-                std::string tableName;
-                std::string colName = col.name;
-                
-                if (!col.tableAlias.empty()) {
-                    // 找到对应的实际表名
-                    auto it = std::find(tableAliases.begin(), tableAliases.end(), col.tableAlias);
-                    if (it != tableAliases.end()) {
-                        tableName = tableNames[it - tableAliases.begin()];
-                    }
-                }
-                
-                // 在对应表中找到列的位置
-                size_t tableOffset = 0;
-                size_t colIndex = 0;
-                bool found = false;
-                
-                for (size_t i = 0; i < tables_ptrs.size(); i++) {
-                    if (tableName.empty() || tableNames[i] == tableName) {
-                        try {
-                            colIndex = tables_ptrs[i]->getColumnIndex(colName);
-                            found = true;
-                            colIndex += tableOffset;
-                            break;
-                        } catch (...) {
-                            // 继续查找下一个表
-                        }
-                    }
-                    tableOffset += tables_ptrs[i]->getColumns().size();
-                }
-                
-                if (!found) {
-                    throw std::runtime_error("列不存在: " + col.name);
-                }
-                
-                selectedRow.push_back(row[colIndex]);
+        addRow({"连接顺序", planner.describeOrder(joinPlan), std::to_string(std::llround(joinPlan.rows))});
+        addRow({"全表扫描", planner.describeScan(joinPlan.first),
+                std::to_string(std::llround(planner.scanRows(joinPlan.first)))});
+        for (const auto& step : joinPlan.steps) {
+            addRow({JoinPlanner::methodName(step.method), planner.describeStep(step),
+                    std::to_string(std::llround(step.rows))});
+        }
+        if (!joinPlan.finalFilters.empty()) {
+            addRow({"过滤", "WHERE " + planner.describePredicates(joinPlan.finalFilters),
+                    std::to_string(std::llround(joinPlan.rows))});
+        }
+        addRow({"投影", std::to_string(query.columns.size()) + " 列", "-"});
+        return plan;
+    }
+    
+    auto table = findTable(snap, query.tableName);
+    addRow({"全表扫描", table->describeScan(query.whereClause),
+            std::to_string(std::llround(table->estimateRows(query.whereClause)))});
+    if (hasAggregation(query)) {
+        if (!query.groupByColumns.empty()) {
+            std::string detail = "GROUP BY ";
+            for (size_t i = 0; i < query.groupByColumns.size(); i++) {
+                detail += (i > 0 ? ", " : "") + query.groupByColumns[i];
             }
-            finalResult.push_back(selectedRow);
+            addRow({"分组", detail + "（有序映射）", "-"});
         }
+        addRow({"聚合", Table::describeAggregates(query.columns, query.groupByColumns, query.havingClause), "-"});
+    } else if (!query.orderByColumn.empty()) {
+        addRow({"排序", Table::describeSort(query.orderByColumn, query.orderDesc), "-"});
+    }
+    return plan;
+}
+
+// 其他数据库的表（db.table）没有别名时以表名引用
+static std::string unqualifiedName(const std::string& tableName) {
+    size_t dot = tableName.find('.');
+    return dot == std::string::npos ? tableName : tableName.substr(dot + 1);
+}
+
+void DatabaseManager::collectQueryTables(const SQLParser::ParsedQuery& query,
+                                         std::vector<std::string>& tableNames,
+                                         std::vector<std::string>& tableAliases) {
+    // 处理主表
+    size_t pos = 0;
+    std::string tables = query.tableName;
+    while (pos < tables.length()) {
+        size_t commaPos = tables.find(',', pos);
+        if (commaPos == std::string::npos) commaPos = tables.length();
         
-        return finalResult;
-    } catch (const std::exception& e) {
-        throw std::runtime_error("多表查询执行失败: " + std::string(e.what()));
+        std::string tableDef = trim(tables.substr(pos, commaPos - pos));
+        std::istringstream iss(tableDef);
+        std::string tableName, alias;
+        iss >> tableName >> alias;
+        
+        // 单张主表的别名单独保存在 tableAlias 中
+        if (alias.empty() && tables.find(',') == std::string::npos) {
+            alias = query.tableAlias;
+        }
+        tableNames.push_back(tableName);
+        tableAliases.push_back(alias.empty() ? unqualifiedName(tableName) : alias);
+        
+        pos = commaPos + 1;
+    }
+    
+    // 添加 JOIN 的表
+    for (size_t i = 0; i < query.joinTables.size(); i++) {
+        const std::string& alias = i < query.joinTableAliases.size() ? query.joinTableAliases[i] : "";
+        tableNames.push_back(query.joinTables[i]);
+        tableAliases.push_back(alias.empty() ? unqualifiedName(query.joinTables[i]) : alias);
     }
 }
 
-// 辅助方法：生成笛卡尔积
-std::vector<std::vector<std::string>> DatabaseManager::generateCartesianProduct(
-    const std::vector<const Table*>& tables) {
+JoinPlanner DatabaseManager::makeJoinPlanner(const SQLParser::ParsedQuery& query, const Snapshot& snap) const {
+    TRACE_SCOPE("DatabaseManager::resolveTables", "plan");
+    std::vector<std::string> tableNames;
+    std::vector<std::string> tableAliases;
+    collectQueryTables(query, tableNames, tableAliases);
     
-    std::vector<std::vector<std::string>> result;
-    result.push_back(std::vector<std::string>());
+    // FROM 中逗号分隔的表都是内连接，JOIN 的表排在最后
+    size_t fromTables = tableNames.size() - query.joinTables.size();
+    auto joinType = [&query](size_t i) {
+        return i < query.joinTypes.size() ? query.joinTypes[i] : SQLParser::JoinType::INNER;
+    };
+    
+    // 各表的数据同时加载
+    std::vector<TableVersionPtr> found;
+    std::vector<const TableVersion*> versions;
+    for (const auto& tableName : tableNames) {
+        if (auto version = findVersion(snap, tableName)) {
+            versions.push_back(version.get());
+            found.push_back(std::move(version));
+        }
+    }
+    loadTables(versions);
     
-    for (const auto& table : tables) {
-        std::vector<std::vector<std::string>> newResult;
-        for (const auto& existingRow : result) {
-            for (const auto& tableRow : table->getData()) {
-                std::vector<std::string> combinedRow = existingRow;
-                combinedRow.insert(combinedRow.end(), tableRow.begin(), tableRow.end());
-                newResult.push_back(combinedRow);
+    std::vector<JoinPlanner::Relation> relations;
+    for (size_t i = 0; i < tableNames.size(); i++) {
+        JoinPlanner::Relation relation;
+        relation.name = tableNames[i];
+        relation.alias = tableAliases[i];
+        relation.table = findTable(snap, tableNames[i]);
+        if (i >= fromTables) {
+            switch (joinType(i - fromTables)) {
+                case SQLParser::JoinType::LEFT: relation.joinType = JoinType::LEFT; break;
+                case SQLParser::JoinType::RIGHT: relation.joinType = JoinType::RIGHT; break;
+                case SQLParser::JoinType::FULL: relation.joinType = JoinType::FULL; break;
+                default: relation.joinType = JoinType::INNER; break;
             }
         }
-        result = std::move(newResult);
+        relations.push_back(relation);
     }
     
-    return result;
+    // 内连接的 ON 条件与 WHERE 等价，外连接的 ON 条件只在该表连接时求值
+    JoinPlanner planner(std::move(relations));
+    planner.addConditions(query.whereClause);
+    for (size_t i = 0; i < query.joinConditions.size(); i++) {
+        bool outer = joinType(i) != SQLParser::JoinType::INNER && joinType(i) != SQLParser::JoinType::NONE;
+        planner.addConditions(query.joinConditions[i], outer ? fromTables + i : JoinPlanner::NONE);
+    }
+    return planner;
+}
+
+std::vector<std::vector<std::string>> DatabaseManager::executeMultiTableSelect(
+    const SQLParser::ParsedQuery& query, const Snapshot& snap, QueryProfile* profile) {
+    
+    try {
+        JoinPlanner planner = makeJoinPlanner(query, snap);
+        auto tuples = planner.execute(planner.optimize(), profile);
+        
+        // 选择需要的列，列位置只解析一次
+        auto projectStart = QueryProfile::now();
+        const auto& relations = planner.getRelations();
+        std::vector<std::pair<size_t, size_t>> outputColumns;  // (表, 列)
+        for (const auto& col : query.columns) {
+            if (col.name == "*" && col.aggregateFunc == SQLParser::AggregateFunction::NONE) {
+                for (size_t r = 0; r < relations.size(); r++) {
+                    for (size_t c = 0; c < relations[r].table->getColumns().size(); c++) {
+                        outputColumns.emplace_back(r, c);
+                    }
+                }
+                continue;
+            }
+            
+            std::string expr = col.tableAlias.empty() ? col.name : col.tableAlias + "." + col.name;
+            size_t relation = 0;
+            size_t column = 0;
+            if (!planner.resolveColumn(expr, relation, column)) {
+                throw std::runtime_error("列不存在: " + col.name);
+            }
+            outputColumns.emplace_back(relation, column);
+        }
+        
+        std::vector<std::vector<std::string>> finalResult;
+        finalResult.reserve(tuples.size());
+        for (const auto& tuple : tuples) {
+            std::vector<std::string> selectedRow;
+            selectedRow.reserve(outputColumns.size());
+            for (const auto& [relation, column] : outputColumns) {
+                // 外连接补齐的一侧输出 NULL
+                selectedRow.push_back(tuple[relation] ? (*tuple[relation])[column] : "NULL");
+            }
+            finalResult.push_back(std::move(selectedRow));
+        }
+        if (profile) {
+            profile->addStage("投影", std::to_string(outputColumns.size()) + " 列",
+                              tuples.size(), finalResult.size(), projectStart, &finalResult);
+        }
+        
+        return finalResult;
+    } catch (const std::exception& e) {
+        throw std::runtime_error("多表查询执行失败: " + std::string(e.what()));
+    }
 }
 
 bool DatabaseManager::executeNonQuery(const SQLParser::ParsedQuery& query) {
+    TRACE_SCOPE("DatabaseManager::executeNonQuery", "query", query.sql);
     try {
+        auto start = QueryProfile::now();
+        
         // 检查数据库是否已选择
-        if (currentDatabase.empty()) {
+        if (getCurrentDatabase().empty()) {
             throw std::runtime_error("未选择数据库");
         }
+        // 其他数据库（db.table）只能查询
+        if (query.tableName.find('.') != std::string::npos) {
+            throw std::runtime_error("只能修改当前数据库中的表: " + query.tableName);
+        }
 
+        // 各操作在自己的锁内完成修改并保存受影响的表
         bool success = false;
+        size_t rowsExamined = 0;  // UPDATE/DELETE 扫描整张表
         if (query.type == "CREATE") {
             std::vector<ColumnDef> columns;
             for (const auto& col : query.columns) {
@@ -469,6 +1478,7 @@ bool DatabaseManager::executeNonQuery(const SQLParser::ParsedQuery& query) {
                 colDef.type = col.type;
                 colDef.nullable = col.nullable;
                 colDef.primaryKey = col.primaryKey;
+                colDef.bloomFilter = col.bloomFilter;
                 columns.push_back(colDef);
             }
             success = createTable(query.tableName, columns);
@@ -477,30 +1487,61 @@ bool DatabaseManager::executeNonQuery(const SQLParser::ParsedQuery& query) {
                                     std::vector<std::string>(),
                                     query.values);
         } else if (query.type == "UPDATE") {
-            auto it = tables.find(query.tableName);
-            if (it == tables.end()) {
+            if (acquireSnapshot()->tables.count(query.tableName) == 0) {
                 throw std::runtime_error("表不存在: " + query.tableName);
             }
             
             // 如果有更新列和值，执行更新操作
             if (!query.updateColumns.empty()) {
-                success = it->second.updateRows(
-                    query.updateColumns,
-                    query.updateValues,
-                    query.whereClause
-                );
+                success = modifyTable(query.tableName, [&](Table& table) {
+                    rowsExamined = table.getData().size();
+                    return table.updateRows(
+                        query.updateColumns,
+                        query.updateValues,
+                        query.whereClause
+                    );
+                });
             } else {
                 // 如果没有更新列和值，只触发保存
-                success = true;
+                success = modifyTable(query.tableName, [](Table&) { return true; });
             }
         } else if (query.type == "DELETE") {
-            auto it = tables.find(query.tableName);
-            if (it == tables.end()) {
+            if (acquireSnapshot()->tables.count(query.tableName) == 0) {
                 throw std::runtime_error("表不存在: " + query.tableName);
             }
             
             // 执行删除操作
-            success = it->second.deleteRows(query.whereClause);
+            success = modifyTable(query.tableName, [&](Table& table) {
+                rowsExamined = table.getData().size();
+                return table.deleteRows(query.whereClause);
+            });
+        } else if (query.type == "ANALYZE") {
+            std::vector<std::string> tableNames;
+            if (query.tableName.empty()) {
+                tableNames = getTableList();
+            } else {
+                tableNames.push_back(query.tableName);
+            }
+            
+            success = true;
+            for (const auto& name : tableNames) {
+                if (acquireSnapshot()->tables.count(name) == 0) {
+                    throw std::runtime_error("表不存在: " + name);
+                }
+                rowsExamined += getTable(name)->getData().size();
+                success = analyzeTable(name) && success;
+            }
+        } else if (query.type == "ALTER") {
+            if (acquireSnapshot()->tables.count(query.tableName) == 0) {
+                throw std::runtime_error("表不存在: " + query.tableName);
+            }
+            
+            std::vector<std::string> columnNames;
+            for (const auto& col : query.columns) {
+                columnNames.push_back(col.name);
+            }
+            rowsExamined = getTable(query.tableName)->getData().size();
+            success = setBloomFilter(query.tableName, columnNames, query.alterAction == "ADD BLOOM FILTER");
         } else if (query.type == "DROP") {
             // 执行DROP TABLE
             success = dropTable(query.tableName);
@@ -509,11 +1550,8 @@ bool DatabaseManager::executeNonQuery(const SQLParser::ParsedQuery& query) {
             }
         }
 
-        // 如果操作成功，保存到文件
-        if (success) {
-            return saveToFile();
-        }
-        return false;
+        recordQuery(query, start, rowsExamined, 0);
+        return success;
     } catch (const std::exception& e) {
         throw std::runtime_error("执行SQL失败: " + std::string(e.what()));
     }
@@ -524,37 +1562,215 @@ bool DatabaseManager::insertIntoTable(
     const std::vector<std::string>& columns,
     const std::vector<std::string>& values) {
     
-    auto it = tables.find(tableName);
-    if (it == tables.end()) {
+    if (acquireSnapshot()->tables.count(tableName) == 0) {
         return false;
     }
     
-    bool success = it->second.insertRow(values);
-    if (success) {
-        return saveToFile();
+    return modifyTable(tableName, [&](Table& table) {
+        return table.insertRow(values);
+    });
+}
+
+DatabaseManager::TableHandle DatabaseManager::getTable(const std::string& tableName) const {
+    if (auto systemTable = buildSystemTable(tableName)) {
+        return systemTable;
     }
-    return false;
+    
+    auto table = findTable(*acquireSnapshot(), tableName);
+    evictColdTables();
+    return table;
 }
 
-const Table& DatabaseManager::getTable(const std::string& tableName) const {
-    auto it = tables.find(tableName);
-    if (it == tables.end()) {
+std::vector<std::string> DatabaseManager::getResultHeaders(const SQLParser::ParsedQuery& query) const {
+    if (query.explainAnalyze) {
+        return {"步骤", "操作", "详情", "输入行数", "输出行数", "耗时(ms)", "内存(KB)"};
+    }
+    if (query.explain) {
+        return {"步骤", "操作", "详情", "预计行数"};
+    }
+    
+    std::vector<std::string> headers;
+    
+    if (query.columns.size() == 1 && query.columns[0].name == "*") {
+        // 多表查询时依次列出各表的列；列定义在表版本中，不需要加载表数据
+        std::vector<std::string> tableNames, tableAliases;
+        collectQueryTables(query, tableNames, tableAliases);
+        auto snap = acquireSnapshot();
+        for (const auto& name : tableNames) {
+            auto version = findVersion(*snap, name);
+            TableHandle systemTable = version ? nullptr : getTable(name);
+            const auto& columns = systemTable ? systemTable->getColumns() : version->columns;
+            for (const auto& col : columns) {
+                headers.push_back(col.name);
+            }
+        }
+    } else {
+        for (const auto& col : query.columns) {
+            headers.push_back(col.name);
+        }
+    }
+    return headers;
+}
+
+DatabaseManager::TableVersionPtr DatabaseManager::findVersion(const Snapshot& snap, const std::string& tableName) const {
+    const Snapshot* target = &snap;
+    SnapshotPtr other;
+    std::string name = tableName;
+    size_t dot = tableName.find('.');
+    if (dot != std::string::npos) {
+        std::string database = tableName.substr(0, dot);
+        name = tableName.substr(dot + 1);
+        if (database != snap.database) {
+            other = databaseSnapshot(database);
+            if (!other) {
+                throw std::runtime_error("数据库不存在: " + database);
+            }
+            target = other.get();
+        }
+    }
+    auto it = target->tables.find(name);
+    return it == target->tables.end() ? nullptr : it->second;
+}
+
+DatabaseManager::TableHandle DatabaseManager::findTable(const Snapshot& snap, const std::string& tableName) const {
+    auto version = findVersion(snap, tableName);
+    if (!version) {
         throw std::runtime_error("表不存在: " + tableName);
     }
-    return it->second;
+    return tableData(*version);
+}
+
+bool DatabaseManager::replaceTable(const std::string& tableName, Table newTable) {
+    std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+    std::lock_guard<std::mutex> tableLock(lockForTable(tableName));
+    
+    return commitAndSave(tableName, std::make_shared<Table>(std::move(newTable)));
+}
+
+DatabaseManager::SnapshotPtr DatabaseManager::acquireSnapshot() const {
+    return std::atomic_load(&snapshot);
+}
+
+// 调用者需持有 catalogMutex
+std::mutex& DatabaseManager::lockForTable(const std::string& tableName) const {
+    auto it = tableLocks.find(tableName);
+    if (it == tableLocks.end()) {
+        throw std::runtime_error("表不存在: " + tableName);
+    }
+    return *it->second;
+}
+
+bool DatabaseManager::modifyTable(const std::string& tableName,
+                                  const std::function<bool(Table&)>& mutator) {
+    TRACE_SCOPE("DatabaseManager::modifyTable", "write", tableName);
+    
+    // 共享目录锁保证表在修改期间不会被删除，表锁使同一张表的写者串行化，
+    // 不同表的写者可以并行执行
+    bool saved;
+    {
+        std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+        std::lock_guard<std::mutex> tableLock(lockForTable(tableName));
+        
+        auto current = acquireSnapshot();
+        auto it = current->tables.find(tableName);
+        if (it == current->tables.end()) {
+            throw std::runtime_error("表不存在: " + tableName);
+        }
+        
+        // 在副本上修改，失败或抛出异常时已发布的版本保持不变
+        auto newVersion = std::make_shared<Table>(*tableData(*it->second));
+        if (!mutator(*newVersion)) {
+            return false;
+        }
+        
+        saved = commitAndSave(tableName, newVersion);
+    }
+    evictColdTables();
+    return saved;
+}
+
+DatabaseManager::TableVersionPtr DatabaseManager::commitTable(const std::string& tableName,
+                                                              std::shared_ptr<const Table> newVersion) {
+    std::shared_ptr<TableVersion> version;
+    if (newVersion) {
+        version = std::make_shared<TableVersion>();
+        version->name = tableName;
+        version->file = std::filesystem::path(dbPath) / currentDatabase / (tableName + ".tbl");
+        version->columns = newVersion->getColumns();
+        version->id = ++nextVersionId;
+        version->rowCount = newVersion->getData().size();
+        version->table = std::move(newVersion);
+        version->lastAccess = ++accessClock;
+    }
+    
+    std::lock_guard<std::mutex> lock(commitMutex);
+    auto current = acquireSnapshot();
+    auto next = std::make_shared<Snapshot>();
+    next->commitTs = current->commitTs + 1;
+    next->database = current->database;
+    next->tables = current->tables;
+    auto replaced = next->tables.find(tableName);
+    if (replaced != next->tables.end()) {
+        // 表文件将被覆盖或删除，旧版本的页不再有效
+        bufferPool.dropFile(replaced->second->id);
+    }
+    if (version) {
+        next->tables[tableName] = version;
+    } else {
+        next->tables.erase(tableName);
+    }
+    std::atomic_store(&snapshot, SnapshotPtr(std::move(next)));
+    return version;
+}
+
+// 调用者需持有 catalogMutex，并持有该表的写锁或独占目录锁
+bool DatabaseManager::commitAndSave(const std::string& tableName, std::shared_ptr<const Table> newVersion) {
+    auto version = commitTable(tableName, newVersion);
+    {
+        // 延迟保存：未写入表文件的版本不会被卸载，由后台线程写入
+        std::lock_guard<std::mutex> lock(autoSaveMutex);
+        if (autoSaveInterval.count() > 0) {
+            dirtyTables.insert(tableName);
+            return true;
+        }
+    }
+    bool saved = saveTableToFile(tableName, *newVersion);
+    version->persisted = saved;
+    return saved;
+}
+
+void DatabaseManager::commitTables(std::map<std::string, TableVersionPtr> tables) {
+    std::lock_guard<std::mutex> lock(commitMutex);
+    auto next = std::make_shared<Snapshot>();
+    auto current = acquireSnapshot();
+    if (current->database == currentDatabase) {
+        // 重新读取同一个数据库，旧版本的页不再使用；切换数据库时旧快照进入缓存，页仍然有效
+        for (const auto& [name, version] : current->tables) {
+            auto it = tables.find(name);
+            if (it == tables.end() || it->second != version) {
+                bufferPool.dropFile(version->id);
+            }
+        }
+    }
+    next->commitTs = current->commitTs + 1;
+    next->database = currentDatabase;
+    next->tables = std::move(tables);
+    std::atomic_store(&snapshot, SnapshotPtr(std::move(next)));
 }
 
 std::vector<std::string> DatabaseManager::getDatabaseList() {
     std::vector<std::string> databases;
     try {
+        std::string root = getDbPath();
+        
         // 确保数据目录存在
-        if (!std::filesystem::exists(dbPath)) {
-            std::filesystem::create_directories(dbPath);
+        if (!std::filesystem::exists(root)) {
+            std::filesystem::create_directories(root);
             return databases;
         }
         
         // 遍历数据目录
-        for (const auto& entry : std::filesystem::directory_iterator(dbPath)) {
+        for (const auto& entry : std::filesystem::directory_iterator(root)) {
             if (entry.is_directory()) {
                 databases.push_back(entry.path().filename().string());
             }
@@ -570,111 +1786,140 @@ std::vector<std::string> DatabaseManager::getDatabaseList() {
 }
 
 std::string DatabaseManager::getCurrentDatabase() const {
+    std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
     return currentDatabase;
 }
 
-bool DatabaseManager::evaluateJoinCondition(
-    const std::vector<std::string>& row,
-    const std::string& condition,
-    const std::vector<std::string>& tableNames,
-    const std::vector<std::string>& tableAliases) {
-    
-    if (condition.empty()) {
-        return true;
+std::string DatabaseManager::getDbPath() const {
+    std::shared_lock<std::shared_mutex> catalogLock(catalogMutex);
+    return dbPath;
+}
+
+QueryStats& DatabaseManager::getQueryStats() {
+    return queryStats;
+}
+
+void DatabaseManager::recordQuery(const SQLParser::ParsedQuery& query,
+                                  QueryProfile::Clock::time_point start,
+                                  size_t rowsExamined, size_t rowsReturned) {
+    double elapsedMs = std::chrono::duration<double, std::milli>(QueryProfile::now() - start).count();
+    // 手工构造的 ParsedQuery 没有原始语句，用类型和表名代替
+    const std::string& sql = query.sql.empty() ? query.type + " " + query.tableName : query.sql;
+    queryStats.record(sql, elapsedMs, rowsExamined, rowsReturned);
+}
+
+bool DatabaseManager::isSystemTable(const std::string& tableName) {
+    return tableName == SYS_QUERY_STATS || tableName == SYS_COLUMN_STATS;
+}
+
+DatabaseManager::TableHandle DatabaseManager::buildSystemTable(const std::string& tableName) const {
+    if (!isSystemTable(tableName)) {
+        return nullptr;
     }
     
-    try {
-        // 分割多个条件（用 AND 连接的条件）
-        std::vector<std::string> conditions;
-        size_t pos = 0;
-        while (pos < condition.length()) {
-            size_t andPos = condition.find("AND", pos);
-            if (andPos == std::string::npos) {
-                conditions.push_back(trim(condition.substr(pos)));
-                break;
-            }
-            conditions.push_back(trim(condition.substr(pos, andPos - pos)));
-            pos = andPos + 3;  // Skip "AND"
-        }
-        
-        // 评估每个条件
-        for (const auto& cond : conditions) {
-            // 查找操作符
-            std::vector<std::string> operators = {">=", "<=", "!=", "=", ">", "<"};
-            std::string op;
-            size_t opPos = std::string::npos;
-            
-            for (const auto& testOp : operators) {
-                if ((opPos = cond.find(testOp)) != std::string::npos) {
-                    op = testOp;
-                    break;
-                }
+    auto column = [](const std::string& name, const std::string& type) {
+        ColumnDef col;
+        col.name = name;
+        col.type = type;
+        return col;
+    };
+    
+    if (tableName == SYS_COLUMN_STATS) {
+        auto table = std::make_shared<Table>(SYS_COLUMN_STATS, std::vector<ColumnDef>{
+            column("table_name", "TEXT"),
+            column("column_name", "TEXT"),
+            column("row_count", "INTEGER"),
+            column("null_count", "INTEGER"),
+            column("distinct_estimate", "INTEGER"),
+            column("min_value", "TEXT"),
+            column("max_value", "TEXT"),
+            column("histogram_buckets", "INTEGER"),
+            column("modified_rows", "INTEGER"),
+        });
+        for (const auto& [name, version] : acquireSnapshot()->tables) {
+            // 未加载的表直接读取 .stats 文件，不为统计信息加载整张表（未加载的版本都已写入
+            // 表文件，.stats 文件与它一起保存）；没有统计信息的表跳过
+            TableHandle userTable;
+            {
+                std::lock_guard<std::mutex> lock(version->mutex);
+                userTable = version->table;
             }
-            
-            if (opPos == std::string::npos) {
-                throw std::runtime_error("无效的条件: " + cond);
+            TableStats fileStats;
+            if (!userTable && !readStatsFile(version->file, version->columns, fileStats)) {
+                continue;
+            }
+            const TableStats& stats = userTable ? userTable->getStats() : fileStats;
+            if (!stats.isAnalyzed()) {
+                continue;
+            }
+            for (size_t i = 0; i < stats.getColumns().size(); i++) {
+                const ColumnStats& col = stats.getColumns()[i];
+                table->insertRow({
+                    name,
+                    col.name,
+                    std::to_string(stats.getRowCount()),
+                    std::to_string(col.nullCount),
+                    std::to_string(stats.estimateDistinct(i)),
+                    col.minValue,
+                    col.maxValue,
+                    std::to_string(col.bucketBounds.size()),
+                    std::to_string(stats.getModifiedRows()),
+                });
             }
-            
-            // 获取左右值
-            std::string leftExpr = trim(cond.substr(0, opPos));
-            std::string rightExpr = trim(cond.substr(opPos + op.length()));
-            
-            // 处理表达式中的表别名
-            auto getColumnValue = [&](const std::string& expr) -> std::string {
-                // 检查是否是字面值（用引号括起来的）
-                if (expr[0] == '\'' || expr[0] == '"') {
-                    return expr.substr(1, expr.length() - 2);
-                }
-                
-                // 处理列引用
-                std::string tableAlias;
-                std::string colName = expr;
-                size_t dotPos = expr.find('.');
-                if (dotPos != std::string::npos) {
-                    tableAlias = expr.substr(0, dotPos);
-                    colName = expr.substr(dotPos + 1);
-                }
-                
-                // 找到对应的表
-                size_t tableOffset = 0;
-                for (size_t i = 0; i < tableAliases.size(); i++) {
-                    if (tableAlias.empty() || tableAliases[i] == tableAlias) {
-                        // 获取该表的列数
-                        const Table& table = getTable(tableNames[i]);
-                        try {
-                            size_t colIndex = table.getColumnIndex(colName);
-                            return row[tableOffset + colIndex];
-                        } catch (...) {
-                            if (!tableAlias.empty()) {
-                                throw;  // 如果指定了表别名但列不存在，则报错
-                            }
-                        }
-                    }
-                    const Table& table = getTable(tableNames[i]);
-                    tableOffset += table.getColumns().size();
-                }
-                throw std::runtime_error("列不存在: " + expr);
-            };
-            
-            // 获取实际值
-            std::string leftVal = getColumnValue(leftExpr);
-            std::string rightVal = getColumnValue(rightExpr);
-            
-            // 比较值
-            bool condResult;
-            if (op == "=") condResult = leftVal == rightVal;
-            else if (op == "!=") condResult = leftVal != rightVal;
-            else if (op == ">") condResult = leftVal > rightVal;
-            else if (op == "<") condResult = leftVal < rightVal;
-            else if (op == ">=") condResult = leftVal >= rightVal;
-            else if (op == "<=") condResult = leftVal <= rightVal;
-            else throw std::runtime_error("不支持的操作符: " + op);
-            
-            if (!condResult) return false;  // 如果任何条件不满足，返回false
         }
-        
-        return true;  // 所有条件都满足
-    } catch (const std::exception& e) {
-        throw std::runtime_error("条件评估失败: " + std::string(e.what()));
+        return table;
+    }
+    auto table = std::make_shared<Table>(SYS_QUERY_STATS, std::vector<ColumnDef>{
+        column("fingerprint", "TEXT"),
+        column("calls", "INTEGER"),
+        column("total_ms", "FLOAT"),
+        column("mean_ms", "FLOAT"),
+        column("p99_ms", "FLOAT"),
+        column("max_ms", "FLOAT"),
+        column("rows_examined", "INTEGER"),
+        column("rows_returned", "INTEGER"),
+    });
+    
+    auto formatMs = [](double ms) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3) << ms;
+        return out.str();
+    };
+    for (const auto& entry : queryStats.getEntries()) {
+        table->insertRow({
+            entry.fingerprint,
+            std::to_string(entry.calls),
+            formatMs(entry.totalMs),
+            formatMs(entry.meanMs),
+            formatMs(entry.p99Ms),
+            formatMs(entry.maxMs),
+            std::to_string(entry.rowsExamined),
+            std::to_string(entry.rowsReturned),
+        });
     }
-} 
\ No newline at end of file
+    return table;
+}
+
+DatabaseManager::SnapshotPtr DatabaseManager::withSystemTables(
+    const SQLParser::ParsedQuery& query, SnapshotPtr snap) const {
+    
+    std::vector<std::string> tableNames, tableAliases;
+    collectQueryTables(query, tableNames, tableAliases);
+    
+    std::shared_ptr<Snapshot> extended;
+    for (const auto& name : tableNames) {
+        if (!isSystemTable(name)) {
+            continue;
+        }
+        // 系统表不属于已提交的数据，只在本次查询的快照副本中出现
+        if (!extended) {
+            extended = std::make_shared<Snapshot>(*snap);
+        }
+        auto version = std::make_shared<TableVersion>();
+        version->name = name;
+        version->table = buildSystemTable(name);
+        version->columns = version->table->getColumns();
+        extended->tables[name] = std::move(version);
+    }
+    return extended ? extended : snap;
+}
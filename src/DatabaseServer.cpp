@@ -0,0 +1,157 @@
+#include "DatabaseServer.h"
+#include "WireProtocol.h"
+#include "SQLParser.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+DatabaseServer::DatabaseServer(DatabaseManager& manager,
+                               const std::string& path,
+                               int connections)
+    : dbManager(manager)
+    , socketPath(path)
+    , maxConnections(connections > 0 ? connections : 1)
+    , workers(static_cast<size_t>(maxConnections), static_cast<size_t>(maxConnections)) {
+}
+
+DatabaseServer::~DatabaseServer() {
+    stop();
+    workers.shutdown();
+}
+
+void DatabaseServer::run() {
+    running = true;
+    
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("套接字路径过长: " + socketPath);
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("创建套接字失败: " + std::string(std::strerror(errno)));
+    }
+    
+    // 清理上次异常退出留下的套接字文件
+    ::unlink(socketPath.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(fd, maxConnections) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("监听套接字失败: " + error);
+    }
+    
+    listenFd = fd;
+    while (running) {
+        int clientFd = ::accept(fd, nullptr, nullptr);
+        if (clientFd < 0) {
+            if (errno == EINTR) continue;
+            break;  // stop() 关闭了监听套接字
+        }
+        
+        // 会话数已达上限时拒绝新连接
+        bool accepted = false;
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            if (sessionCount < maxConnections) {
+                sessionCount++;
+                accepted = true;
+            }
+        }
+        if (accepted && !workers.submit([this, clientFd]() { serveSession(clientFd); })) {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            sessionCount--;
+            accepted = false;
+        }
+        if (!accepted) {
+            rejectConnection(clientFd, "连接数已达上限");
+        }
+    }
+    
+    running = false;
+    ::unlink(socketPath.c_str());
+}
+
+void DatabaseServer::stop() {
+    running = false;
+    int fd = listenFd.exchange(-1);
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+        ::close(fd);
+    }
+    
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    for (int fd : activeSessions) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void DatabaseServer::rejectConnection(int clientFd, const std::string& reason) {
+    try {
+        WireProtocol::writeMessage(clientFd, {WireProtocol::MessageType::ERROR, reason});
+    } catch (...) {
+        // 客户端已断开
+    }
+    ::close(clientFd);
+}
+
+void DatabaseServer::serveSession(int clientFd) {
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        if (!running) {
+            sessionCount--;
+            ::close(clientFd);
+            return;
+        }
+        activeSessions.insert(clientFd);
+    }
+    
+    SQLParser::SQLParser sqlParser;
+    try {
+        WireProtocol::Message request;
+        while (WireProtocol::readMessage(clientFd, request)) {
+            WireProtocol::Message response;
+            
+            if (request.type == WireProtocol::MessageType::PING) {
+                response.type = WireProtocol::MessageType::OK;
+            } else if (request.type == WireProtocol::MessageType::QUERY) {
+                try {
+                    auto query = sqlParser.parse(request.payload);
+                    if (query.type == "SELECT") {
+                        auto results = dbManager.executeSelect(query);
+                        response.type = WireProtocol::MessageType::RESULT;
+                        response.payload = WireProtocol::encodeResult(
+                            dbManager.getResultHeaders(query), results);
+                    } else if (dbManager.executeNonQuery(query)) {
+                        response.type = WireProtocol::MessageType::OK;
+                    } else {
+                        response.type = WireProtocol::MessageType::ERROR;
+                        response.payload = "执行失败";
+                    }
+                } catch (const std::exception& e) {
+                    response.type = WireProtocol::MessageType::ERROR;
+                    response.payload = e.what();
+                }
+            } else {
+                response.type = WireProtocol::MessageType::ERROR;
+                response.payload = "未知的消息类型";
+            }
+            
+            WireProtocol::writeMessage(clientFd, response);
+        }
+    } catch (const std::exception&) {
+        // 协议错误或连接中断，结束该会话
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        activeSessions.erase(clientFd);
+        sessionCount--;
+    }
+    ::close(clientFd);
+}
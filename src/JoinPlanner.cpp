@@ -0,0 +1,1286 @@
+#include "JoinPlanner.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+uint64_t bit(size_t relation) {
+    return uint64_t(1) << relation;
+}
+
+int popcount(uint64_t mask) {
+    int count = 0;
+    while (mask) {
+        mask &= mask - 1;
+        count++;
+    }
+    return count;
+}
+
+std::string trimmed(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos) return "";
+    size_t last = str.find_last_not_of(" \t\n\r");
+    return str.substr(first, last - first + 1);
+}
+
+bool isIdentChar(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return std::isalnum(u) || c == '_' || u >= 0x80;
+}
+
+// 按独立的 AND 单词拆分（不区分大小写，忽略引号内的内容）
+std::vector<std::string> splitConjunction(const std::string& clause) {
+    std::vector<std::string> parts;
+    if (trimmed(clause).empty()) {
+        return parts;
+    }
+
+    size_t start = 0;
+    char quote = 0;
+    for (size_t i = 0; i < clause.size(); i++) {
+        char c = clause[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            quote = c;
+            continue;
+        }
+        if (i + 3 <= clause.size() &&
+            std::toupper(static_cast<unsigned char>(c)) == 'A' &&
+            std::toupper(static_cast<unsigned char>(clause[i + 1])) == 'N' &&
+            std::toupper(static_cast<unsigned char>(clause[i + 2])) == 'D' &&
+            (i == 0 || !isIdentChar(clause[i - 1])) &&
+            (i + 3 == clause.size() || !isIdentChar(clause[i + 3]))) {
+            parts.push_back(trimmed(clause.substr(start, i - start)));
+            start = i + 3;
+            i += 2;
+        }
+    }
+    parts.push_back(trimmed(clause.substr(start)));
+    return parts;
+}
+
+// 条件中含 OR 或括号（忽略引号内的内容），不能按 AND 拆分为独立的谓词
+bool hasDisjunction(const std::string& cond) {
+    char quote = 0;
+    for (size_t i = 0; i < cond.size(); i++) {
+        char c = cond[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            quote = c;
+            continue;
+        }
+        if (c == '(' || c == ')') {
+            return true;
+        }
+        if (i + 2 <= cond.size() &&
+            std::toupper(static_cast<unsigned char>(c)) == 'O' &&
+            std::toupper(static_cast<unsigned char>(cond[i + 1])) == 'R' &&
+            (i == 0 || !isIdentChar(cond[i - 1])) &&
+            (i + 2 == cond.size() || !isIdentChar(cond[i + 2]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 未加引号的数字字面值：可选的符号，数字和至多一个小数点
+bool isNumber(const std::string& text) {
+    size_t i = (!text.empty() && (text[0] == '+' || text[0] == '-')) ? 1 : 0;
+    bool digits = false;
+    bool point = false;
+    for (; i < text.size(); i++) {
+        if (std::isdigit(static_cast<unsigned char>(text[i]))) {
+            digits = true;
+        } else if (text[i] == '.' && !point) {
+            point = true;
+        } else {
+            return false;
+        }
+    }
+    return digits;
+}
+
+bool numericType(const std::string& type) {
+    return type == "INTEGER" || type == "FLOAT";
+}
+
+// 按列类型比较，与 Table::compareValues 相同（空值最小，数值转换失败时按文本比较）
+bool compareTyped(const std::string& a, const std::string& op, const std::string& b, const std::string& type) {
+    bool less = Table::compareValues(a, b, type);
+    bool greater = Table::compareValues(b, a, type);
+    if (op == "=") return !less && !greater;
+    if (op == "!=") return less || greater;
+    if (op == ">") return greater;
+    if (op == "<") return less;
+    if (op == ">=") return !less;
+    if (op == "<=") return !greater;
+    throw std::runtime_error("不支持的操作符: " + op);
+}
+
+// 哈希和排序合并使用的键值：数值按 compareValues 相等的值得到相同的文本（"01"、"1.0" 与 "1"），
+// 转换失败的值和其他类型保持原样
+std::string keyValue(const std::string& value, const std::string& type) {
+    if (value.empty() || !numericType(type)) {
+        return value;
+    }
+    try {
+        if (type == "INTEGER") {
+            return std::to_string(std::stoi(value));
+        }
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(std::stof(value) + 0.0f));
+        return buffer;
+    } catch (const std::exception&) {
+        return value;
+    }
+}
+
+double sortCost(double rows) {
+    return rows > 1 ? rows * std::log2(rows) : 0;
+}
+
+// 等值连接谓词中属于已连接一侧和新加入的表一侧的操作数
+const JoinPlanner::Operand& joinedSide(const JoinPlanner::Predicate& pred, size_t relation) {
+    return pred.left.relation == relation ? pred.right : pred.left;
+}
+
+const JoinPlanner::Operand& newSide(const JoinPlanner::Predicate& pred, size_t relation) {
+    return pred.left.relation == relation ? pred.left : pred.right;
+}
+
+bool sameColumn(const JoinPlanner::Operand& a, const JoinPlanner::Operand& b) {
+    return a.isColumn && b.isColumn && a.relation == b.relation && a.column == b.column;
+}
+
+// 列在右侧时翻转比较方向，例如 5 < a.x 等价于 a.x > 5
+std::string flipOperator(const std::string& op) {
+    if (op == "<") return ">";
+    if (op == ">") return "<";
+    if (op == "<=") return ">=";
+    if (op == ">=") return "<=";
+    return op;
+}
+
+} // namespace
+
+JoinPlanner::JoinPlanner(std::vector<Relation> relations)
+    : relations(std::move(relations)) {
+    if (this->relations.size() > MAX_TABLES) {
+        throw std::runtime_error("连接的表过多（最多 " + std::to_string(MAX_TABLES) + " 张）");
+    }
+    for (const auto& relation : this->relations) {
+        tableRows.push_back(static_cast<double>(relation.table->getData().size()));
+    }
+    baseRows = tableRows;
+    scanFilters.resize(this->relations.size());
+}
+
+void JoinPlanner::addConditions(const std::string& clause, size_t onRelation) {
+    for (const auto& cond : splitConjunction(clause)) {
+        if (cond.empty()) {
+            throw std::runtime_error("无效的条件: " + clause);
+        }
+        if (hasDisjunction(cond)) {
+            throw std::runtime_error("无效的条件: " + cond);
+        }
+
+        // 与单表条件相同的操作符查找顺序
+        static const std::vector<std::string> operators = {">=", "<=", "!=", "=", ">", "<"};
+        std::string op;
+        size_t opPos = std::string::npos;
+        for (const auto& testOp : operators) {
+            if ((opPos = cond.find(testOp)) != std::string::npos) {
+                op = testOp;
+                break;
+            }
+        }
+        if (opPos == std::string::npos) {
+            throw std::runtime_error("无效的条件: " + cond);
+        }
+
+        Predicate pred;
+        pred.text = cond;
+        pred.op = op;
+        pred.left = parseOperand(trimmed(cond.substr(0, opPos)));
+        pred.right = parseOperand(trimmed(cond.substr(opPos + op.length())));
+        if (pred.left.isColumn) pred.relations |= bit(pred.left.relation);
+        if (pred.right.isColumn) pred.relations |= bit(pred.right.relation);
+        pred.type = comparisonType(pred);
+        pred.onRelation = onRelation;
+        predicates.push_back(std::move(pred));
+    }
+}
+
+JoinPlanner::Operand JoinPlanner::parseOperand(const std::string& expr) const {
+    Operand operand;
+    if (expr.empty()) {
+        throw std::runtime_error("条件缺少操作数");
+    }
+    operand.text = expr;
+
+    // 引号括起来的字面值
+    if (expr.front() == '\'' || expr.front() == '"') {
+        bool closed = expr.size() >= 2 && expr.back() == expr.front();
+        operand.literal = expr.substr(1, expr.size() - (closed ? 2 : 1));
+        return operand;
+    }
+
+    if (resolveColumn(expr, operand.relation, operand.column)) {
+        operand.isColumn = true;
+        return operand;
+    }
+
+    // 未加引号的值只能是数字，其他都应当是列
+    if (!isNumber(expr)) {
+        throw std::runtime_error("列不存在: " + expr);
+    }
+    operand.literal = expr;
+    return operand;
+}
+
+std::string JoinPlanner::comparisonType(const Predicate& pred) const {
+    const Operand* column = pred.left.isColumn ? &pred.left : (pred.right.isColumn ? &pred.right : nullptr);
+    if (!column) {
+        return "TEXT";
+    }
+    return relations[column->relation].table->getColumns()[column->column].type;
+}
+
+bool JoinPlanner::resolveColumn(const std::string& expr, size_t& relation, size_t& column) const {
+    std::string alias;
+    std::string name = expr;
+    size_t dotPos = expr.find('.');
+    if (dotPos != std::string::npos) {
+        alias = expr.substr(0, dotPos);
+        name = expr.substr(dotPos + 1);
+    }
+
+    for (size_t i = 0; i < relations.size(); i++) {
+        if (!alias.empty() && relations[i].alias != alias && relations[i].name != alias) {
+            continue;
+        }
+        const auto& columns = relations[i].table->getColumns();
+        for (size_t c = 0; c < columns.size(); c++) {
+            if (columns[c].name == name) {
+                relation = i;
+                column = c;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string JoinPlanner::columnText(const Operand& operand) const {
+    const Relation& rel = relations[operand.relation];
+    return (rel.alias.empty() ? rel.name : rel.alias) + "." + rel.table->getColumns()[operand.column].name;
+}
+
+uint64_t JoinPlanner::nullableRelations() const {
+    // 按书写顺序连接：左外连接补齐新表，右外连接补齐之前的所有表，全外连接两侧都可能补齐
+    uint64_t nullable = 0;
+    for (size_t r = 1; r < relations.size(); r++) {
+        JoinType type = relations[r].joinType;
+        if (type == JoinType::LEFT || type == JoinType::FULL) nullable |= bit(r);
+        if (type == JoinType::RIGHT || type == JoinType::FULL) nullable |= bit(r) - 1;
+    }
+    return nullable;
+}
+
+void JoinPlanner::deriveTransitivePredicates(uint64_t nullable) {
+    // 只使用 WHERE 和内连接条件，可能被补齐为 NULL 的表不参与推导
+    auto usable = [nullable](const Predicate& pred) {
+        return pred.onRelation == NONE && !(pred.relations & nullable);
+    };
+    auto isColumnEquality = [](const Predicate& pred) {
+        return pred.op == "=" && pred.left.isColumn && pred.right.isColumn;
+    };
+
+    // 两列相等的谓词把列合并为等价类（并查集）
+    std::vector<Operand> columns;
+    std::vector<size_t> parent;
+    auto columnId = [&columns](const Operand& operand) {
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (sameColumn(columns[i], operand)) return i;
+        }
+        return NONE;
+    };
+    auto addColumn = [&](const Operand& operand) {
+        size_t id = columnId(operand);
+        if (id != NONE) return id;
+        columns.push_back(operand);
+        parent.push_back(parent.size());
+        return columns.size() - 1;
+    };
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i) {
+            i = parent[i] = parent[parent[i]];
+        }
+        return i;
+    };
+
+    const size_t original = predicates.size();
+    for (size_t p = 0; p < original; p++) {
+        const Predicate& pred = predicates[p];
+        if (usable(pred) && isColumnEquality(pred)) {
+            size_t a = find(addColumn(pred.left));
+            size_t b = find(addColumn(pred.right));
+            parent[a] = b;
+        }
+    }
+    if (columns.empty()) {
+        return;
+    }
+
+    // 已有相同含义的谓词时不再推导
+    auto exists = [&](const Operand& column, const std::string& op, const Operand& other) {
+        for (const auto& pred : predicates) {
+            if (!usable(pred)) continue;
+            if (other.isColumn) {
+                if (isColumnEquality(pred) &&
+                    ((sameColumn(pred.left, column) && sameColumn(pred.right, other)) ||
+                     (sameColumn(pred.left, other) && sameColumn(pred.right, column)))) {
+                    return true;
+                }
+            } else if (pred.left.isColumn != pred.right.isColumn) {
+                const Operand& predColumn = pred.left.isColumn ? pred.left : pred.right;
+                const Operand& predLiteral = pred.left.isColumn ? pred.right : pred.left;
+                std::string predOp = pred.left.isColumn ? pred.op : flipOperator(pred.op);
+                if (sameColumn(predColumn, column) && predOp == op && predLiteral.literal == other.literal) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    auto derive = [&](const Operand& column, const std::string& op, const Operand& other) {
+        Predicate pred;
+        pred.text = columnText(column) + " " + op + " " + (other.isColumn ? columnText(other) : other.text);
+        pred.op = op;
+        pred.left = column;
+        pred.right = other;
+        pred.relations = bit(column.relation) | (other.isColumn ? bit(other.relation) : 0);
+        pred.type = comparisonType(pred);
+        pred.derived = true;
+        predicates.push_back(std::move(pred));
+    };
+
+    // 同一等价类中的列两两相等
+    for (size_t i = 0; i < columns.size(); i++) {
+        for (size_t j = i + 1; j < columns.size(); j++) {
+            if (find(i) == find(j) && !exists(columns[i], "=", columns[j])) {
+                derive(columns[i], "=", columns[j]);
+            }
+        }
+    }
+
+    // 列与常量的比较传递给等价类中的其他列
+    for (size_t p = 0; p < original; p++) {
+        const Predicate pred = predicates[p];
+        if (!usable(pred) || pred.left.isColumn == pred.right.isColumn) {
+            continue;
+        }
+        const Operand& column = pred.left.isColumn ? pred.left : pred.right;
+        const Operand& literal = pred.left.isColumn ? pred.right : pred.left;
+        std::string op = pred.left.isColumn ? pred.op : flipOperator(pred.op);
+        size_t id = columnId(column);
+        if (id == NONE) {
+            continue;
+        }
+        for (size_t j = 0; j < columns.size(); j++) {
+            if (j != id && find(j) == find(id) && !exists(columns[j], op, literal)) {
+                derive(columns[j], op, literal);
+            }
+        }
+    }
+
+    for (auto& pred : predicates) {
+        if (usable(pred) && isColumnEquality(pred)) {
+            pred.equivalence = find(columnId(pred.left));
+        }
+    }
+}
+
+void JoinPlanner::pushDownPredicates() {
+    if (rewritten) {
+        return;
+    }
+    rewritten = true;
+
+    uint64_t nullable = nullableRelations();
+    deriveTransitivePredicates(nullable);
+
+    // 单表的 WHERE 谓词要求该表不会被补齐为 NULL；左外连接 ON 中只引用新表的条件
+    // 只决定新表的哪些行参与匹配，也可以在扫描时求值
+    std::vector<double> rows = tableRows;
+    for (size_t p = 0; p < predicates.size(); p++) {
+        Predicate& pred = predicates[p];
+        if (popcount(pred.relations) != 1) {
+            continue;
+        }
+        size_t relation = 0;
+        while (!(pred.relations & bit(relation))) {
+            relation++;
+        }
+        bool pushable = pred.onRelation == NONE
+            ? !(pred.relations & nullable)
+            : pred.onRelation == relation && relations[relation].joinType == JoinType::LEFT;
+        if (!pushable) {
+            continue;
+        }
+        pred.pushedDown = true;
+        scanFilters[relation].push_back(p);
+        rows[relation] *= selectivity(pred);
+    }
+
+    // 非空表至少估计一行
+    for (size_t r = 0; r < relations.size(); r++) {
+        baseRows[r] = tableRows[r] > 0 ? std::max(1.0, rows[r]) : 0;
+    }
+}
+
+bool JoinPlanner::isEquiJoin(const Predicate& pred) const {
+    return pred.op == "=" && pred.left.isColumn && pred.right.isColumn &&
+           pred.left.relation != pred.right.relation;
+}
+
+bool JoinPlanner::connected(uint64_t joined, size_t relation) const {
+    uint64_t target = joined | bit(relation);
+    for (const auto& pred : predicates) {
+        if (pred.onRelation == NONE && popcount(pred.relations) >= 2 &&
+            (pred.relations & bit(relation)) && (pred.relations & joined) &&
+            !(pred.relations & ~target)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double JoinPlanner::distinctValues(const Operand& operand) const {
+    // 不同值个数不超过过滤之后的行数
+    const Table& table = *relations[operand.relation].table;
+    double rows = baseRows[operand.relation];
+    const TableStats& stats = table.getStats();
+    double distinct = std::min(rows, DEFAULT_DISTINCT);
+    if (stats.isAnalyzed()) {
+        distinct = std::min(rows, static_cast<double>(stats.estimateDistinct(operand.column)));
+    } else if (table.getColumns()[operand.column].primaryKey) {
+        distinct = rows;
+    }
+    return std::max(1.0, distinct);
+}
+
+double JoinPlanner::selectivity(const Predicate& pred) const {
+    if (pred.left.isColumn && pred.right.isColumn) {
+        double equal = 1.0 / std::max(distinctValues(pred.left), distinctValues(pred.right));
+        if (pred.op == "=") return equal;
+        if (pred.op == "!=") return 1.0 - equal;
+        return 1.0 / 3;
+    }
+
+    if (pred.left.isColumn || pred.right.isColumn) {
+        const Operand& column = pred.left.isColumn ? pred.left : pred.right;
+        const Operand& literal = pred.left.isColumn ? pred.right : pred.left;
+        std::string op = pred.left.isColumn ? pred.op : flipOperator(pred.op);
+        const TableStats& stats = relations[column.relation].table->getStats();
+        if (stats.isAnalyzed()) {
+            return stats.estimateSelectivity(column.column, op, literal.literal);
+        }
+        double equal = 1.0 / distinctValues(column);
+        if (op == "=") return equal;
+        if (op == "!=") return 1.0 - equal;
+        return 1.0 / 3;
+    }
+    return 1.0;
+}
+
+JoinPlanner::State JoinPlanner::initialState(size_t relation) const {
+    State state;
+    state.valid = true;
+    state.first = relation;
+    state.joined = bit(relation);
+    state.rows = baseRows[relation];
+    state.cost = tableRows[relation];
+    return state;
+}
+
+JoinPlanner::State JoinPlanner::extend(const State& state, size_t relation, JoinType joinType) const {
+    State next = state;
+    next.joined |= bit(relation);
+
+    Step step;
+    step.relation = relation;
+    step.joinType = joinType;
+    bool outer = joinType == JoinType::LEFT || joinType == JoinType::RIGHT || joinType == JoinType::FULL;
+
+    // 本步可以求值的谓词：外连接只用自己的 ON 条件匹配，WHERE 条件在补齐之后过滤
+    double sel = 1.0;
+    std::vector<size_t> keyClasses;
+    for (size_t p = 0; p < predicates.size(); p++) {
+        const Predicate& pred = predicates[p];
+        if (pred.pushedDown) {
+            continue;
+        }
+        if (pred.onRelation != NONE) {
+            if (pred.onRelation != relation) {
+                continue;
+            }
+        } else {
+            if (popcount(pred.relations) < 2 || !(pred.relations & bit(relation)) ||
+                (pred.relations & ~next.joined)) {
+                continue;
+            }
+            if (outer) {
+                step.filters.push_back(p);
+                sel *= selectivity(pred);
+                continue;
+            }
+        }
+
+        bool key = isEquiJoin(pred) && (pred.relations & bit(relation)) &&
+                   !(pred.relations & ~next.joined);
+        bool redundant = false;
+        if (key && pred.equivalence != NONE) {
+            // 等价类中已有连接键时，同一类的其他等值条件不再降低行数，推导出的直接省略
+            redundant = std::find(keyClasses.begin(), keyClasses.end(), pred.equivalence) != keyClasses.end();
+            if (redundant && pred.derived) {
+                continue;
+            }
+            keyClasses.push_back(pred.equivalence);
+        }
+        if (!redundant) {
+            sel *= selectivity(pred);
+        }
+        (key ? step.keys : step.conditions).push_back(p);
+    }
+
+    double leftRows = state.rows;
+    double rightRows = baseRows[relation];
+    double rows = leftRows * rightRows * sel;
+    if (joinType == JoinType::LEFT) rows = std::max(rows, leftRows);
+    if (joinType == JoinType::RIGHT) rows = std::max(rows, rightRows);
+    if (joinType == JoinType::FULL) rows = std::max(rows, std::max(leftRows, rightRows));
+    step.rows = rows;
+
+    // 选择连接算法（代价以处理的行数计，哈希表的插入按两倍计）
+    double methodCost = leftRows * rightRows;
+    const Table& table = *relations[relation].table;
+    if (!step.keys.empty()) {
+        step.method = Method::HASH;
+        step.buildLeft = leftRows < rightRows;
+        methodCost = 2 * std::min(leftRows, rightRows) + std::max(leftRows, rightRows);
+
+        // 排序合并：单个连接键时，已按该键有序的输入和有索引的表不需要再排序
+        bool leftSorted = false;
+        bool rightIndexed = false;
+        if (step.keys.size() == 1) {
+            const Predicate& key = predicates[step.keys[0]];
+            for (const auto& sorted : state.sortedOn) {
+                leftSorted = leftSorted || sameColumn(sorted, joinedSide(key, relation));
+            }
+            const auto& column = table.getColumns()[newSide(key, relation).column];
+            rightIndexed = scanFilters[relation].empty() && !numericType(key.type) &&
+                           table.getIndex(column.name) != nullptr;
+        }
+        double mergeCost = leftRows + rightRows +
+                           (leftSorted ? 0 : sortCost(leftRows)) + (rightIndexed ? 0 : sortCost(rightRows));
+        if (mergeCost < methodCost) {
+            step.method = Method::SORT_MERGE;
+            methodCost = mergeCost;
+        }
+
+        // 索引嵌套循环：已连接结果的每一行在新表的索引中查找，需要保留新表未匹配行时不适用
+        if (joinType == JoinType::INNER || joinType == JoinType::LEFT) {
+            for (size_t k = 0; k < step.keys.size(); k++) {
+                // 索引按存储的文本查找，只用于非数值的键
+                const auto& column = table.getColumns()[newSide(predicates[step.keys[k]], relation).column];
+                if (numericType(predicates[step.keys[k]].type) || table.getIndex(column.name) == nullptr) {
+                    continue;
+                }
+                double indexCost = leftRows * (1 + std::log2(tableRows[relation] + 1));
+                if (indexCost < methodCost) {
+                    step.method = Method::INDEX_NESTED_LOOP;
+                    step.indexKey = k;
+                    methodCost = indexCost;
+                }
+                break;
+            }
+        }
+    }
+
+    // 索引嵌套循环不需要读取整张新表
+    double readCost = step.method == Method::INDEX_NESTED_LOOP ? 0 : tableRows[relation];
+    step.cost = state.cost + readCost + methodCost + rows;
+    next.rows = rows;
+    next.cost = step.cost;
+
+    // 内连接中只有按已连接结果的顺序输出的算法保持原有顺序
+    if (joinType != JoinType::INNER || (step.method == Method::HASH && step.buildLeft)) {
+        next.sortedOn.clear();
+    } else if (step.method == Method::SORT_MERGE) {
+        const Predicate& key = predicates[step.keys[0]];
+        next.sortedOn = {joinedSide(key, relation), newSide(key, relation)};
+    }
+
+    next.steps.push_back(std::move(step));
+    return next;
+}
+
+JoinPlanner::Plan JoinPlanner::finish(const State& state, const std::string& strategy) const {
+    Plan plan;
+    plan.first = state.first;
+    plan.steps = state.steps;
+    plan.rows = state.rows;
+    plan.cost = state.cost;
+    plan.strategy = strategy;
+
+    for (size_t p = 0; p < predicates.size(); p++) {
+        const Predicate& pred = predicates[p];
+        if (pred.onRelation == NONE && popcount(pred.relations) < 2 && !pred.pushedDown && !pred.derived) {
+            plan.finalFilters.push_back(p);
+            plan.rows *= selectivity(pred);
+        }
+    }
+    return plan;
+}
+
+JoinPlanner::Plan JoinPlanner::optimize() {
+    TRACE_SCOPE("JoinPlanner::optimize", "plan");
+    pushDownPredicates();
+
+    bool hasOuterJoin = false;
+    for (const auto& relation : relations) {
+        hasOuterJoin = hasOuterJoin || relation.joinType == JoinType::LEFT ||
+                       relation.joinType == JoinType::RIGHT || relation.joinType == JoinType::FULL;
+    }
+
+    if (hasOuterJoin || relations.size() <= 1) {
+        return orderAsWritten();
+    }
+    if (relations.size() <= DP_TABLE_LIMIT) {
+        return orderByDynamicProgramming();
+    }
+    return orderGreedily();
+}
+
+JoinPlanner::Plan JoinPlanner::orderByDynamicProgramming() const {
+    // best[S] 为连接表集合 S 的最低代价左深计划
+    const size_t n = relations.size();
+    const uint64_t full = bit(n) - 1;
+    std::vector<State> best(size_t(1) << n);
+    for (size_t r = 0; r < n; r++) {
+        best[bit(r)] = initialState(r);
+    }
+
+    for (uint64_t mask = 1; mask < full; mask++) {
+        if (!best[mask].valid) {
+            continue;
+        }
+
+        // 有连接条件可用时不考虑笛卡尔积
+        bool anyConnected = false;
+        for (size_t r = 0; r < n; r++) {
+            if (!(mask & bit(r)) && connected(mask, r)) {
+                anyConnected = true;
+                break;
+            }
+        }
+
+        for (size_t r = 0; r < n; r++) {
+            if ((mask & bit(r)) || (anyConnected && !connected(mask, r))) {
+                continue;
+            }
+            State next = extend(best[mask], r, JoinType::INNER);
+            State& target = best[mask | bit(r)];
+            if (!target.valid || next.cost < target.cost) {
+                target = std::move(next);
+            }
+        }
+    }
+    return finish(best[full], "动态规划");
+}
+
+JoinPlanner::Plan JoinPlanner::orderGreedily() const {
+    // 从最小的表开始，每次加入使累计代价最小的表
+    const size_t n = relations.size();
+    size_t first = 0;
+    for (size_t r = 1; r < n; r++) {
+        if (baseRows[r] < baseRows[first]) {
+            first = r;
+        }
+    }
+
+    State state = initialState(first);
+    for (size_t added = 1; added < n; added++) {
+        bool anyConnected = false;
+        for (size_t r = 0; r < n; r++) {
+            if (!(state.joined & bit(r)) && connected(state.joined, r)) {
+                anyConnected = true;
+                break;
+            }
+        }
+
+        State best;
+        for (size_t r = 0; r < n; r++) {
+            if ((state.joined & bit(r)) || (anyConnected && !connected(state.joined, r))) {
+                continue;
+            }
+            State next = extend(state, r, JoinType::INNER);
+            if (!best.valid || next.cost < best.cost) {
+                best = std::move(next);
+            }
+        }
+        state = std::move(best);
+    }
+    return finish(state, "贪心");
+}
+
+JoinPlanner::Plan JoinPlanner::orderAsWritten() const {
+    State state = initialState(0);
+    for (size_t r = 1; r < relations.size(); r++) {
+        state = extend(state, r, relations[r].joinType);
+    }
+    return finish(state, "书写顺序");
+}
+
+const std::string* JoinPlanner::operandValue(const Operand& operand, const Tuple& tuple) {
+    if (!operand.isColumn) {
+        return &operand.literal;
+    }
+    const Row* row = tuple[operand.relation];
+    return row ? &(*row)[operand.column] : nullptr;
+}
+
+bool JoinPlanner::evaluate(const Predicate& pred, const Tuple& tuple) const {
+    // 外连接补齐的一侧没有值，比较结果为假
+    const std::string* left = operandValue(pred.left, tuple);
+    const std::string* right = operandValue(pred.right, tuple);
+    if (!left || !right) {
+        return false;
+    }
+
+    return compareTyped(*left, pred.op, *right, pred.type);
+}
+
+bool JoinPlanner::passesScanFilters(size_t relation, const Row& row, Tuple& scratch) const {
+    scratch[relation] = &row;
+    for (size_t p : scanFilters[relation]) {
+        if (!evaluate(predicates[p], scratch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JoinPlanner::joinedKey(const Step& step, const Tuple& tuple, std::string& key) const {
+    // 多个连接键用 \0 分隔，拼接后的字典序与逐列比较一致
+    key.clear();
+    for (size_t p : step.keys) {
+        const std::string* value = operandValue(joinedSide(predicates[p], step.relation), tuple);
+        if (!value) {
+            return false;
+        }
+        key += keyValue(*value, predicates[p].type);
+        key += '\0';
+    }
+    return true;
+}
+
+std::string JoinPlanner::newKey(const Step& step, const Row& row) const {
+    std::string key;
+    for (size_t p : step.keys) {
+        key += keyValue(row[newSide(predicates[p], step.relation).column], predicates[p].type);
+        key += '\0';
+    }
+    return key;
+}
+
+std::vector<size_t> JoinPlanner::bloomKeys(const Step& step) const {
+    const Table& table = *relations[step.relation].table;
+    std::vector<size_t> keys;
+    for (size_t p : step.keys) {
+        if (numericType(predicates[p].type)) {
+            continue;   // 过滤器中是存储的文本，"01" 不在其中不说明没有等于 1 的行
+        }
+        if (table.hasBloomFilter(table.getColumns()[newSide(predicates[p], step.relation).column].name)) {
+            keys.push_back(p);
+        }
+    }
+    return keys;
+}
+
+bool JoinPlanner::rejectedByBloom(const Step& step, const std::vector<size_t>& keys,
+                                  const Tuple& tuple) const {
+    // 布隆过滤器没有假阴性：键值不在过滤器中时新表一定没有匹配的行
+    const Table& table = *relations[step.relation].table;
+    for (size_t p : keys) {
+        const Predicate& pred = predicates[p];
+        const std::string* value = operandValue(joinedSide(pred, step.relation), tuple);
+        if (value && !table.mayContain(table.getColumns()[newSide(pred, step.relation).column].name, *value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JoinPlanner::encodedKey(const Step& step, const ColumnDictionary*& joined,
+                             const ColumnDictionary*& added) const {
+    if (step.keys.size() != 1) {
+        return false;
+    }
+    const Predicate& pred = predicates[step.keys[0]];
+    if (numericType(pred.type)) {
+        return false;
+    }
+    const Operand& joinedColumn = joinedSide(pred, step.relation);
+    joined = relations[joinedColumn.relation].table->getDictionary(joinedColumn.column);
+    added = relations[step.relation].table->getDictionary(newSide(pred, step.relation).column);
+    return joined && added;
+}
+
+std::vector<JoinPlanner::Tuple> JoinPlanner::execute(const Plan& plan, QueryProfile* profile) const {
+    const size_t n = relations.size();
+    Tuple scratch(n, nullptr);
+
+    // 读取表并求值下推的谓词，列与常量的比较先按区域映射跳过整块
+    auto scan = [&](size_t relation) {
+        auto start = QueryProfile::now();
+        const Table& table = *relations[relation].table;
+        const auto& data = table.getData();
+        std::vector<Condition> conditions;
+        for (size_t p : scanFilters[relation]) {
+            // 区域映射、字典和布隆过滤器按文本比较，数值列上的谓词不用于跳过
+            const Predicate& pred = predicates[p];
+            if (pred.left.isColumn != pred.right.isColumn && !numericType(pred.type)) {
+                const Operand& column = pred.left.isColumn ? pred.left : pred.right;
+                const Operand& literal = pred.left.isColumn ? pred.right : pred.left;
+                conditions.push_back({table.getColumns()[column.column].name,
+                                      pred.left.isColumn ? pred.op : flipOperator(pred.op),
+                                      literal.literal});
+            }
+        }
+
+        std::vector<const Row*> rows;
+        rows.reserve(scanFilters[relation].empty() ? data.size() : 0);
+        size_t examined = 0;
+        for (const auto& [begin, end] : table.candidateRanges(conditions)) {
+            examined += end - begin;
+            for (size_t i = begin; i < end; i++) {
+                if (passesScanFilters(relation, data[i], scratch)) {
+                    rows.push_back(&data[i]);
+                }
+            }
+        }
+        if (profile) {
+            profile->addRowsExamined(examined);
+            if (relation == plan.first || !scanFilters[relation].empty()) {
+                profile->addStage("全表扫描", describeScan(relation) + table.describeSkipped(examined),
+                                  data.size(), rows.size(), start);
+            }
+        }
+        return rows;
+    };
+
+    std::vector<Tuple> tuples;
+    for (const Row* row : scan(plan.first)) {
+        Tuple tuple(n, nullptr);
+        tuple[plan.first] = row;
+        tuples.push_back(std::move(tuple));
+    }
+
+    for (const auto& step : plan.steps) {
+        // 索引嵌套循环只读取索引命中的行；内连接和左外连接中已连接的行都被布隆过滤器
+        // 排除时新表不会有匹配的行，也不需要读取
+        std::vector<const Row*> rightRows;
+        std::vector<size_t> bloom = bloomKeys(step);
+        bool keepRight = step.joinType == JoinType::RIGHT || step.joinType == JoinType::FULL;
+        bool allRejected = !bloom.empty() && !keepRight &&
+                           std::all_of(tuples.begin(), tuples.end(), [&](const Tuple& tuple) {
+                               return rejectedByBloom(step, bloom, tuple);
+                           });
+        if (step.method != Method::INDEX_NESTED_LOOP && !allRejected) {
+            rightRows = scan(step.relation);
+        }
+
+        auto start = QueryProfile::now();
+        size_t leftRows = tuples.size();
+        size_t examined = 0;
+        {
+            TRACE_SCOPE("JoinPlanner::joinStep", "join", relations[step.relation].name);
+            tuples = joinStep(std::move(tuples), step, rightRows, examined);
+        }
+        if (profile) {
+            profile->addRowsExamined(examined);
+            profile->addStage(methodName(step.method), describeStep(step),
+                              leftRows + rightRows.size(), tuples.size(), start);
+        }
+    }
+
+    if (!plan.finalFilters.empty()) {
+        auto start = QueryProfile::now();
+        size_t before = tuples.size();
+        std::vector<Tuple> filtered;
+        for (auto& tuple : tuples) {
+            bool keep = true;
+            for (size_t p : plan.finalFilters) {
+                if (!evaluate(predicates[p], tuple)) {
+                    keep = false;
+                    break;
+                }
+            }
+            if (keep) {
+                filtered.push_back(std::move(tuple));
+            }
+        }
+        tuples = std::move(filtered);
+        if (profile) {
+            profile->addStage("过滤", "WHERE " + describePredicates(plan.finalFilters),
+                              before, tuples.size(), start);
+        }
+    }
+    return tuples;
+}
+
+std::vector<JoinPlanner::Tuple> JoinPlanner::joinStep(
+    std::vector<Tuple> left, const Step& step,
+    const std::vector<const Row*>& rightRows, size_t& examined) const {
+
+    const size_t relation = step.relation;
+    const Table& table = *relations[relation].table;
+    const bool keepLeft = step.joinType == JoinType::LEFT || step.joinType == JoinType::FULL;
+    const bool keepRight = step.joinType == JoinType::RIGHT || step.joinType == JoinType::FULL;
+
+    std::vector<char> leftMatched(keepLeft ? left.size() : 0, 0);
+    std::vector<char> rightMatched(keepRight ? rightRows.size() : 0, 0);
+    std::vector<Tuple> output;
+    Tuple scratch;
+
+    // 键值不在新表布隆过滤器中的行不会匹配，外连接时直接补齐
+    const std::vector<size_t> bloom = bloomKeys(step);
+    auto rejected = [&](size_t li) {
+        return !bloom.empty() && rejectedByBloom(step, bloom, left[li]);
+    };
+
+    // 连接键相等的一对行，再检查其他匹配条件
+    auto tryPair = [&](size_t li, const Row* row) {
+        examined++;
+        scratch = left[li];
+        scratch[relation] = row;
+        for (size_t p : step.conditions) {
+            if (!evaluate(predicates[p], scratch)) {
+                return false;
+            }
+        }
+        if (keepLeft) leftMatched[li] = 1;
+        output.push_back(scratch);
+        return true;
+    };
+    auto tryRight = [&](size_t li, size_t ri) {
+        if (tryPair(li, rightRows[ri]) && keepRight) {
+            rightMatched[ri] = 1;
+        }
+    };
+
+    std::string key;
+    switch (step.method) {
+        case Method::NESTED_LOOP:
+            for (size_t li = 0; li < left.size(); li++) {
+                if (rejected(li)) continue;
+                for (size_t ri = 0; ri < rightRows.size(); ri++) {
+                    tryRight(li, ri);
+                }
+            }
+            break;
+
+        case Method::HASH: {
+            const ColumnDictionary* joinedDictionary = nullptr;
+            const ColumnDictionary* newDictionary = nullptr;
+            if (encodedKey(step, joinedDictionary, newDictionary)) {
+                // 已连接一侧字典的编码转换为新表字典的编码，新表的行按编码分组；
+                // 行指针指向各表的 data，减去起始地址得到行号
+                const Operand& joinedColumn = joinedSide(predicates[step.keys[0]], relation);
+                const Row* joinedBase = relations[joinedColumn.relation].table->getData().data();
+                const Row* newBase = table.getData().data();
+                std::vector<uint32_t> translated(joinedDictionary->size());
+                for (uint32_t code = 0; code < translated.size(); code++) {
+                    translated[code] = newDictionary->find(joinedDictionary->value(code));
+                }
+                std::vector<std::vector<size_t>> rowsByCode(newDictionary->size());
+                for (size_t ri = 0; ri < rightRows.size(); ri++) {
+                    rowsByCode[newDictionary->code(rightRows[ri] - newBase)].push_back(ri);
+                }
+                for (size_t li = 0; li < left.size(); li++) {
+                    const Row* row = left[li][joinedColumn.relation];
+                    if (!row || rejected(li)) continue;
+                    uint32_t code = translated[joinedDictionary->code(row - joinedBase)];
+                    if (code == ColumnDictionary::NO_CODE) continue;
+                    for (size_t ri : rowsByCode[code]) {
+                        tryRight(li, ri);
+                    }
+                }
+            } else if (step.buildLeft) {
+                std::unordered_map<std::string, std::vector<size_t>> hashTable;
+                for (size_t li = 0; li < left.size(); li++) {
+                    if (!rejected(li) && joinedKey(step, left[li], key)) {
+                        hashTable[key].push_back(li);
+                    }
+                }
+                for (size_t ri = 0; ri < rightRows.size(); ri++) {
+                    auto it = hashTable.find(newKey(step, *rightRows[ri]));
+                    if (it == hashTable.end()) continue;
+                    for (size_t li : it->second) {
+                        tryRight(li, ri);
+                    }
+                }
+            } else {
+                std::unordered_map<std::string, std::vector<size_t>> hashTable;
+                for (size_t ri = 0; ri < rightRows.size(); ri++) {
+                    hashTable[newKey(step, *rightRows[ri])].push_back(ri);
+                }
+                for (size_t li = 0; li < left.size(); li++) {
+                    if (rejected(li) || !joinedKey(step, left[li], key)) continue;
+                    auto it = hashTable.find(key);
+                    if (it == hashTable.end()) continue;
+                    for (size_t ri : it->second) {
+                        tryRight(li, ri);
+                    }
+                }
+            }
+            break;
+        }
+
+        case Method::INDEX_NESTED_LOOP: {
+            const Predicate& indexPred = predicates[step.keys[step.indexKey]];
+            const auto& column = table.getColumns()[newSide(indexPred, relation).column];
+            const auto* index = table.getIndex(column.name);
+            const auto& data = table.getData();
+            Tuple filterScratch(relations.size(), nullptr);
+            for (size_t li = 0; li < left.size(); li++) {
+                const std::string* value = operandValue(joinedSide(indexPred, relation), left[li]);
+                if (!value || rejected(li)) continue;
+                auto it = index->find(*value);
+                if (it == index->end()) continue;
+                for (size_t ri : it->second) {
+                    // 其他连接键逐一比较，再求值下推到这张表的谓词
+                    const Row& row = data[ri];
+                    bool match = true;
+                    for (size_t k = 0; k < step.keys.size() && match; k++) {
+                        if (k == step.indexKey) continue;
+                        const Predicate& pred = predicates[step.keys[k]];
+                        const std::string* joined = operandValue(joinedSide(pred, relation), left[li]);
+                        match = joined && compareTyped(*joined, "=", row[newSide(pred, relation).column], pred.type);
+                    }
+                    if (match && passesScanFilters(relation, row, filterScratch)) {
+                        tryPair(li, &row);
+                    }
+                }
+            }
+            break;
+        }
+
+        case Method::SORT_MERGE: {
+            using KeyedRow = std::pair<std::string, size_t>;
+            auto byKey = [](const KeyedRow& a, const KeyedRow& b) { return a.first < b.first; };
+
+            std::vector<KeyedRow> leftKeys;
+            leftKeys.reserve(left.size());
+            for (size_t li = 0; li < left.size(); li++) {
+                if (!rejected(li) && joinedKey(step, left[li], key)) {
+                    leftKeys.emplace_back(key, li);
+                }
+            }
+            if (!std::is_sorted(leftKeys.begin(), leftKeys.end(), byKey)) {
+                std::stable_sort(leftKeys.begin(), leftKeys.end(), byKey);
+            }
+
+            // 单个连接键且有索引时按索引顺序读取，不需要排序（下推了过滤条件的表
+            // 只读取部分行，行号与索引不再对应）
+            std::vector<KeyedRow> rightKeys;
+            rightKeys.reserve(rightRows.size());
+            const std::map<std::string, std::set<size_t>>* index = nullptr;
+            if (step.keys.size() == 1 && scanFilters[relation].empty() &&
+                !numericType(predicates[step.keys[0]].type)) {
+                const auto& column = table.getColumns()[newSide(predicates[step.keys[0]], relation).column];
+                index = table.getIndex(column.name);
+            }
+            if (index) {
+                for (const auto& [value, rows] : *index) {
+                    for (size_t ri : rows) {
+                        rightKeys.emplace_back(value + '\0', ri);
+                    }
+                }
+            } else {
+                for (size_t ri = 0; ri < rightRows.size(); ri++) {
+                    rightKeys.emplace_back(newKey(step, *rightRows[ri]), ri);
+                }
+                std::stable_sort(rightKeys.begin(), rightKeys.end(), byKey);
+            }
+
+            size_t i = 0;
+            size_t j = 0;
+            while (i < leftKeys.size() && j < rightKeys.size()) {
+                int cmp = leftKeys[i].first.compare(rightKeys[j].first);
+                if (cmp < 0) {
+                    i++;
+                } else if (cmp > 0) {
+                    j++;
+                } else {
+                    size_t leftEnd = i;
+                    while (leftEnd < leftKeys.size() && leftKeys[leftEnd].first == leftKeys[i].first) leftEnd++;
+                    size_t rightEnd = j;
+                    while (rightEnd < rightKeys.size() && rightKeys[rightEnd].first == rightKeys[j].first) rightEnd++;
+                    for (size_t a = i; a < leftEnd; a++) {
+                        for (size_t b = j; b < rightEnd; b++) {
+                            tryRight(leftKeys[a].second, rightKeys[b].second);
+                        }
+                    }
+                    i = leftEnd;
+                    j = rightEnd;
+                }
+            }
+            break;
+        }
+    }
+
+    // 外连接补齐未匹配的行
+    if (keepLeft) {
+        for (size_t li = 0; li < left.size(); li++) {
+            if (!leftMatched[li]) {
+                output.push_back(std::move(left[li]));
+                output.back()[relation] = nullptr;
+            }
+        }
+    }
+    if (keepRight) {
+        for (size_t ri = 0; ri < rightRows.size(); ri++) {
+            if (!rightMatched[ri]) {
+                Tuple tuple(relations.size(), nullptr);
+                tuple[relation] = rightRows[ri];
+                output.push_back(std::move(tuple));
+            }
+        }
+    }
+
+    if (!step.filters.empty()) {
+        std::vector<Tuple> filtered;
+        for (auto& tuple : output) {
+            bool keep = true;
+            for (size_t p : step.filters) {
+                if (!evaluate(predicates[p], tuple)) {
+                    keep = false;
+                    break;
+                }
+            }
+            if (keep) {
+                filtered.push_back(std::move(tuple));
+            }
+        }
+        output = std::move(filtered);
+    }
+    return output;
+}
+
+const char* JoinPlanner::methodName(Method method) {
+    switch (method) {
+        case Method::HASH: return "哈希连接";
+        case Method::INDEX_NESTED_LOOP: return "索引嵌套循环连接";
+        case Method::SORT_MERGE: return "排序合并连接";
+        default: return "嵌套循环连接";
+    }
+}
+
+std::string JoinPlanner::describeScan(size_t relation) const {
+    const Relation& rel = relations[relation];
+    std::string detail = "表 " + rel.name;
+    if (!rel.alias.empty() && rel.alias != rel.name) {
+        detail += " " + rel.alias;
+    }
+    if (!scanFilters[relation].empty()) {
+        detail += "，过滤: " + describePredicates(scanFilters[relation]);
+    }
+    return detail;
+}
+
+std::string JoinPlanner::describeStep(const Step& step) const {
+    std::string detail = describeScan(step.relation);
+    switch (step.joinType) {
+        case JoinType::LEFT: detail += "，左外连接"; break;
+        case JoinType::RIGHT: detail += "，右外连接"; break;
+        case JoinType::FULL: detail += "，全外连接"; break;
+        default: break;
+    }
+    if (!step.keys.empty()) {
+        detail += "，连接键: " + describePredicates(step.keys);
+    }
+    if (!step.conditions.empty()) {
+        detail += "，条件: " + describePredicates(step.conditions);
+    }
+    if (!step.filters.empty()) {
+        detail += "，连接后过滤: " + describePredicates(step.filters);
+    }
+    std::vector<size_t> bloom = bloomKeys(step);
+    if (!bloom.empty()) {
+        detail += "，布隆过滤器: " + describePredicates(bloom);
+    }
+
+    const Relation& rel = relations[step.relation];
+    switch (step.method) {
+        case Method::HASH: {
+            const ColumnDictionary* joinedDictionary = nullptr;
+            const ColumnDictionary* newDictionary = nullptr;
+            if (encodedKey(step, joinedDictionary, newDictionary)) {
+                detail += "，按字典编码匹配";
+            } else {
+                detail += step.buildLeft ? "，在已连接的结果上建哈希表" : "，在 " + rel.name + " 上建哈希表";
+            }
+            break;
+        }
+        case Method::INDEX_NESTED_LOOP: {
+            const Predicate& pred = predicates[step.keys[step.indexKey]];
+            detail += "，使用 " + rel.table->getColumns()[newSide(pred, step.relation).column].name + " 上的索引";
+            break;
+        }
+        case Method::SORT_MERGE:
+            detail += "，按连接键排序后合并";
+            break;
+        case Method::NESTED_LOOP:
+            if (step.keys.empty() && step.conditions.empty()) {
+                detail += "，笛卡尔积";
+            }
+            break;
+    }
+    return detail;
+}
+
+std::string JoinPlanner::describeOrder(const Plan& plan) const {
+    auto name = [this](size_t relation) {
+        const Relation& rel = relations[relation];
+        return rel.alias.empty() ? rel.name : rel.alias;
+    };
+    std::string detail = plan.strategy + "：" + name(plan.first);
+    for (const auto& step : plan.steps) {
+        detail += " → " + name(step.relation);
+    }
+    return detail;
+}
+
+std::string JoinPlanner::describePredicates(const std::vector<size_t>& indices) const {
+    std::string detail;
+    for (size_t p : indices) {
+        if (!detail.empty()) detail += " AND ";
+        detail += predicates[p].text;
+    }
+    return detail;
+}
@@ -0,0 +1,245 @@
+#include "QueryStats.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <set>
+
+namespace {
+
+bool isWordChar(unsigned char c) {
+    // 非 ASCII 字节按标识符处理，中文值和列名不会被拆开
+    return std::isalnum(c) || c == '_' || c >= 0x80;
+}
+
+bool isComparison(const std::string& token) {
+    return token == "=" || token == "<" || token == ">" || token == "<=" ||
+           token == ">=" || token == "!=" || token == "<>" || token == "LIKE";
+}
+
+bool isKeyword(const std::string& upper) {
+    static const std::set<std::string> keywords = {
+        "SELECT", "FROM", "WHERE", "AND", "OR", "NOT", "INSERT", "INTO", "VALUES",
+        "UPDATE", "SET", "DELETE", "CREATE", "TABLE", "DROP", "JOIN", "INNER",
+        "LEFT", "RIGHT", "FULL", "OUTER", "ON", "AS", "GROUP", "BY", "HAVING",
+        "ORDER", "ASC", "DESC", "LIMIT", "COUNT", "AVG", "SUM", "MIN", "MAX",
+        "LIKE", "IN", "IS", "NULL", "DISTINCT", "EXPLAIN", "ANALYZE", "PRIMARY",
+        "KEY", "FOREIGN", "REFERENCES", "INTEGER", "TEXT", "FLOAT", "ALTER", "ADD",
+        "BLOOM", "FILTER"
+    };
+    return keywords.count(upper) > 0;
+}
+
+} // namespace
+
+std::string QueryStats::fingerprint(const std::string& sql) {
+    std::string out;
+    std::string prev;   // 上一个记号，比较运算符右侧的值整体替换为 ?
+    size_t i = 0;
+    const size_t n = sql.size();
+
+    auto emit = [&out, &prev](const std::string& token) {
+        // 记号之间用一个空格分隔，括号、逗号和点号两侧不加空格
+        if (!out.empty() && token != "," && token != ")" && token != "(" && token != "." &&
+            out.back() != '(' && out.back() != '.') {
+            out += ' ';
+        }
+        out += token;
+        prev = token;
+    };
+
+    while (i < n) {
+        unsigned char c = sql[i];
+        if (std::isspace(c) || c == ';') {
+            i++;
+            continue;
+        }
+
+        if (c == '\'' || c == '"') {
+            // 引号内的字符串，连续两个引号表示转义
+            char quote = c;
+            i++;
+            while (i < n) {
+                if (sql[i] == quote && i + 1 < n && sql[i + 1] == quote) {
+                    i += 2;
+                } else if (sql[i] == quote) {
+                    i++;
+                    break;
+                } else {
+                    i++;
+                }
+            }
+            emit("?");
+            continue;
+        }
+
+        if (isComparison(prev)) {
+            // 值可以不加引号（例如 计算机系、2022-09-01、-5），一直取到空白或分隔符
+            size_t start = i;
+            while (i < n && !std::isspace(static_cast<unsigned char>(sql[i])) &&
+                   !std::strchr(",;()", sql[i])) {
+                i++;
+            }
+            // 连接条件右侧的 表.列 保留原样
+            std::string value = sql.substr(start, i - start);
+            size_t dot = value.find('.');
+            bool qualifiedColumn = dot != std::string::npos && dot > 0 && dot + 1 < value.size() &&
+                                   (std::isalpha(static_cast<unsigned char>(value[0])) || value[0] == '_') &&
+                                   (std::isalpha(static_cast<unsigned char>(value[dot + 1])) || value[dot + 1] == '_');
+            emit(qualifiedColumn ? value : "?");
+            continue;
+        }
+
+        if (isWordChar(c)) {
+            size_t start = i;
+            while (i < n && (isWordChar(sql[i]) || (std::isdigit(c) && sql[i] == '.'))) {
+                i++;
+            }
+            if (std::isdigit(c)) {
+                emit("?");
+                continue;
+            }
+
+            std::string word = sql.substr(start, i - start);
+            std::string upper = word;
+            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+            if (upper == "VALUES") {
+                // 插入的值列表整体折叠，批量插入不同行数的语句归为同一指纹
+                emit("VALUES");
+                emit("(...)");
+                break;
+            }
+            emit(isKeyword(upper) ? upper : word);
+            continue;
+        }
+
+        if (std::strchr("<>!=", c)) {
+            size_t start = i;
+            while (i < n && std::strchr("<>!=", sql[i])) {
+                i++;
+            }
+            emit(sql.substr(start, i - start));
+            continue;
+        }
+
+        emit(std::string(1, static_cast<char>(c)));
+        i++;
+    }
+    return out;
+}
+
+size_t QueryStats::bucketFor(double ms) {
+    // 桶 0 为 1 微秒以内，之后每个桶的上界是前一个的 1.1 倍（约 5% 误差）
+    double us = ms * 1000.0;
+    if (us <= 1.0) {
+        return 0;
+    }
+    size_t bucket = static_cast<size_t>(std::ceil(std::log(us) / std::log(1.1)));
+    return std::min(bucket, HISTOGRAM_BUCKETS - 1);
+}
+
+double QueryStats::bucketUpperBound(size_t bucket) {
+    return std::pow(1.1, static_cast<double>(bucket)) / 1000.0;
+}
+
+void QueryStats::record(const std::string& sql, double elapsedMs,
+                        uint64_t rowsExamined, uint64_t rowsReturned) {
+    std::string key = fingerprint(sql);
+    std::string logPath;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (accumulators.size() >= MAX_FINGERPRINTS && accumulators.count(key) == 0) {
+            key = "<其他>";
+        }
+
+        Accumulator& acc = accumulators[key];
+        Entry& entry = acc.entry;
+        entry.fingerprint = key;
+        entry.calls++;
+        entry.totalMs += elapsedMs;
+        entry.maxMs = std::max(entry.maxMs, elapsedMs);
+        entry.rowsExamined += rowsExamined;
+        entry.rowsReturned += rowsReturned;
+        acc.histogram[bucketFor(elapsedMs)]++;
+
+        if (slowQueryThreshold >= 0 && elapsedMs >= slowQueryThreshold) {
+            logPath = slowLogPath;
+        }
+    }
+
+    if (!logPath.empty()) {
+        writeSlowLog(logPath, sql, elapsedMs, rowsExamined, rowsReturned);
+    }
+}
+
+std::vector<QueryStats::Entry> QueryStats::getEntries() const {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& [key, acc] : accumulators) {
+            Entry entry = acc.entry;
+            entry.meanMs = entry.totalMs / entry.calls;
+
+            // 找到累计次数达到 99% 的桶，取其上界（不超过最大值）
+            uint64_t target = (entry.calls * 99 + 99) / 100;
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < acc.histogram.size(); bucket++) {
+                seen += acc.histogram[bucket];
+                if (seen >= target) {
+                    entry.p99Ms = std::min(bucketUpperBound(bucket), entry.maxMs);
+                    break;
+                }
+            }
+            entries.push_back(entry);
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.totalMs > b.totalMs;
+    });
+    return entries;
+}
+
+void QueryStats::setSlowQueryThreshold(double ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slowQueryThreshold = ms;
+}
+
+double QueryStats::getSlowQueryThreshold() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slowQueryThreshold;
+}
+
+void QueryStats::setSlowLogPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slowLogPath = path;
+}
+
+void QueryStats::writeSlowLog(const std::string& path, const std::string& sql, double elapsedMs,
+                              uint64_t rowsExamined, uint64_t rowsReturned) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::ofstream log(path, std::ios::app);
+    if (!log) {
+        return;  // 日志写入失败不影响查询本身
+    }
+
+    std::time_t now = std::time(nullptr);
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+
+    // 与 MySQL 慢查询日志类似：一行注释头，随后是完整语句
+    std::string statement = sql;
+    while (!statement.empty() && (std::isspace(static_cast<unsigned char>(statement.back())) ||
+                                  statement.back() == ';')) {
+        statement.pop_back();
+    }
+    log << "# Time: " << time
+        << "  Query_time_ms: " << std::fixed << std::setprecision(3) << elapsedMs
+        << "  Rows_examined: " << rowsExamined
+        << "  Rows_sent: " << rowsReturned << "\n"
+        << statement << ";\n";
+}
@@ -0,0 +1,68 @@
+#include "RowStore.h"
+#include <algorithm>
+#include <iterator>
+
+RowStore::RowStore() : storage(std::make_unique<Storage>(INITIAL_BYTES)) {}
+
+RowStore::RowStore(const RowStore& other) {
+    const TableRows& source = other.rows();
+    size_t columnCount = source.empty() ? 0 : source.front().size();
+    storage = std::make_unique<Storage>(bytesFor(source.size(), columnCount));
+    storage->rows.reserve(source.size());
+    for (const auto& row : source) {
+        storage->rows.emplace_back(row);
+    }
+}
+
+// 被移走的一方换成空的内存池，仍然可以使用
+RowStore::RowStore(RowStore&& other) : RowStore() {
+    storage.swap(other.storage);
+}
+
+RowStore& RowStore::operator=(const RowStore& other) {
+    if (this != &other) {
+        RowStore copy(other);
+        storage.swap(copy.storage);
+    }
+    return *this;
+}
+
+RowStore& RowStore::operator=(RowStore&& other) {
+    storage.swap(other.storage);
+    return *this;
+}
+
+void RowStore::push_back(const std::vector<std::string>& values) {
+    storage->rows.emplace_back(values.begin(), values.end());
+}
+
+void RowStore::push_back(std::vector<std::string>&& values) {
+    storage->rows.emplace_back(std::make_move_iterator(values.begin()),
+                               std::make_move_iterator(values.end()));
+}
+
+void RowStore::reserve(size_t rowCount, size_t columnCount) {
+    if (storage->rows.empty()) {
+        storage = std::make_unique<Storage>(bytesFor(rowCount, columnCount));
+    }
+    storage->rows.reserve(storage->rows.size() + rowCount);
+}
+
+size_t RowStore::memoryBytes() const {
+    size_t bytes = storage->rows.capacity() * sizeof(TableRow);
+    for (const auto& row : storage->rows) {
+        bytes += row.capacity() * sizeof(std::string);
+        for (const auto& value : row) {
+            // 短字符串存放在对象内部，不另外分配
+            if (value.capacity() >= sizeof(std::string)) {
+                bytes += value.capacity() + 1;
+            }
+        }
+    }
+    return bytes;
+}
+
+size_t RowStore::bytesFor(size_t rowCount, size_t columnCount) {
+    size_t rowBytes = sizeof(TableRow) + columnCount * sizeof(std::string);
+    return std::max(INITIAL_BYTES, rowCount * rowBytes);
+}
@@ -20,7 +20,8 @@ void SQLHighlighter::setupHighlightingRules() {
         "\\bASC\\b", "\\bDESC\\b", "\\bLIMIT\\b", "\\bOFFSET\\b",
         "\\bJOIN\\b", "\\bINNER\\b", "\\bLEFT\\b", "\\bRIGHT\\b",
         "\\bON\\b", "\\bAS\\b", "\\bIN\\b", "\\bLIKE\\b", "\\bIS\\b",
-        "\\bNULL\\b", "\\bNOT\\b", "\\bPRIMARY\\b", "\\bKEY\\b"
+        "\\bNULL\\b", "\\bNOT\\b", "\\bPRIMARY\\b", "\\bKEY\\b",
+        "\\bEXPLAIN\\b", "\\bANALYZE\\b"
     };
     
     for (const QString& pattern : keywordPatterns) {
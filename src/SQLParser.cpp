@@ -1,11 +1,14 @@
 #include "SQLParser.h"
+#include "Trace.h"
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <sstream>
 
 namespace SQLParser {
 
 ParsedQuery SQLParser::parse(const std::string& sql) {
+    TRACE_SCOPE("SQLParser::parse", "parse", sql);
     try {
         std::string cleanSql = removeSemicolon(sql);
         
@@ -14,26 +17,59 @@ ParsedQuery SQLParser::parse(const std::string& sql) {
         std::transform(upperSql.begin(), upperSql.end(), upperSql.begin(), ::toupper);
         
         // 确定SQL语句类型
-        if (upperSql.find("SELECT") == 0) {
-            return parseSelect(cleanSql);
+        ParsedQuery query;
+        if (upperSql.find("EXPLAIN") == 0) {
+            query = parseExplain(cleanSql);
+        } else if (upperSql.find("SELECT") == 0) {
+            query = parseSelect(cleanSql);
         } else if (upperSql.find("INSERT") == 0) {
-            return parseInsert(cleanSql);
+            query = parseInsert(cleanSql);
         } else if (upperSql.find("UPDATE") == 0) {
-            return parseUpdate(cleanSql);
+            query = parseUpdate(cleanSql);
         } else if (upperSql.find("DELETE") == 0) {
-            return parseDelete(cleanSql);
+            query = parseDelete(cleanSql);
         } else if (upperSql.find("CREATE") == 0) {
-            return parseCreate(cleanSql);
+            query = parseCreate(cleanSql);
         } else if (upperSql.find("DROP") == 0) {
-            return parseDrop(cleanSql);
+            query = parseDrop(cleanSql);
+        } else if (upperSql.find("ANALYZE") == 0) {
+            query = parseAnalyze(cleanSql);
+        } else if (upperSql.find("ALTER") == 0) {
+            query = parseAlter(cleanSql);
         } else {
             throw std::runtime_error("不支持的SQL语句类型");
         }
+        query.sql = cleanSql;
+        return query;
     } catch (const std::exception& e) {
         throw std::runtime_error("SQL解析失败: " + std::string(e.what()));
     }
 }
 
+ParsedQuery SQLParser::parseExplain(const std::string& sql) {
+    // EXPLAIN [ANALYZE] SELECT ...
+    std::string rest = trim(sql.substr(7));
+    bool analyze = false;
+    if (findKeyword(rest, "ANALYZE") == 0) {
+        analyze = true;
+        rest = trim(rest.substr(7));
+    }
+    
+    if (findKeyword(rest, "SELECT") != 0) {
+        throw std::runtime_error("EXPLAIN 只支持 SELECT 语句");
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    ParsedQuery query = parseSelect(rest);
+    query.explain = true;
+    query.explainAnalyze = analyze;
+    if (analyze) {
+        query.parseTimeMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+    return query;
+}
+
 ParsedQuery SQLParser::parseSelect(const std::string& sql) {
     std::string cleanSql = removeSemicolon(sql);
     
@@ -147,58 +183,21 @@ ParsedQuery SQLParser::parseSelect(const std::string& sql) {
             }
         }
         
-        // 解析FROM子句
-        size_t joinPos = findKeyword(cleanSql, "JOIN", fromPos);
-        size_t wherePos = findKeyword(cleanSql, "WHERE", fromPos);
-        
-        // 解析主表和别名
-        std::string fromStr = cleanSql.substr(fromPos + 4, 
-            (joinPos != std::string::npos ? joinPos : wherePos) - fromPos - 4);
-        std::istringstream fromIss(trim(fromStr));
-        fromIss >> query.tableName;
-        fromIss >> query.tableAlias;  // 可能为空
-        
-        // 处理 JOIN
-        if (joinPos != std::string::npos) {
-            std::string joinStr = cleanSql.substr(joinPos);
-            std::istringstream joinIss(joinStr);
-            std::string token;
-            
-            // 跳过 JOIN 关键字
-            joinIss >> token;  // "JOIN"
-            
-            // 检查是否有 JOIN 类型
-            size_t joinTypePos = joinPos - 6;  // 检查 JOIN 前面的单词
-            std::string joinTypeStr = cleanSql.substr(joinTypePos, 5);
-            
-            // 初始化连接表和条件的向量
-            query.joinTables.clear();
-            query.joinConditions.clear();
-            
-            // 读取连接表名和别名
-            std::string joinTable, joinTableAlias;
-            joinIss >> joinTable;
-            
-            // 检查是否有别名
-            joinIss >> token;
-            if (token != "ON") {
-                joinTableAlias = token;
-                joinIss >> token;  // 读取 "ON"
-            }
-            
-            // 读取连接条件
-            std::string onStr;
-            std::getline(joinIss, onStr);
-            onStr = trim(onStr);
-            
-            // 添加到连接表和条件列表
-            query.joinTables.push_back(joinTable);
-            query.joinConditions.push_back(onStr);
+        // FROM 子句到 WHERE、GROUP BY、ORDER BY 或 HAVING 为止
+        size_t wherePos = findKeywordToken(cleanSql, "WHERE", fromPos);
+        size_t fromEnd = cleanSql.length();
+        for (const char* keyword : {"WHERE", "GROUP BY", "ORDER BY", "HAVING"}) {
+            fromEnd = std::min(fromEnd, findKeywordToken(cleanSql, keyword, fromPos));
         }
+        parseFrom(cleanSql.substr(fromPos + 4, fromEnd - fromPos - 4), query);
         
-        // 解析WHERE条件
+        // 解析WHERE条件（到 GROUP BY、ORDER BY 或 HAVING 为止）
         if (wherePos != std::string::npos) {
-            query.whereClause = trim(cleanSql.substr(wherePos + 5));
+            size_t whereEnd = cleanSql.length();
+            for (const char* keyword : {"GROUP BY", "ORDER BY", "HAVING"}) {
+                whereEnd = std::min(whereEnd, findKeywordToken(cleanSql, keyword, wherePos));
+            }
+            query.whereClause = trim(cleanSql.substr(wherePos + 5, whereEnd - wherePos - 5));
         }
         
         // 解析 ORDER BY
@@ -368,6 +367,8 @@ ParsedQuery SQLParser::parseCreate(const std::string& sql) {
                         std::string null;
                         iss >> null;  // 读取"NULL"
                         col.nullable = false;
+                    } else if (constraint == "BLOOM") {
+                        col.bloomFilter = true;
                     }
                 }
                 
@@ -540,6 +541,174 @@ ParsedQuery SQLParser::parseDrop(const std::string& sql) {
     }
 }
 
+ParsedQuery SQLParser::parseAnalyze(const std::string& sql) {
+    // ANALYZE [TABLE] [表名]，省略表名时分析当前数据库的所有表
+    ParsedQuery query;
+    query.type = "ANALYZE";
+    
+    std::string rest = trim(sql.substr(7));
+    if (findKeyword(rest, "TABLE") == 0 &&
+        (rest.length() == 5 || std::isspace(static_cast<unsigned char>(rest[5])))) {
+        rest = trim(rest.substr(5));
+    }
+    query.tableName = rest;
+    return query;
+}
+
+ParsedQuery SQLParser::parseAlter(const std::string& sql) {
+    // ALTER TABLE 表名 ADD|DROP BLOOM FILTER (列 [, 列]...)
+    ParsedQuery query;
+    query.type = "ALTER";
+    
+    std::string rest = trim(sql.substr(5));
+    if (findKeywordToken(rest, "TABLE") != 0) {
+        throw std::runtime_error("ALTER 只支持 ALTER TABLE");
+    }
+    rest = trim(rest.substr(5));
+    
+    size_t addPos = findKeywordToken(rest, "ADD");
+    size_t dropPos = findKeywordToken(rest, "DROP");
+    bool add = addPos != std::string::npos && (dropPos == std::string::npos || addPos < dropPos);
+    size_t actionPos = add ? addPos : dropPos;
+    if (actionPos == std::string::npos) {
+        throw std::runtime_error("ALTER TABLE 缺少 ADD 或 DROP");
+    }
+    query.tableName = trim(rest.substr(0, actionPos));
+    
+    std::string action = trim(rest.substr(actionPos + (add ? 3 : 4)));
+    if (findKeywordToken(action, "BLOOM") != 0) {
+        throw std::runtime_error("ALTER TABLE 只支持 ADD/DROP BLOOM FILTER");
+    }
+    action = trim(action.substr(5));
+    if (findKeywordToken(action, "FILTER") == 0) {
+        action = trim(action.substr(6));
+    }
+    query.alterAction = add ? "ADD BLOOM FILTER" : "DROP BLOOM FILTER";
+    
+    // 列名可以放在括号中，多列用逗号分隔
+    if (!action.empty() && action.front() == '(' && action.back() == ')') {
+        action = action.substr(1, action.length() - 2);
+    }
+    std::istringstream iss(action);
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        Column col;
+        col.name = trim(name);
+        if (col.name.empty()) {
+            throw std::runtime_error("ALTER TABLE 缺少列名");
+        }
+        query.columns.push_back(col);
+    }
+    if (query.tableName.empty() || query.columns.empty()) {
+        throw std::runtime_error("ALTER TABLE 语法错误");
+    }
+    return query;
+}
+
+void SQLParser::parseFrom(const std::string& fromStr, ParsedQuery& query) {
+    // 表 [别名] [, 表 [别名]]... [[INNER|CROSS|LEFT|RIGHT|FULL [OUTER]] JOIN 表 [别名] [ON 条件]]...
+    std::string upperFrom = fromStr;
+    std::transform(upperFrom.begin(), upperFrom.end(), upperFrom.begin(), ::toupper);
+    
+    auto isWordChar = [](char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return std::isalnum(u) || c == '_' || u >= 0x80;
+    };
+    // end 之前的一个单词（大写），start 返回单词的起始位置
+    auto previousWord = [&](size_t end, size_t& start) {
+        size_t pos = end;
+        while (pos > 0 && std::isspace(static_cast<unsigned char>(fromStr[pos - 1]))) pos--;
+        size_t wordEnd = pos;
+        while (pos > 0 && isWordChar(fromStr[pos - 1])) pos--;
+        start = pos;
+        return upperFrom.substr(pos, wordEnd - pos);
+    };
+    auto parseTableRef = [](const std::string& ref, std::string& name, std::string& alias) {
+        std::istringstream iss(ref);
+        std::string token;
+        iss >> name;
+        if (iss >> token) {
+            std::string upperToken = token;
+            std::transform(upperToken.begin(), upperToken.end(), upperToken.begin(), ::toupper);
+            if (upperToken == "AS") {
+                iss >> token;
+            }
+            alias = token;
+        }
+    };
+    
+    // 找出每个 JOIN 及其前面的连接类型
+    struct JoinClause {
+        JoinType type;
+        size_t start;   // 连接类型关键字的起始位置
+        size_t end;     // JOIN 之后的位置
+    };
+    std::vector<JoinClause> joins;
+    size_t pos = 0;
+    while ((pos = findKeywordToken(fromStr, "JOIN", pos)) != std::string::npos) {
+        JoinClause clause{JoinType::INNER, pos, pos + 4};
+        size_t wordStart = pos;
+        std::string word = previousWord(pos, wordStart);
+        if (word == "OUTER") {
+            word = previousWord(wordStart, wordStart);
+            if (word != "LEFT" && word != "RIGHT" && word != "FULL") {
+                throw std::runtime_error("OUTER JOIN 前缺少 LEFT、RIGHT 或 FULL");
+            }
+        }
+        if (word == "LEFT" || word == "RIGHT" || word == "FULL" || word == "INNER" || word == "CROSS") {
+            clause.start = wordStart;
+            if (word == "LEFT") clause.type = JoinType::LEFT;
+            else if (word == "RIGHT") clause.type = JoinType::RIGHT;
+            else if (word == "FULL") clause.type = JoinType::FULL;
+        }
+        joins.push_back(clause);
+        pos = clause.end;
+    }
+    
+    // 逗号分隔的表
+    std::string tableList = trim(fromStr.substr(0, joins.empty() ? std::string::npos : joins[0].start));
+    if (tableList.empty()) {
+        throw std::runtime_error("缺少表名");
+    }
+    std::vector<std::string> tableRefs;
+    std::istringstream listIss(tableList);
+    std::string tableRef;
+    while (std::getline(listIss, tableRef, ',')) {
+        tableRefs.push_back(trim(tableRef));
+    }
+    
+    if (tableRefs.size() == 1) {
+        parseTableRef(tableRefs[0], query.tableName, query.tableAlias);
+    } else {
+        query.tableName.clear();
+        for (const auto& ref : tableRefs) {
+            std::string name, alias;
+            parseTableRef(ref, name, alias);
+            if (name.empty()) {
+                throw std::runtime_error("FROM 子句中缺少表名");
+            }
+            query.tableName += (query.tableName.empty() ? "" : ", ") + name + (alias.empty() ? "" : " " + alias);
+        }
+    }
+    
+    // 各个 JOIN 子句
+    for (size_t i = 0; i < joins.size(); i++) {
+        size_t bodyEnd = i + 1 < joins.size() ? joins[i + 1].start : fromStr.length();
+        std::string body = fromStr.substr(joins[i].end, bodyEnd - joins[i].end);
+        size_t onPos = findKeywordToken(body, "ON");
+        
+        std::string name, alias;
+        parseTableRef(trim(body.substr(0, onPos)), name, alias);
+        if (name.empty()) {
+            throw std::runtime_error("JOIN 缺少表名");
+        }
+        query.joinTables.push_back(name);
+        query.joinTableAliases.push_back(alias);
+        query.joinTypes.push_back(joins[i].type);
+        query.joinConditions.push_back(onPos == std::string::npos ? "" : trim(body.substr(onPos + 2)));
+    }
+}
+
 std::vector<Column> SQLParser::parseColumns(const std::string& columnsStr) {
     std::vector<Column> columns;
     std::istringstream iss(columnsStr);
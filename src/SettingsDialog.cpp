@@ -201,6 +201,33 @@ void SettingsDialog::createPerformanceTab(QWidget* tab) {
     connectionLayout->addWidget(new QLabel("查询超时:"), 1, 0);
     connectionLayout->addWidget(queryTimeoutBox, 1, 1);
     
+    // 慢查询日志设置
+    QGroupBox* slowQueryGroup = new QGroupBox("慢查询日志", tab);
+    QHBoxLayout* slowQueryLayout = new QHBoxLayout(slowQueryGroup);
+    slowQueryThresholdBox = new QSpinBox(slowQueryGroup);
+    slowQueryThresholdBox->setRange(-1, 3600000);
+    slowQueryThresholdBox->setSuffix(" 毫秒");
+    slowQueryThresholdBox->setSpecialValueText("关闭");
+    slowQueryLayout->addWidget(new QLabel("记录超过此耗时的语句:"));
+    slowQueryLayout->addWidget(slowQueryThresholdBox);
+    
+    // 内存设置
+    QGroupBox* memoryGroup = new QGroupBox("内存", tab);
+    QGridLayout* memoryLayout = new QGridLayout(memoryGroup);
+    tableMemoryBox = new QSpinBox(memoryGroup);
+    tableMemoryBox->setRange(0, 1048576);
+    tableMemoryBox->setSuffix(" MB");
+    tableMemoryBox->setSpecialValueText("不限制");
+    bufferPoolBox = new QSpinBox(memoryGroup);
+    bufferPoolBox->setRange(0, 1048576);
+    bufferPoolBox->setSuffix(" MB");
+    bufferPoolBox->setSpecialValueText("不缓存");
+    
+    memoryLayout->addWidget(new QLabel("已加载表数据上限:"), 0, 0);
+    memoryLayout->addWidget(tableMemoryBox, 0, 1);
+    memoryLayout->addWidget(new QLabel("数据页缓冲池:"), 1, 0);
+    memoryLayout->addWidget(bufferPoolBox, 1, 1);
+    
     // 编码设置
     QGroupBox* encodingGroup = new QGroupBox("编码", tab);
     QHBoxLayout* encodingLayout = new QHBoxLayout(encodingGroup);
@@ -216,6 +243,8 @@ void SettingsDialog::createPerformanceTab(QWidget* tab) {
     transactionLayout->addWidget(useTransactionsCheck);
     
     layout->addWidget(connectionGroup);
+    layout->addWidget(slowQueryGroup);
+    layout->addWidget(memoryGroup);
     layout->addWidget(encodingGroup);
     layout->addWidget(transactionGroup);
     layout->addStretch();
@@ -248,6 +277,9 @@ void SettingsDialog::loadSettings() {
     // 加载性能设置
     maxConnectionsBox->setValue(settings.value("maxConnections", 10).toInt());
     queryTimeoutBox->setValue(settings.value("queryTimeout", 30).toInt());
+    slowQueryThresholdBox->setValue(settings.value("slowQueryThreshold", 100).toInt());
+    tableMemoryBox->setValue(settings.value("tableMemoryMb", 0).toInt());
+    bufferPoolBox->setValue(settings.value("bufferPoolMb", 64).toInt());
     encodingCombo->setCurrentText(settings.value("defaultEncoding", "UTF-8").toString());
     useTransactionsCheck->setChecked(settings.value("useTransactions", true).toBool());
 }
@@ -279,6 +311,9 @@ void SettingsDialog::saveSettings() {
     // 保存性能设置
     settings.setValue("maxConnections", maxConnectionsBox->value());
     settings.setValue("queryTimeout", queryTimeoutBox->value());
+    settings.setValue("slowQueryThreshold", slowQueryThresholdBox->value());
+    settings.setValue("tableMemoryMb", tableMemoryBox->value());
+    settings.setValue("bufferPoolMb", bufferPoolBox->value());
     settings.setValue("defaultEncoding", encodingCombo->currentText());
     settings.setValue("useTransactions", useTransactionsCheck->isChecked());
 }
@@ -2,46 +2,125 @@
 #include <stdexcept>
 #include <algorithm>
 #include <sstream>
+#include <unordered_map>
+#include <cstdint>
 #include "SQLParser.h"
+#include "QueryProfile.h"
+#include "Trace.h"
+#include "ThreadPool.h"
 
 Table::Table(const std::string& tableName, const std::vector<ColumnDef>& cols)
     : name(tableName), columns(cols) {
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].bloomFilter) {
+            bloomFilters[i];
+        }
+        if (columns[i].type != "INTEGER" && columns[i].type != "FLOAT") {
+            dictionaries[i];
+        }
+    }
 }
 
 bool Table::insertRow(const std::vector<std::string>& values) {
     try {
-        if (values.size() != columns.size()) {
-            throw std::runtime_error("列数不匹配");
-        }
-        
-        // 验证数据类型
-        for (size_t i = 0; i < values.size(); i++) {
-            if (!validateDataType(values[i], columns[i].type)) {
-                throw std::runtime_error("数据类型不匹配: " + columns[i].name);
-            }
-            
-            // 检查非空约束
-            if (!columns[i].nullable && values[i].empty()) {
-                throw std::runtime_error("非空列不能为空: " + columns[i].name);
-            }
-        }
-        
-        // 更新索引
-        size_t rowIndex = data.size();
-        updateIndices(rowIndex, values);
-        
+        checkRow(values);
         data.push_back(values);
+        addedRow(data.size() - 1);
+        return true;
+    } catch (const std::exception& e) {
+        throw std::runtime_error("插入数据失败: " + std::string(e.what()));
+    }
+}
+
+bool Table::insertRow(std::vector<std::string>&& values) {
+    try {
+        checkRow(values);
+        data.push_back(std::move(values));
+        addedRow(data.size() - 1);
         return true;
     } catch (const std::exception& e) {
         throw std::runtime_error("插入数据失败: " + std::string(e.what()));
     }
 }
 
+void Table::checkRow(const std::vector<std::string>& values) const {
+    if (values.size() != columns.size()) {
+        throw std::runtime_error("列数不匹配");
+    }
+    
+    // 验证数据类型
+    for (size_t i = 0; i < values.size(); i++) {
+        if (!validateDataType(values[i], columns[i].type)) {
+            throw std::runtime_error("数据类型不匹配: " + columns[i].name);
+        }
+        
+        // 检查非空约束
+        if (!columns[i].nullable && values[i].empty()) {
+            throw std::runtime_error("非空列不能为空: " + columns[i].name);
+        }
+    }
+}
+
+void Table::appendRows(std::vector<std::vector<std::string>>& rows) {
+    for (auto& row : rows) {
+        data.push_back(std::move(row));
+    }
+}
+
+void Table::rebuildStructures(ThreadPool* pool) {
+    for (auto& [columnName, columnIndex] : indices) {
+        createIndex(columnName);
+    }
+    
+    // 各结构只读行存储、只写自己，可以同时重建
+    std::vector<std::function<void()>> tasks;
+    tasks.push_back([this]() { zoneMap.rebuild(data.rows()); });
+    for (auto& [colIndex, bloom] : bloomFilters) {
+        tasks.push_back([this, colIndex = colIndex, &bloom = bloom]() { bloom.rebuild(data.rows(), colIndex); });
+    }
+    for (auto& [colIndex, dictionary] : dictionaries) {
+        tasks.push_back([this, colIndex = colIndex, &dictionary = dictionary]() {
+            dictionary.rebuild(data.rows(), colIndex);
+        });
+    }
+    if (!pool) {
+        for (auto& task : tasks) {
+            task();
+        }
+        return;
+    }
+    std::vector<std::future<void>> results;
+    for (auto& task : tasks) {
+        results.push_back(pool->async(std::move(task)));
+    }
+    // 先等全部任务结束再抛出其中的异常，任务引用着这张表
+    for (auto& result : results) {
+        result.wait();
+    }
+    for (auto& result : results) {
+        result.get();
+    }
+}
+
+void Table::addedRow(size_t rowIndex) {
+    const TableRow& row = data[rowIndex];
+    updateIndices(rowIndex, row);
+    stats.addRow(row);
+    zoneMap.addRow(row);
+    for (auto& [colIndex, bloom] : bloomFilters) {
+        bloom.addRow(data.rows(), colIndex, rowIndex);
+    }
+    for (auto& [colIndex, dictionary] : dictionaries) {
+        dictionary.addRow(data.rows(), colIndex, rowIndex);
+    }
+}
+
 std::vector<std::vector<std::string>> Table::select(
     const std::vector<std::string>& columns,
     const std::string& whereClause,
     const std::string& orderByColumn,
-    bool orderDesc) const {
+    bool orderDesc,
+    QueryProfile* profile) const {
     
     try {
         std::vector<std::vector<std::string>> result;
@@ -61,19 +140,41 @@ std::vector<std::vector<std::string>> Table::select(
         }
         
         // 应用WHERE条件筛选数据
-        for (const auto& row : data) {
-            if (whereClause.empty() || evaluateCondition(row, whereClause)) {
-                std::vector<std::string> selectedRow;
-                for (size_t idx : columnIndices) {
-                    selectedRow.push_back(row[idx]);
+        auto scanStart = QueryProfile::now();
+        size_t examined = 0;
+        {
+            TRACE_SCOPE("Table::select", "scan", name);
+            auto conditions = splitConditions(whereClause);
+            auto bound = bindConditions(conditions);
+            for (const auto& [begin, end] : candidateRanges(conditions)) {
+                examined += end - begin;
+                for (size_t rowIndex = begin; rowIndex < end; rowIndex++) {
+                    const auto& row = data[rowIndex];
+                    if (evaluateCondition(rowIndex, bound)) {
+                        std::vector<std::string> selectedRow;
+                        selectedRow.reserve(columnIndices.size());
+                        for (size_t idx : columnIndices) {
+                            selectedRow.push_back(row[idx]);
+                        }
+                        result.push_back(std::move(selectedRow));
+                    }
                 }
-                result.push_back(selectedRow);
             }
         }
+        if (profile) {
+            profile->addRowsExamined(examined);
+            profile->addStage("全表扫描", describeScan(whereClause) + describeSkipped(examined),
+                              data.size(), result.size(), scanStart, &result);
+        }
         
         // 如果指定了排序列，进行排序
         if (!orderByColumn.empty()) {
+            auto sortStart = QueryProfile::now();
             sortData(result, orderByColumn, orderDesc);
+            if (profile) {
+                profile->addStage("排序", describeSort(orderByColumn, orderDesc),
+                                  result.size(), result.size(), sortStart);
+            }
         }
         
         return result;
@@ -92,39 +193,54 @@ bool Table::updateRows(
             throw std::runtime_error("更新的列数和值的数量不匹配");
         }
         
-        bool anyUpdated = false;
-        // 遍历所有行
-        for (size_t rowIndex = 0; rowIndex < data.size(); rowIndex++) {
-            // 检查WHERE条件
-            if (whereClause.empty() || evaluateCondition(data[rowIndex], whereClause)) {
-                // 从索引中移除旧值
-                removeFromIndices(rowIndex);
+        // 先找出满足WHERE条件的行（遍历区域映射未排除的行），更新时字典编码可能停用
+        std::vector<size_t> matchedRows;
+        auto conditions = splitConditions(whereClause);
+        auto bound = bindConditions(conditions);
+        for (const auto& [begin, end] : candidateRanges(conditions)) {
+            for (size_t rowIndex = begin; rowIndex < end; rowIndex++) {
+                if (evaluateCondition(rowIndex, bound)) {
+                    matchedRows.push_back(rowIndex);
+                }
+            }
+        }
+        
+        for (size_t rowIndex : matchedRows) {
+            // 从索引中移除旧值
+            removeFromIndices(rowIndex);
+            
+            // 更新值
+            for (size_t i = 0; i < updateColumns.size(); i++) {
+                size_t colIndex;
+                try {
+                    colIndex = getColumnIndex(updateColumns[i]);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error("更新列不存在: " + updateColumns[i]);
+                }
                 
-                // 更新值
-                for (size_t i = 0; i < updateColumns.size(); i++) {
-                    size_t colIndex;
-                    try {
-                        colIndex = getColumnIndex(updateColumns[i]);
-                    } catch (const std::exception& e) {
-                        throw std::runtime_error("更新列不存在: " + updateColumns[i]);
-                    }
-                    
-                    // 验证数据类型
-                    if (!validateDataType(updateValues[i], columns[colIndex].type)) {
-                        throw std::runtime_error("数据类型不匹配: " + updateColumns[i]);
-                    }
-                    
-                    // 更新值
-                    data[rowIndex][colIndex] = updateValues[i];
+                // 验证数据类型
+                if (!validateDataType(updateValues[i], columns[colIndex].type)) {
+                    throw std::runtime_error("数据类型不匹配: " + updateColumns[i]);
                 }
                 
-                // 更新索引
-                updateIndices(rowIndex, data[rowIndex]);
-                anyUpdated = true;
+                // 更新值
+                data[rowIndex][colIndex] = updateValues[i];
+            }
+            
+            // 更新索引、区域映射、布隆过滤器和字典编码
+            updateIndices(rowIndex, data[rowIndex]);
+            zoneMap.updateRow(rowIndex, data[rowIndex]);
+            for (auto& [colIndex, bloom] : bloomFilters) {
+                bloom.updateRow(rowIndex, data[rowIndex][colIndex]);
+            }
+            for (auto& [colIndex, dictionary] : dictionaries) {
+                dictionary.updateRow(data.rows(), colIndex, rowIndex);
             }
         }
         
-        return anyUpdated;
+        size_t updatedRows = matchedRows.size();
+        stats.recordModification(updatedRows);
+        return updatedRows > 0;
     } catch (const std::exception& e) {
         throw std::runtime_error("更新失败: " + std::string(e.what()));
     }
@@ -132,63 +248,247 @@ bool Table::updateRows(
 
 bool Table::deleteRows(const std::string& whereClause) {
     try {
-        bool anyDeleted = false;
+        size_t deletedRows = 0;
+        auto conditions = splitConditions(whereClause);
+        auto bound = bindConditions(conditions);
+        auto ranges = candidateRanges(conditions);
         
-        // 从后向前遍历，这样删除时不会影响未处理的索引
-        for (int rowIndex = data.size() - 1; rowIndex >= 0; rowIndex--) {
-            if (whereClause.empty() || evaluateCondition(data[rowIndex], whereClause)) {
-                // 从索引中移除
-                removeFromIndices(rowIndex);
-                
-                // 从数据中移除
-                data.erase(data.begin() + rowIndex);
-                anyDeleted = true;
+        // 从后向前遍历，这样删除时不会影响未处理的索引（和字典编码）
+        for (auto range = ranges.rbegin(); range != ranges.rend(); ++range) {
+            for (size_t rowIndex = range->second; rowIndex-- > range->first; ) {
+                if (evaluateCondition(rowIndex, bound)) {
+                    // 从索引中移除
+                    removeFromIndices(rowIndex);
+                    
+                    // 从数据中移除
+                    data.erase(data.begin() + rowIndex);
+                    deletedRows++;
+                }
             }
         }
         
-        return anyDeleted;
+        // 删除后其后各行的行号前移，索引、区域映射、布隆过滤器和字典编码需要重建
+        if (deletedRows > 0) {
+            rebuildStructures();
+        }
+        
+        stats.removeRows(deletedRows);
+        return deletedRows > 0;
     } catch (const std::exception& e) {
         throw std::runtime_error("删除失败: " + std::string(e.what()));
     }
 }
 
+
 std::vector<std::vector<std::string>> Table::join(
     const Table& otherTable,
     const std::string& leftCol,
     const std::string& rightCol,
-    JoinType joinType) {
+    JoinType joinType,
+    JoinMethod method) const {
     
     size_t leftIdx = getColumnIndex(leftCol);
     size_t rightIdx = otherTable.getColumnIndex(rightCol);
+    const std::string& keyType = columns[leftIdx].type;
+    const auto& otherData = otherTable.getData();
+    const bool keepLeft = joinType == JoinType::LEFT || joinType == JoinType::FULL;
+    const bool keepRight = joinType == JoinType::RIGHT || joinType == JoinType::FULL;
+    
+    const auto* rightIndex = otherTable.getIndex(rightCol);
+    // 数值列按数值比较（"1" 与 "1.0" 相等），不能按存储的文本编码连接
+    const bool textKey = keyType != "INTEGER" && keyType != "FLOAT";
+    const ColumnDictionary* leftDictionary = textKey ? getDictionary(leftIdx) : nullptr;
+    const ColumnDictionary* rightDictionary = textKey ? otherTable.getDictionary(rightIdx) : nullptr;
+    if (method == JoinMethod::AUTO) {
+        bool small = data.size() * otherData.size() <= NESTED_LOOP_JOIN_LIMIT;
+        if (leftDictionary && rightDictionary) {
+            method = JoinMethod::DICTIONARY;
+        } else if (rightIndex && textKey) {
+            method = JoinMethod::INDEX_NESTED_LOOP;
+        } else {
+            method = (getIndex(leftCol) != nullptr || !small) ? JoinMethod::SORT_MERGE : JoinMethod::NESTED_LOOP;
+        }
+    }
+    if (method == JoinMethod::INDEX_NESTED_LOOP && !rightIndex) {
+        throw std::runtime_error("列上没有索引: " + rightCol);
+    }
+    // 索引按存储的文本查找，数值键（"1" 与 "01"、"1.0"）改为排序合并，结果与其他算法相同
+    if (method == JoinMethod::INDEX_NESTED_LOOP && !textKey) {
+        method = JoinMethod::SORT_MERGE;
+    }
+    if (method == JoinMethod::DICTIONARY && !(leftDictionary && rightDictionary)) {
+        throw std::runtime_error("连接列没有字典编码: " + (leftDictionary ? rightCol : leftCol));
+    }
     
     std::vector<std::vector<std::string>> result;
+    std::vector<char> rightMatched(keepRight ? otherData.size() : 0, 0);
     
-    // 对于每一行
-    for (const auto& leftRow : data) {
-        bool matched = false;
-        
-        // 查找匹配的右表行
-        for (const auto& rightRow : otherTable.getData()) {
-            if (leftRow[leftIdx] == rightRow[rightIdx]) {
-                // 合并行
-                std::vector<std::string> joinedRow = leftRow;
-                joinedRow.insert(joinedRow.end(), rightRow.begin(), rightRow.end());
-                result.push_back(joinedRow);
+    // 合并行，外连接补齐的一侧为 nullptr
+    auto emit = [&](const TableRow* leftRow, const TableRow* rightRow) {
+        std::vector<std::string> joinedRow;
+        joinedRow.reserve(columns.size() + otherTable.getColumns().size());
+        if (leftRow) {
+            joinedRow.insert(joinedRow.end(), leftRow->begin(), leftRow->end());
+        } else {
+            joinedRow.insert(joinedRow.end(), columns.size(), "NULL");
+        }
+        if (rightRow) {
+            joinedRow.insert(joinedRow.end(), rightRow->begin(), rightRow->end());
+        } else {
+            joinedRow.insert(joinedRow.end(), otherTable.getColumns().size(), "NULL");
+        }
+        result.push_back(std::move(joinedRow));
+    };
+    auto less = [&keyType](const std::string& a, const std::string& b) {
+        return compareValues(a, b, keyType);
+    };
+    
+    if (method == JoinMethod::DICTIONARY) {
+        // 右表字典的每个编码转换为左表字典中同一个值的编码（空值不转换），
+        // 右表行按转换后的编码分组，左表行按自己的编码直接取出匹配的行
+        std::vector<uint32_t> translated(rightDictionary->size());
+        for (uint32_t code = 0; code < translated.size(); code++) {
+            const std::string& value = rightDictionary->value(code);
+            translated[code] = value.empty() ? ColumnDictionary::NO_CODE : leftDictionary->find(value);
+        }
+        std::vector<std::vector<size_t>> rightByCode(leftDictionary->size());
+        for (size_t ri = 0; ri < otherData.size(); ri++) {
+            uint32_t code = translated[rightDictionary->code(ri)];
+            if (code != ColumnDictionary::NO_CODE) {
+                rightByCode[code].push_back(ri);
+            }
+        }
+        for (size_t li = 0; li < data.size(); li++) {
+            const auto& matches = rightByCode[leftDictionary->code(li)];
+            if (matches.empty() && keepLeft) {
+                emit(&data[li], nullptr);
+            }
+            for (size_t ri : matches) {
+                emit(&data[li], &otherData[ri]);
+                if (keepRight) rightMatched[ri] = 1;
+            }
+        }
+    } else if (method == JoinMethod::INDEX_NESTED_LOOP) {
+        // 每个左表行在右表的索引中查找匹配的行
+        for (const auto& leftRow : data) {
+            const std::string& key = leftRow[leftIdx];
+            auto it = key.empty() ? rightIndex->end() : rightIndex->find(key);
+            if (it == rightIndex->end()) {
+                if (keepLeft) emit(&leftRow, nullptr);
+                continue;
+            }
+            for (size_t ri : it->second) {
+                emit(&leftRow, &otherData[ri]);
+                if (keepRight) rightMatched[ri] = 1;
+            }
+        }
+    } else if (method == JoinMethod::NESTED_LOOP) {
+        // 对于每一行
+        for (const auto& leftRow : data) {
+            const std::string& key = leftRow[leftIdx];
+            bool matched = false;
+            
+            // 查找匹配的右表行
+            for (size_t ri = 0; ri < otherData.size(); ri++) {
+                const std::string& value = otherData[ri][rightIdx];
+                if (key.empty() || value.empty() || less(key, value) || less(value, key)) {
+                    continue;
+                }
+                emit(&leftRow, &otherData[ri]);
+                if (keepRight) rightMatched[ri] = 1;
                 matched = true;
             }
+            
+            // 处理外连接
+            if (!matched && keepLeft) {
+                emit(&leftRow, nullptr);
+            }
         }
+    } else {
+        // 两侧按连接键排序后合并，只保存行号；键相同的两组行两两连接
+        std::vector<size_t> leftIds = sortedRowIds(leftIdx, keyType);
+        std::vector<size_t> rightIds = otherTable.sortedRowIds(rightIdx, keyType);
         
-        // 处理外连接
-        if (!matched && (joinType == JoinType::LEFT || joinType == JoinType::FULL)) {
-            std::vector<std::string> joinedRow = leftRow;
-            joinedRow.insert(joinedRow.end(), otherTable.getColumns().size(), "NULL");
-            result.push_back(joinedRow);
+        size_t i = 0;
+        size_t j = 0;
+        while (i < leftIds.size()) {
+            const std::string& key = data[leftIds[i]][leftIdx];
+            size_t leftEnd = i + 1;
+            while (leftEnd < leftIds.size() && !less(key, data[leftIds[leftEnd]][leftIdx])) {
+                leftEnd++;
+            }
+            while (j < rightIds.size() && less(otherData[rightIds[j]][rightIdx], key)) {
+                j++;
+            }
+            size_t rightEnd = j;
+            while (rightEnd < rightIds.size() && !less(key, otherData[rightIds[rightEnd]][rightIdx])) {
+                rightEnd++;
+            }
+            
+            // 空值排在最前面，不参与匹配
+            bool matched = !key.empty() && rightEnd > j;
+            for (size_t a = i; a < leftEnd; a++) {
+                if (!matched) {
+                    if (keepLeft) emit(&data[leftIds[a]], nullptr);
+                    continue;
+                }
+                for (size_t b = j; b < rightEnd; b++) {
+                    emit(&data[leftIds[a]], &otherData[rightIds[b]]);
+                    if (keepRight) rightMatched[rightIds[b]] = 1;
+                }
+            }
+            i = leftEnd;
+            j = rightEnd;
+        }
+    }
+    
+    // 右表未匹配的行
+    if (keepRight) {
+        for (size_t ri = 0; ri < otherData.size(); ri++) {
+            if (!rightMatched[ri]) {
+                emit(nullptr, &otherData[ri]);
+            }
         }
     }
     
     return result;
 }
 
+std::vector<size_t> Table::sortedRowIds(size_t colIndex, const std::string& type) const {
+    std::vector<size_t> ids;
+    ids.reserve(data.size());
+    auto less = [&type](const std::string& a, const std::string& b) {
+        return compareValues(a, b, type);
+    };
+    
+    // 索引按字典序分组，数值类型再对不同的值排序
+    auto indexIt = indices.find(columns[colIndex].name);
+    if (indexIt != indices.end()) {
+        std::vector<const std::pair<const std::string, std::set<size_t>>*> groups;
+        groups.reserve(indexIt->second.size());
+        for (const auto& entry : indexIt->second) {
+            groups.push_back(&entry);
+        }
+        if (type == "INTEGER" || type == "FLOAT") {
+            std::stable_sort(groups.begin(), groups.end(), [&less](const auto* a, const auto* b) {
+                return less(a->first, b->first);
+            });
+        }
+        for (const auto* group : groups) {
+            ids.insert(ids.end(), group->second.begin(), group->second.end());
+        }
+        return ids;
+    }
+    
+    for (size_t i = 0; i < data.size(); i++) {
+        ids.push_back(i);
+    }
+    std::stable_sort(ids.begin(), ids.end(), [&](size_t a, size_t b) {
+        return less(data[a][colIndex], data[b][colIndex]);
+    });
+    return ids;
+}
+
 bool Table::createIndex(const std::string& columnName) {
     size_t colIndex = getColumnIndex(columnName);
     
@@ -207,6 +507,39 @@ bool Table::dropIndex(const std::string& columnName) {
     return indices.erase(columnName) > 0;
 }
 
+void Table::setBloomFilter(const std::string& columnName, bool enabled) {
+    size_t colIndex = getColumnIndex(columnName);
+    columns[colIndex].bloomFilter = enabled;
+    if (enabled) {
+        bloomFilters[colIndex].rebuild(data.rows(), colIndex);
+    } else {
+        bloomFilters.erase(colIndex);
+    }
+}
+
+bool Table::hasBloomFilter(const std::string& columnName) const {
+    for (const auto& [colIndex, bloom] : bloomFilters) {
+        if (columns[colIndex].name == columnName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Table::mayContain(const std::string& columnName, const std::string& value) const {
+    for (const auto& [colIndex, bloom] : bloomFilters) {
+        if (columns[colIndex].name == columnName) {
+            return bloom.mayContain(value);
+        }
+    }
+    return true;
+}
+
+const std::map<std::string, std::set<size_t>>* Table::getIndex(const std::string& columnName) const {
+    auto it = indices.find(columnName);
+    return it == indices.end() ? nullptr : &it->second;
+}
+
 bool Table::validateDataType(const std::string& value, const std::string& type) {
     if (type == "INTEGER") {
         try {
@@ -235,64 +568,130 @@ size_t Table::getColumnIndex(const std::string& columnName) const {
     throw std::runtime_error("列不存在: " + columnName);
 }
 
-bool Table::evaluateCondition(const std::vector<std::string>& row, const std::string& whereClause) const {
+bool Table::evaluateCondition(const TableRow& row, const std::string& whereClause) const {
     if (whereClause.empty()) {
         return true;
     }
     
     try {
-        // 分割多个条件（用 AND 连接的条件）
-        std::vector<std::string> conditions;
-        size_t pos = 0;
-        while (pos < whereClause.length()) {
-            size_t andPos = whereClause.find("AND", pos);
-            if (andPos == std::string::npos) {
-                conditions.push_back(trim(whereClause.substr(pos)));
+        return evaluateCondition(row, splitConditions(whereClause));
+    } catch (const std::exception& e) {
+        throw std::runtime_error("条件评估失败: " + std::string(e.what()));
+    }
+}
+
+std::vector<Condition> Table::splitConditions(const std::string& whereClause) const {
+    std::vector<Condition> conditions;
+    
+    // 分割多个条件（用 AND 连接的条件）
+    size_t pos = 0;
+    while (pos < whereClause.length()) {
+        size_t andPos = whereClause.find("AND", pos);
+        std::string cond = trim(andPos == std::string::npos
+                                ? whereClause.substr(pos)
+                                : whereClause.substr(pos, andPos - pos));
+        pos = andPos == std::string::npos ? whereClause.length() : andPos + 3;  // Skip "AND"
+        
+        // 查找操作符
+        std::vector<std::string> operators = {">=", "<=", "!=", "=", ">", "<"};
+        std::string op;
+        size_t opPos = std::string::npos;
+        
+        for (const auto& testOp : operators) {
+            if ((opPos = cond.find(testOp)) != std::string::npos) {
+                op = testOp;
                 break;
             }
-            conditions.push_back(trim(whereClause.substr(pos, andPos - pos)));
-            pos = andPos + 3;  // Skip "AND"
         }
         
-        // 评估每个条件
-        for (const auto& cond : conditions) {
-            // 查找操作符
-            std::vector<std::string> operators = {">=", "<=", "!=", "=", ">", "<"};
-            std::string op;
-            size_t opPos = std::string::npos;
-            
-            for (const auto& testOp : operators) {
-                if ((opPos = cond.find(testOp)) != std::string::npos) {
-                    op = testOp;
-                    break;
-                }
-            }
-            
-            if (opPos == std::string::npos) {
-                throw std::runtime_error("无效的条件: " + cond);
-            }
-            
-            // 获取列名和值
-            std::string colName = trim(cond.substr(0, opPos));
-            std::string value = trim(cond.substr(opPos + op.length()));
-            
-            // 如果值是字符串字面量，去掉引号
-            if (value.front() == '\'' && value.back() == '\'') {
-                value = value.substr(1, value.length() - 2);
+        if (opPos == std::string::npos) {
+            throw std::runtime_error("无效的条件: " + cond);
+        }
+        
+        // 获取列名和值
+        Condition condition;
+        condition.column = trim(cond.substr(0, opPos));
+        condition.operation = op;
+        condition.value = trim(cond.substr(opPos + op.length()));
+        
+        // 如果值是字符串字面量，去掉引号
+        const std::string& value = condition.value;
+        if (!value.empty() && value.front() == '\'' && value.back() == '\'') {
+            condition.value = value.substr(1, value.length() - 2);
+        }
+        conditions.push_back(std::move(condition));
+    }
+    return conditions;
+}
+
+bool Table::evaluateCondition(const TableRow& row, const std::vector<Condition>& conditions) const {
+    // 评估每个条件
+    for (const auto& cond : conditions) {
+        // 获取列值
+        size_t colIndex;
+        try {
+            colIndex = getColumnIndex(cond.column);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("条件中的列不存在: " + cond.column);
+        }
+        
+        const std::string& rowValue = row[colIndex];
+        const std::string& value = cond.value;
+        const std::string& op = cond.operation;
+        
+        // 比较值
+        bool condResult;
+        if (op == "=") condResult = rowValue == value;
+        else if (op == "!=") condResult = rowValue != value;
+        else if (op == ">") condResult = rowValue > value;
+        else if (op == "<") condResult = rowValue < value;
+        else if (op == ">=") condResult = rowValue >= value;
+        else if (op == "<=") condResult = rowValue <= value;
+        else throw std::runtime_error("不支持的操作符: " + op);
+        
+        if (!condResult) return false;  // 如果任何条件不满足，返回false
+    }
+    
+    return true;  // 所有条件都满足
+}
+
+std::vector<Table::BoundCondition> Table::bindConditions(const std::vector<Condition>& conditions) const {
+    std::vector<BoundCondition> bound;
+    for (const auto& cond : conditions) {
+        BoundCondition b{&cond, std::string::npos, nullptr, ColumnDictionary::NO_CODE};
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (columns[i].name == cond.column) {
+                b.column = i;
+                break;
             }
-            
-            // 获取列值
-            size_t colIndex;
-            try {
-                colIndex = getColumnIndex(colName);
-            } catch (const std::exception& e) {
-                throw std::runtime_error("条件中的列不存在: " + colName);
+        }
+        if (b.column != std::string::npos && (cond.operation == "=" || cond.operation == "!=")) {
+            b.dictionary = getDictionary(b.column);
+            if (b.dictionary) {
+                b.code = b.dictionary->find(cond.value);
             }
-            
-            std::string rowValue = row[colIndex];
-            
-            // 比较值
-            bool condResult;
+        }
+        bound.push_back(b);
+    }
+    return bound;
+}
+
+bool Table::evaluateCondition(size_t rowIndex, const std::vector<BoundCondition>& conditions) const {
+    // 与按行求值的规则相同；字典编码列上的 = 和 != 比较编码，值不在字典中时没有行等于它
+    for (const auto& bound : conditions) {
+        const Condition& cond = *bound.condition;
+        if (bound.column == std::string::npos) {
+            throw std::runtime_error("条件中的列不存在: " + cond.column);
+        }
+        
+        bool condResult;
+        if (bound.dictionary) {
+            bool equal = bound.code != ColumnDictionary::NO_CODE && bound.dictionary->code(rowIndex) == bound.code;
+            condResult = cond.operation == "=" ? equal : !equal;
+        } else {
+            const std::string& rowValue = data[rowIndex][bound.column];
+            const std::string& value = cond.value;
+            const std::string& op = cond.operation;
             if (op == "=") condResult = rowValue == value;
             else if (op == "!=") condResult = rowValue != value;
             else if (op == ">") condResult = rowValue > value;
@@ -300,14 +699,80 @@ bool Table::evaluateCondition(const std::vector<std::string>& row, const std::st
             else if (op == ">=") condResult = rowValue >= value;
             else if (op == "<=") condResult = rowValue <= value;
             else throw std::runtime_error("不支持的操作符: " + op);
-            
-            if (!condResult) return false;  // 如果任何条件不满足，返回false
         }
         
-        return true;  // 所有条件都满足
-    } catch (const std::exception& e) {
-        throw std::runtime_error("条件评估失败: " + std::string(e.what()));
+        if (!condResult) return false;
     }
+    return true;
+}
+
+const ColumnDictionary* Table::getDictionary(size_t column) const {
+    auto it = dictionaries.find(column);
+    return it != dictionaries.end() && it->second.isActive(data.size()) ? &it->second : nullptr;
+}
+
+std::vector<std::pair<size_t, size_t>> Table::candidateRanges(const std::vector<Condition>& conditions) const {
+    // 没有条件或区域映射与数据不一致时扫描整张表
+    if (conditions.empty() || zoneMap.getRowCount() != data.size()) {
+        return {{0, data.size()}};
+    }
+    
+    // 条件中的列位置，不存在的列不用于跳过（求值时报错）
+    std::vector<std::pair<size_t, const Condition*>> usable;
+    for (const auto& cond : conditions) {
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (columns[i].name == cond.column) {
+                usable.emplace_back(i, &cond);
+                break;
+            }
+        }
+    }
+    
+    // 等值条件的值不在列的字典或整张表的布隆过滤器中时不需要扫描
+    std::vector<std::pair<const ColumnBloomFilter*, const Condition*>> equalities;
+    for (const auto& [colIndex, cond] : usable) {
+        const ColumnDictionary* dictionary = getDictionary(colIndex);
+        if (cond->operation == "=" && dictionary && dictionary->find(cond->value) == ColumnDictionary::NO_CODE) {
+            return {};
+        }
+        auto bloomIt = bloomFilters.find(colIndex);
+        if (cond->operation == "=" && bloomIt != bloomFilters.end()) {
+            if (!bloomIt->second.mayContain(cond->value)) {
+                return {};
+            }
+            equalities.emplace_back(&bloomIt->second, cond);
+        }
+    }
+    
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t block = 0; block < zoneMap.blockCount(); block++) {
+        bool skip = false;
+        for (const auto& [colIndex, cond] : usable) {
+            if (!zoneMap.mayMatch(block, colIndex, cond->operation, cond->value)) {
+                skip = true;
+                break;
+            }
+        }
+        for (const auto& [bloom, cond] : equalities) {
+            if (skip || !bloom->blockMayContain(block, cond->value)) {
+                skip = true;
+                break;
+            }
+        }
+        if (skip) {
+            continue;
+        }
+        
+        // 相邻的块合并为一个区间
+        size_t begin = block * ZoneMap::BLOCK_ROWS;
+        size_t end = std::min(data.size(), begin + ZoneMap::BLOCK_ROWS);
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        } else {
+            ranges.emplace_back(begin, end);
+        }
+    }
+    return ranges;
 }
 
 bool Table::evaluateSingleCondition(const std::string& value, const Condition& cond) const {
@@ -327,7 +792,7 @@ bool Table::evaluateSingleCondition(const std::string& value, const Condition& c
     throw std::runtime_error("不支持的操作符: " + cond.operation);
 }
 
-void Table::updateIndices(size_t rowIndex, const std::vector<std::string>& values) {
+void Table::updateIndices(size_t rowIndex, const TableRow& values) {
     for (size_t i = 0; i < columns.size(); i++) {
         const std::string& columnName = columns[i].name;
         if (indices.find(columnName) != indices.end()) {
@@ -474,6 +939,7 @@ std::vector<std::vector<std::string>> Table::groupData(
 void Table::sortData(std::vector<std::vector<std::string>>& data,
                     const std::string& orderByColumn,
                     bool desc) const {
+    TRACE_SCOPE("Table::sortData", "sort", name);
     try {
         // 获取排序列的索引和类型
         size_t sortColIndex = getColumnIndex(orderByColumn);
@@ -608,18 +1074,37 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
     const std::vector<SQLParser::Column>& columns,
     const std::string& whereClause,
     const std::vector<std::string>& groupByColumns,
-    const std::string& havingClause) const {
+    const std::string& havingClause,
+    QueryProfile* profile) const {
     
     try {
         // 首先应用 WHERE 条件过滤数据
-        std::vector<std::vector<std::string>> filteredData;
-        for (const auto& row : data) {
-            if (whereClause.empty() || evaluateCondition(row, whereClause)) {
-                filteredData.push_back(row);
+        // 过滤和分组的中间结果只记录行号，值直接从表的行存储中读取，不复制行
+        auto scanStart = QueryProfile::now();
+        std::vector<size_t> filteredRows;
+        size_t examined = 0;
+        {
+            TRACE_SCOPE("Table::selectWithAggregates", "scan", name);
+            auto conditions = splitConditions(whereClause);
+            auto bound = bindConditions(conditions);
+            for (const auto& [begin, end] : candidateRanges(conditions)) {
+                examined += end - begin;
+                for (size_t rowIndex = begin; rowIndex < end; rowIndex++) {
+                    if (evaluateCondition(rowIndex, bound)) {
+                        filteredRows.push_back(rowIndex);
+                    }
+                }
             }
         }
+        if (profile) {
+            profile->addRowsExamined(examined);
+            profile->addStage("全表扫描", describeScan(whereClause) + describeSkipped(examined),
+                              data.size(), filteredRows.size(), scanStart);
+        }
         
         // 如果没有分组，直接计算聚合
+        TRACE_SCOPE("Table::selectWithAggregates", "aggregate", name);
+        auto aggregateStart = QueryProfile::now();
         if (groupByColumns.empty()) {
             std::vector<std::vector<std::string>> result;
             std::vector<std::string> row;
@@ -628,7 +1113,7 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
                 if (col.aggregateFunc != SQLParser::AggregateFunction::NONE) {
                     // 特殊处理 COUNT(*)
                     if (col.aggregateFunc == SQLParser::AggregateFunction::COUNT && col.name == "*") {
-                        row.push_back(std::to_string(filteredData.size()));
+                        row.push_back(std::to_string(filteredRows.size()));
                         continue;
                     }
                     
@@ -636,8 +1121,9 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
                     std::vector<std::string> values;
                     try {
                         size_t colIndex = getColumnIndex(col.name);
-                        for (const auto& dataRow : filteredData) {
-                            values.push_back(dataRow[colIndex]);
+                        values.reserve(filteredRows.size());
+                        for (size_t rowIndex : filteredRows) {
+                            values.push_back(data[rowIndex][colIndex]);
                         }
                     } catch (const std::exception& e) {
                         throw std::runtime_error("聚合列不存在: " + col.name);
@@ -647,31 +1133,84 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
                     // 非聚合列，使用第一行的值
                     try {
                         size_t colIndex = getColumnIndex(col.name);
-                        row.push_back(filteredData[0][colIndex]);
+                        row.push_back(data[filteredRows[0]][colIndex]);
                     } catch (const std::exception& e) {
                         throw std::runtime_error("列不存在: " + col.name);
                     }
                 }
             }
             result.push_back(row);
+            if (profile) {
+                profile->addStage("聚合", describeAggregates(columns, {}, ""),
+                                  filteredRows.size(), result.size(), aggregateStart, &result);
+            }
             return result;
         }
         
+        // 分组列都有字典编码时，分组键为各列编码按混合进制组合成的整数
+        std::vector<std::pair<size_t, const ColumnDictionary*>> groupDictionaries;
+        bool encoded = true;
+        uint64_t keySpace = 1;
+        for (const auto& groupCol : groupByColumns) {
+            size_t colIndex;
+            try {
+                colIndex = getColumnIndex(groupCol);
+            } catch (const std::exception& e) {
+                throw std::runtime_error("分组列不存在: " + groupCol);
+            }
+            const ColumnDictionary* dictionary = getDictionary(colIndex);
+            size_t radix = dictionary ? std::max<size_t>(dictionary->size(), 1) : 0;
+            if (!dictionary || keySpace > UINT64_MAX / radix) {
+                encoded = false;
+                continue;
+            }
+            keySpace *= radix;
+            groupDictionaries.emplace_back(colIndex, dictionary);
+        }
+        if (!encoded) {
+            groupDictionaries.clear();
+        }
+        
         // 按分组列进行分组
-        std::map<std::string, std::vector<std::vector<std::string>>> groups;
-        for (const auto& row : filteredData) {
+        std::map<std::string, std::vector<size_t>> groups;   // 分组键 -> 行号
+        auto groupKeyOf = [&](const TableRow& row) {
             std::string groupKey;
             for (const auto& groupCol : groupByColumns) {
                 if (!groupKey.empty()) groupKey += "|";
-                try {
-                    size_t colIndex = getColumnIndex(groupCol);
-                    groupKey += row[colIndex];
-                } catch (const std::exception& e) {
-                    throw std::runtime_error("分组列不存在: " + groupCol);
+                groupKey += row[getColumnIndex(groupCol)];
+            }
+            return groupKey;
+        };
+        if (!groupDictionaries.empty()) {
+            // 先按编码分组，每组只生成一次文本分组键，结果顺序与按文本分组相同
+            std::unordered_map<uint64_t, std::vector<size_t>> codeGroups;
+            for (size_t i = 0; i < filteredRows.size(); i++) {
+                uint64_t code = 0;
+                for (const auto& [colIndex, dictionary] : groupDictionaries) {
+                    code = code * dictionary->size() + dictionary->code(filteredRows[i]);
                 }
+                codeGroups[code].push_back(i);
+            }
+            for (auto& [code, members] : codeGroups) {
+                auto& groupRows = groups[groupKeyOf(data[filteredRows[members[0]]])];
+                for (size_t i : members) {
+                    groupRows.push_back(filteredRows[i]);
+                }
+            }
+        } else {
+            for (size_t rowIndex : filteredRows) {
+                groups[groupKeyOf(data[rowIndex])].push_back(rowIndex);
             }
-            groups[groupKey].push_back(row);
         }
+        if (profile) {
+            std::string detail = "GROUP BY ";
+            for (size_t i = 0; i < groupByColumns.size(); i++) {
+                detail += (i > 0 ? ", " : "") + groupByColumns[i];
+            }
+            profile->addStage("分组", detail + (groupDictionaries.empty() ? "（有序映射）" : "（字典编码）"),
+                              filteredRows.size(), groups.size(), aggregateStart);
+        }
+        auto groupAggregateStart = QueryProfile::now();
         
         // 对每个分组计算结果
         std::vector<std::vector<std::string>> result;
@@ -682,7 +1221,7 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
             for (const auto& groupCol : groupByColumns) {
                 try {
                     size_t colIndex = getColumnIndex(groupCol);
-                    resultRow.push_back(groupRows[0][colIndex]);
+                    resultRow.push_back(data[groupRows[0]][colIndex]);
                 } catch (const std::exception& e) {
                     throw std::runtime_error("分组列不存在: " + groupCol);
                 }
@@ -700,8 +1239,9 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
                     std::vector<std::string> values;
                     try {
                         size_t colIndex = getColumnIndex(col.name);
-                        for (const auto& row : groupRows) {
-                            values.push_back(row[colIndex]);
+                        values.reserve(groupRows.size());
+                        for (size_t rowIndex : groupRows) {
+                            values.push_back(data[rowIndex][colIndex]);
                         }
                     } catch (const std::exception& e) {
                         throw std::runtime_error("聚合列不存在: " + col.name);
@@ -720,6 +1260,10 @@ std::vector<std::vector<std::string>> Table::selectWithAggregates(
                 result.push_back(resultRow);
             }
         }
+        if (profile) {
+            profile->addStage("聚合", describeAggregates(columns, groupByColumns, havingClause),
+                              groups.size(), result.size(), groupAggregateStart, &result);
+        }
         
         return result;
     } catch (const std::exception& e) {
@@ -856,4 +1400,97 @@ bool Table::evaluateHavingClause(
     } catch (const std::exception& e) {
         throw std::runtime_error("HAVING条件评估失败: " + std::string(e.what()));
     }
-} 
\ No newline at end of file
+} 
+
+std::string Table::describeScan(const std::string& whereClause) const {
+    // 查询总是顺序扫描，只按区域映射跳过整块；索引只在插入和更新时维护
+    std::string detail = "表 " + name + "，顺序扫描";
+    if (!whereClause.empty()) {
+        detail += "，过滤: " + whereClause;
+    }
+    return detail;
+}
+
+std::string Table::describeSkipped(size_t examined) const {
+    if (examined >= data.size()) {
+        return "";
+    }
+    return std::string(bloomFilters.empty() ? "，区域映射" : "，区域映射和布隆过滤器")
+           + "跳过 " + std::to_string(data.size() - examined) + " 行";
+}
+
+std::string Table::describeSort(const std::string& orderByColumn, bool desc) {
+    return "ORDER BY " + orderByColumn + (desc ? " DESC" : " ASC");
+}
+
+std::string Table::describeAggregates(
+    const std::vector<SQLParser::Column>& columns,
+    const std::vector<std::string>& groupByColumns,
+    const std::string& havingClause) {
+    
+    std::string detail;
+    for (const auto& col : columns) {
+        std::string func;
+        switch (col.aggregateFunc) {
+            case SQLParser::AggregateFunction::COUNT: func = "COUNT"; break;
+            case SQLParser::AggregateFunction::AVG: func = "AVG"; break;
+            case SQLParser::AggregateFunction::SUM: func = "SUM"; break;
+            case SQLParser::AggregateFunction::MIN: func = "MIN"; break;
+            case SQLParser::AggregateFunction::MAX: func = "MAX"; break;
+            default: continue;
+        }
+        if (!detail.empty()) detail += ", ";
+        detail += func + "(" + col.name + ")";
+    }
+    if (groupByColumns.empty()) {
+        detail += detail.empty() ? "整体聚合" : "，整体聚合";
+    }
+    if (!havingClause.empty()) {
+        detail += "，HAVING " + havingClause;
+    }
+    return detail;
+}
+
+void Table::analyze() {
+    TRACE_SCOPE("Table::analyze", "stats", name);
+    stats = TableStats::compute(columns, data.rows());
+}
+
+double Table::estimateRows(const std::string& whereClause) const {
+    double rows = static_cast<double>(data.size());
+    if (whereClause.empty() || !stats.isAnalyzed()) {
+        return rows;
+    }
+    
+    // 与 evaluateCondition 相同的条件拆分方式，无法识别的条件不参与估算
+    size_t pos = 0;
+    while (pos < whereClause.length()) {
+        size_t andPos = whereClause.find("AND", pos);
+        std::string cond = trim(andPos == std::string::npos
+                                ? whereClause.substr(pos)
+                                : whereClause.substr(pos, andPos - pos));
+        pos = andPos == std::string::npos ? whereClause.length() : andPos + 3;
+        
+        std::vector<std::string> operators = {">=", "<=", "!=", "=", ">", "<"};
+        for (const auto& op : operators) {
+            size_t opPos = cond.find(op);
+            if (opPos == std::string::npos) {
+                continue;
+            }
+            
+            std::string colName = trim(cond.substr(0, opPos));
+            std::string value = trim(cond.substr(opPos + op.length()));
+            if (value.size() >= 2 && value.front() == '\'' && value.back() == '\'') {
+                value = value.substr(1, value.length() - 2);
+            }
+            for (size_t i = 0; i < columns.size(); i++) {
+                if (columns[i].name == colName) {
+                    rows *= stats.estimateSelectivity(i, op, value);
+                    break;
+                }
+            }
+            break;
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,634 @@
+#include "TableFile.h"
+#include "Checksum.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace TableFile {
+
+namespace {
+
+const char MAGIC[] = "DBMSTBL1";
+constexpr size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+constexpr uint64_t VERSION = 2;
+// 版本 1 没有校验和，仍然可以读取
+constexpr uint64_t VERSION_WITHOUT_CHECKSUM = 1;
+constexpr size_t CHECKSUM_SIZE = 4;
+constexpr size_t MAX_DICTIONARY = 4096;
+// 整数编码的取值范围，保证相邻差值和与最小值的差不溢出
+constexpr int64_t INTEGER_LIMIT = int64_t(1) << 61;
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+size_t varintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+uint64_t getVarint(const std::string& in, size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) {
+            throw std::runtime_error("表文件数据不完整");
+        }
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("表文件格式错误");
+}
+
+uint64_t readVarint(std::istream& in) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof()) {
+            throw std::runtime_error("表文件数据不完整");
+        }
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("表文件格式错误");
+}
+
+// 校验和固定 4 字节，小端序
+void putChecksum(std::ostream& out, uint32_t crc) {
+    char bytes[CHECKSUM_SIZE];
+    for (size_t i = 0; i < CHECKSUM_SIZE; i++) {
+        bytes[i] = static_cast<char>(crc >> (8 * i));
+    }
+    out.write(bytes, CHECKSUM_SIZE);
+}
+
+uint32_t readChecksum(std::istream& in) {
+    unsigned char bytes[CHECKSUM_SIZE];
+    if (!in.read(reinterpret_cast<char*>(bytes), CHECKSUM_SIZE)) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    uint32_t crc = 0;
+    for (size_t i = 0; i < CHECKSUM_SIZE; i++) {
+        crc |= uint32_t(bytes[i]) << (8 * i);
+    }
+    return crc;
+}
+
+void putString(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out += value;
+}
+
+std::string getString(const std::string& in, size_t& pos) {
+    uint64_t length = getVarint(in, pos);
+    if (length > in.size() - pos) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    std::string value = in.substr(pos, length);
+    pos += length;
+    return value;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+int bitWidth(uint64_t value) {
+    int width = 0;
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+size_t packedSize(size_t count, int width) {
+    return (count * width + 7) / 8;
+}
+
+// 每个值占 width 位，低位在前；按字节输出累积的位
+void packBits(std::string& out, const std::vector<uint64_t>& values, int width) {
+    out.reserve(out.size() + packedSize(values.size(), width));
+    unsigned __int128 buffer = 0;
+    int buffered = 0;
+    for (uint64_t value : values) {
+        buffer |= static_cast<unsigned __int128>(value) << buffered;
+        buffered += width;
+        while (buffered >= 8) {
+            out += static_cast<char>(static_cast<uint8_t>(buffer));
+            buffer >>= 8;
+            buffered -= 8;
+        }
+    }
+    if (buffered > 0) {
+        out += static_cast<char>(static_cast<uint8_t>(buffer));
+    }
+}
+
+std::vector<uint64_t> unpackBits(const std::string& in, size_t& pos, size_t count, int width) {
+    size_t size = packedSize(count, width);
+    if (width > 64 || size > in.size() - pos) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    std::vector<uint64_t> values;
+    values.reserve(count);
+    const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    unsigned __int128 buffer = 0;
+    int buffered = 0;
+    size_t next = pos;
+    for (size_t k = 0; k < count; k++) {
+        while (buffered < width) {
+            buffer |= static_cast<unsigned __int128>(static_cast<uint8_t>(in[next++])) << buffered;
+            buffered += 8;
+        }
+        values.push_back(static_cast<uint64_t>(buffer) & mask);
+        buffer >>= width;
+        buffered -= width;
+    }
+    pos += size;
+    return values;
+}
+
+// 规范写法的整数：没有正号和多余的前导零，不是 "-0"，转换回文本与原文相同
+bool parseInteger(const std::string& text, int64_t& value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size()) {
+        return false;
+    }
+    size_t digits = text[0] == '-' ? 1 : 0;
+    if (text[digits] == '0' && (text.size() > digits + 1 || digits == 1)) {
+        return false;
+    }
+    return value > -INTEGER_LIMIT && value < INTEGER_LIMIT;
+}
+
+// 一块中一列的统计，用来估算各编码的大小
+struct ColumnProfile {
+    size_t plainBytes = 0;
+    size_t rleBytes = 0;
+    size_t dictionaryBytes = 0;      // 字典中值的字节数
+    std::unordered_map<std::string_view, uint64_t> dictionary;   // 值 -> 编码（按第一次出现的顺序）
+    std::vector<uint64_t> codes;
+    bool dictionaryUsable = true;
+
+    bool integers = false;           // 非空值都是规范写法的整数
+    std::vector<int64_t> numbers;    // 非空值
+    size_t nulls = 0;
+    int64_t minValue = 0;
+    int64_t maxValue = 0;
+    int64_t minDelta = 0;
+    int64_t maxDelta = 0;
+};
+
+ColumnProfile profile(const std::vector<const std::string*>& values, const std::string& type) {
+    ColumnProfile p;
+    p.integers = type == "INTEGER";
+    size_t runLength = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        const std::string& value = *values[i];
+        p.plainBytes += varintSize(value.size()) + value.size();
+
+        // 行程在值改变或到达末尾时结束
+        runLength++;
+        if (i + 1 == values.size() || *values[i + 1] != value) {
+            p.rleBytes += varintSize(runLength) + varintSize(value.size()) + value.size();
+            runLength = 0;
+        }
+
+        if (p.dictionaryUsable) {
+            auto [it, inserted] = p.dictionary.emplace(value, p.dictionary.size());
+            if (inserted) {
+                p.dictionaryBytes += varintSize(value.size()) + value.size();
+                p.dictionaryUsable = p.dictionary.size() <= MAX_DICTIONARY;
+            }
+            p.codes.push_back(it->second);
+        }
+
+        if (p.integers) {
+            int64_t number;
+            if (value.empty()) {
+                p.nulls++;
+            } else if (parseInteger(value, number)) {
+                p.numbers.push_back(number);
+            } else {
+                p.integers = false;
+            }
+        }
+    }
+
+    if (p.integers && !p.numbers.empty()) {
+        auto [minIt, maxIt] = std::minmax_element(p.numbers.begin(), p.numbers.end());
+        p.minValue = *minIt;
+        p.maxValue = *maxIt;
+        for (size_t i = 1; i < p.numbers.size(); i++) {
+            int64_t delta = p.numbers[i] - p.numbers[i - 1];
+            if (i == 1 || delta < p.minDelta) p.minDelta = delta;
+            if (i == 1 || delta > p.maxDelta) p.maxDelta = delta;
+        }
+    }
+    return p;
+}
+
+size_t nullBitmapSize(const ColumnProfile& p, size_t count) {
+    return 1 + (p.nulls > 0 ? packedSize(count, 1) : 0);
+}
+
+// 整数编码前的空值位图：标志字节，有空值时每行一位
+void putNulls(std::string& out, const std::vector<const std::string*>& values, size_t nulls) {
+    out += static_cast<char>(nulls > 0 ? 1 : 0);
+    if (nulls > 0) {
+        std::vector<uint64_t> bits;
+        bits.reserve(values.size());
+        for (const auto* value : values) {
+            bits.push_back(value->empty() ? 1 : 0);
+        }
+        packBits(out, bits, 1);
+    }
+}
+
+std::vector<uint64_t> getNulls(const std::string& in, size_t& pos, size_t count) {
+    if (pos >= in.size()) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    if (in[pos++] == 0) {
+        return std::vector<uint64_t>(count, 0);
+    }
+    return unpackBits(in, pos, count, 1);
+}
+
+} // namespace
+
+const char* codecName(Codec codec) {
+    switch (codec) {
+        case Codec::PLAIN: return "PLAIN";
+        case Codec::RLE: return "RLE";
+        case Codec::DICTIONARY: return "DICTIONARY";
+        case Codec::DELTA: return "DELTA";
+        case Codec::FRAME_OF_REFERENCE: return "FRAME_OF_REFERENCE";
+    }
+    return "UNKNOWN";
+}
+
+std::string encodeColumn(const std::vector<const std::string*>& values, const std::string& type, Codec& codec) {
+    ColumnProfile p = profile(values, type);
+
+    // 估算各编码的大小，选择最小的
+    codec = Codec::PLAIN;
+    size_t best = p.plainBytes;
+    auto consider = [&](Codec candidate, size_t size) {
+        if (size < best) {
+            codec = candidate;
+            best = size;
+        }
+    };
+    consider(Codec::RLE, p.rleBytes);
+    if (p.dictionaryUsable) {
+        size_t width = bitWidth(p.dictionary.size() > 0 ? p.dictionary.size() - 1 : 0);
+        consider(Codec::DICTIONARY, varintSize(p.dictionary.size()) + p.dictionaryBytes + 1 +
+                                    packedSize(values.size(), width));
+    }
+    if (p.integers && !p.numbers.empty()) {
+        size_t nullBytes = nullBitmapSize(p, values.size());
+        int forWidth = bitWidth(uint64_t(p.maxValue - p.minValue));
+        consider(Codec::FRAME_OF_REFERENCE, nullBytes + varintSize(zigzag(p.minValue)) + 1 +
+                                            packedSize(p.numbers.size(), forWidth));
+        int deltaWidth = bitWidth(uint64_t(p.maxDelta - p.minDelta));
+        consider(Codec::DELTA, nullBytes + varintSize(zigzag(p.numbers[0])) +
+                               varintSize(zigzag(p.minDelta)) + 1 +
+                               packedSize(p.numbers.size() - 1, deltaWidth));
+    }
+
+    std::string out;
+    out.reserve(best);
+    switch (codec) {
+        case Codec::PLAIN:
+            for (const auto* value : values) {
+                putString(out, *value);
+            }
+            break;
+
+        case Codec::RLE: {
+            size_t i = 0;
+            while (i < values.size()) {
+                size_t end = i + 1;
+                while (end < values.size() && *values[end] == *values[i]) end++;
+                putVarint(out, end - i);
+                putString(out, *values[i]);
+                i = end;
+            }
+            break;
+        }
+
+        case Codec::DICTIONARY: {
+            // 编码按值第一次出现的顺序分配，统计时已经得到
+            std::vector<std::string_view> dictionary(p.dictionary.size());
+            for (const auto& [value, code] : p.dictionary) {
+                dictionary[code] = value;
+            }
+            putVarint(out, dictionary.size());
+            for (std::string_view value : dictionary) {
+                putVarint(out, value.size());
+                out += value;
+            }
+            int width = bitWidth(dictionary.size() - 1);
+            out += static_cast<char>(width);
+            packBits(out, p.codes, width);
+            break;
+        }
+
+        case Codec::FRAME_OF_REFERENCE: {
+            putNulls(out, values, p.nulls);
+            putVarint(out, zigzag(p.minValue));
+            std::vector<uint64_t> offsets;
+            offsets.reserve(p.numbers.size());
+            for (int64_t number : p.numbers) {
+                offsets.push_back(uint64_t(number - p.minValue));
+            }
+            int width = bitWidth(uint64_t(p.maxValue - p.minValue));
+            out += static_cast<char>(width);
+            packBits(out, offsets, width);
+            break;
+        }
+
+        case Codec::DELTA: {
+            putNulls(out, values, p.nulls);
+            putVarint(out, zigzag(p.numbers[0]));
+            putVarint(out, zigzag(p.minDelta));
+            std::vector<uint64_t> deltas;
+            deltas.reserve(p.numbers.size());
+            for (size_t i = 1; i < p.numbers.size(); i++) {
+                deltas.push_back(uint64_t(p.numbers[i] - p.numbers[i - 1] - p.minDelta));
+            }
+            int width = bitWidth(uint64_t(p.maxDelta - p.minDelta));
+            out += static_cast<char>(width);
+            packBits(out, deltas, width);
+            break;
+        }
+    }
+    return out;
+}
+
+void decodeColumn(Codec codec, const std::string& payload, size_t count, std::vector<std::string>& values) {
+    size_t pos = 0;
+    auto readWidth = [&]() {
+        if (pos >= payload.size()) {
+            throw std::runtime_error("表文件数据不完整");
+        }
+        return static_cast<int>(static_cast<uint8_t>(payload[pos++]));
+    };
+
+    switch (codec) {
+        case Codec::PLAIN:
+            for (size_t i = 0; i < count; i++) {
+                values.push_back(getString(payload, pos));
+            }
+            break;
+
+        case Codec::RLE: {
+            size_t decoded = 0;
+            while (decoded < count) {
+                uint64_t runLength = getVarint(payload, pos);
+                if (runLength == 0 || runLength > count - decoded) {
+                    throw std::runtime_error("表文件格式错误");
+                }
+                std::string value = getString(payload, pos);
+                values.insert(values.end(), runLength, value);
+                decoded += runLength;
+            }
+            break;
+        }
+
+        case Codec::DICTIONARY: {
+            uint64_t size = getVarint(payload, pos);
+            if (size > count) {
+                throw std::runtime_error("表文件格式错误");
+            }
+            std::vector<std::string> dictionary;
+            dictionary.reserve(size);
+            for (uint64_t i = 0; i < size; i++) {
+                dictionary.push_back(getString(payload, pos));
+            }
+            int width = readWidth();
+            for (uint64_t code : unpackBits(payload, pos, count, width)) {
+                if (code >= dictionary.size()) {
+                    throw std::runtime_error("表文件格式错误");
+                }
+                values.push_back(dictionary[code]);
+            }
+            break;
+        }
+
+        case Codec::FRAME_OF_REFERENCE:
+        case Codec::DELTA: {
+            std::vector<uint64_t> nulls = getNulls(payload, pos, count);
+            size_t nonNull = count - std::count(nulls.begin(), nulls.end(), 1);
+            std::vector<int64_t> numbers;
+            numbers.reserve(nonNull);
+            if (codec == Codec::FRAME_OF_REFERENCE) {
+                int64_t minValue = unzigzag(getVarint(payload, pos));
+                int width = readWidth();
+                for (uint64_t offset : unpackBits(payload, pos, nonNull, width)) {
+                    numbers.push_back(minValue + int64_t(offset));
+                }
+            } else if (nonNull > 0) {
+                numbers.push_back(unzigzag(getVarint(payload, pos)));
+                int64_t minDelta = unzigzag(getVarint(payload, pos));
+                int width = readWidth();
+                for (uint64_t delta : unpackBits(payload, pos, nonNull - 1, width)) {
+                    numbers.push_back(numbers.back() + minDelta + int64_t(delta));
+                }
+            }
+            size_t next = 0;
+            for (size_t i = 0; i < count; i++) {
+                values.push_back(nulls[i] ? std::string() : std::to_string(numbers[next++]));
+            }
+            break;
+        }
+
+        default:
+            throw std::runtime_error("未知的列编码: " + std::to_string(static_cast<int>(codec)));
+    }
+}
+
+void write(std::ostream& out, const std::vector<ColumnDef>& columns,
+           const TableRows& data) {
+    std::string header;
+    putVarint(header, columns.size());
+    for (const auto& col : columns) {
+        putString(header, col.name);
+        putString(header, col.type);
+        header += static_cast<char>((col.nullable ? 1 : 0) | (col.primaryKey ? 2 : 0) | (col.bloomFilter ? 4 : 0));
+    }
+    putVarint(header, data.size());
+    putVarint(header, (data.size() + BLOCK_ROWS - 1) / BLOCK_ROWS);
+    std::string prefix(MAGIC, MAGIC_SIZE);
+    putVarint(prefix, VERSION);
+    putVarint(prefix, header.size());
+    out.write(prefix.data(), prefix.size());
+    out.write(header.data(), header.size());
+    putChecksum(out, Checksum::crc32c(header.data(), header.size()));
+
+    std::vector<const std::string*> values;
+    std::string block;
+    std::string length;
+    for (size_t begin = 0; begin < data.size(); begin += BLOCK_ROWS) {
+        size_t end = std::min(data.size(), begin + BLOCK_ROWS);
+        block.clear();
+        putVarint(block, end - begin);
+        for (size_t c = 0; c < columns.size(); c++) {
+            values.clear();
+            for (size_t i = begin; i < end; i++) {
+                values.push_back(&data[i][c]);
+            }
+            Codec codec;
+            std::string payload = encodeColumn(values, columns[c].type, codec);
+            block += static_cast<char>(codec);
+            putString(block, payload);
+        }
+        length.clear();
+        putVarint(length, block.size());
+        out.write(length.data(), length.size());
+        out.write(block.data(), block.size());
+        putChecksum(out, Checksum::crc32c(block.data(), block.size()));
+    }
+}
+
+Reader::Reader(std::istream& input) : in(input) {
+    char magic[MAGIC_SIZE];
+    if (!in.read(magic, MAGIC_SIZE) || std::memcmp(magic, MAGIC, MAGIC_SIZE) != 0) {
+        throw std::runtime_error("不是表文件");
+    }
+    uint64_t version = readVarint(in);
+    if (version == VERSION_WITHOUT_CHECKSUM) {
+        checksummed = false;
+        readHeader(in);
+        return;
+    }
+    if (version != VERSION) {
+        throw std::runtime_error("不支持的表文件版本: " + std::to_string(version));
+    }
+
+    std::string header(readVarint(in), '\0');
+    if (!in.read(header.data(), header.size())) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    if (readChecksum(in) != Checksum::crc32c(header.data(), header.size())) {
+        throw std::runtime_error("表文件校验和不匹配: 文件头");
+    }
+    std::istringstream headerIn(header);
+    readHeader(headerIn);
+}
+
+void Reader::readHeader(std::istream& headerIn) {
+    auto readText = [&headerIn]() {
+        uint64_t length = readVarint(headerIn);
+        std::string text(length, '\0');
+        if (!headerIn.read(text.data(), length)) {
+            throw std::runtime_error("表文件数据不完整");
+        }
+        return text;
+    };
+    uint64_t columnCount = readVarint(headerIn);
+    for (uint64_t i = 0; i < columnCount; i++) {
+        ColumnDef col;
+        col.name = readText();
+        col.type = readText();
+        int flags = headerIn.get();
+        if (flags == std::char_traits<char>::eof()) {
+            throw std::runtime_error("表文件数据不完整");
+        }
+        col.nullable = flags & 1;
+        col.primaryKey = flags & 2;
+        col.bloomFilter = flags & 4;
+        columns.push_back(col);
+    }
+    rowCount = readVarint(headerIn);
+    blockCount = readVarint(headerIn);
+}
+
+bool Reader::nextBlock(std::vector<std::vector<std::string>>& rows) {
+    std::string block;
+    if (!readBlock(block)) {
+        return false;
+    }
+    decodeBlock(block, rows);
+    return true;
+}
+
+bool Reader::readBlock(std::string& block) {
+    if (blocksRead == blockCount) {
+        return false;
+    }
+    block.assign(readVarint(in), '\0');
+    if (!in.read(block.data(), block.size())) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    if (checksummed && readChecksum(in) != Checksum::crc32c(block.data(), block.size())) {
+        throw std::runtime_error("表文件校验和不匹配: 第 " + std::to_string(blocksRead + 1) + " 块");
+    }
+    blocksRead++;
+    return true;
+}
+
+bool Reader::skipBlock() {
+    if (blocksRead == blockCount) {
+        return false;
+    }
+    uint64_t size = readVarint(in) + (checksummed ? CHECKSUM_SIZE : 0);
+    if (!in.seekg(static_cast<std::streamoff>(size), std::ios::cur)) {
+        throw std::runtime_error("表文件数据不完整");
+    }
+    blocksRead++;
+    return true;
+}
+
+void Reader::decodeBlock(const std::string& block, std::vector<std::vector<std::string>>& rows) const {
+    size_t pos = 0;
+    uint64_t count = getVarint(block, pos);
+    if (count > BLOCK_ROWS) {
+        throw std::runtime_error("表文件格式错误");
+    }
+    rows.assign(count, std::vector<std::string>());
+    for (auto& row : rows) {
+        row.reserve(columns.size());
+    }
+
+    // 逐列解码后分发到各行
+    std::vector<std::string> values;
+    for (size_t c = 0; c < columns.size(); c++) {
+        if (pos >= block.size()) {
+            throw std::runtime_error("表文件数据不完整");
+        }
+        Codec codec = static_cast<Codec>(block[pos++]);
+        std::string payload = getString(block, pos);
+        values.clear();
+        decodeColumn(codec, payload, count, values);
+        for (size_t i = 0; i < count; i++) {
+            rows[i].push_back(std::move(values[i]));
+        }
+    }
+}
+
+} // namespace TableFile
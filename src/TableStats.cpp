@@ -0,0 +1,410 @@
+#include "TableStats.h"
+#include "Table.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+
+namespace {
+
+uint64_t hashValue(const std::string& value) {
+    // FNV-1a，再用 splitmix64 的混合步骤打散低位的相关性。
+    // 寄存器会持久化，不能使用实现相关的 std::hash
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+bool isNumericType(const std::string& type) {
+    return type == "INTEGER" || type == "FLOAT";
+}
+
+// 统计文件按制表符分隔字段，值中的反斜杠、制表符和换行需要转义
+std::string escape(const std::string& value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::string unescape(const std::string& value) {
+    std::string out;
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            char next = value[++i];
+            out += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+        } else {
+            out += value[i];
+        }
+    }
+    return out;
+}
+
+// 与 std::getline 不同，保留末尾的空字段（例如没有非空值时的 "min\t"）
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        if (tab == std::string::npos) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+}
+
+} // namespace
+
+void HyperLogLog::add(const std::string& value) {
+    uint64_t h = hashValue(value);
+    size_t index = static_cast<size_t>(h >> (64 - PRECISION));
+
+    // 剩余位中第一个 1 的位置
+    uint64_t rest = h << PRECISION;
+    uint8_t rank = 1;
+    while (rank <= 64 - PRECISION && (rest & (uint64_t(1) << 63)) == 0) {
+        rank++;
+        rest <<= 1;
+    }
+    registers[index] = std::max(registers[index], rank);
+}
+
+double HyperLogLog::estimate() const {
+    double m = static_cast<double>(REGISTERS);
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t reg : registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(reg));
+        if (reg == 0) {
+            zeros++;
+        }
+    }
+
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        // 基数较小时使用线性计数
+        estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return estimate;
+}
+
+std::string HyperLogLog::toHex() const {
+    static const char* digits = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(REGISTERS * 2);
+    for (uint8_t reg : registers) {
+        hex += digits[reg >> 4];
+        hex += digits[reg & 0xF];
+    }
+    return hex;
+}
+
+bool HyperLogLog::fromHex(const std::string& hex) {
+    if (hex.size() != REGISTERS * 2) {
+        return false;
+    }
+
+    auto digit = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    std::vector<uint8_t> parsed(REGISTERS);
+    for (size_t i = 0; i < REGISTERS; i++) {
+        int high = digit(hex[i * 2]);
+        int low = digit(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        parsed[i] = static_cast<uint8_t>(high * 16 + low);
+    }
+    registers = std::move(parsed);
+    return true;
+}
+
+TableStats TableStats::compute(const std::vector<ColumnDef>& columns,
+                               const TableRows& data) {
+    TableStats stats;
+    stats.analyzed = true;
+    stats.rowCount = data.size();
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        ColumnStats col;
+        col.name = columns[c].name;
+        col.type = columns[c].type;
+
+        std::vector<const std::string*> values;
+        values.reserve(data.size());
+        for (const auto& row : data) {
+            const std::string& value = row[c];
+            if (value.empty()) {
+                col.nullCount++;
+            } else {
+                col.distinct.add(value);
+                values.push_back(&value);
+            }
+        }
+
+        if (!values.empty()) {
+            const std::string& type = col.type;
+            std::sort(values.begin(), values.end(), [&type](const std::string* a, const std::string* b) {
+                return Table::compareValues(*a, *b, type);
+            });
+            col.minValue = *values.front();
+            col.maxValue = *values.back();
+
+            // 每个桶的行数尽量相同；上界相同的桶（大量重复值）合并
+            size_t n = values.size();
+            size_t buckets = std::min(HISTOGRAM_BUCKETS, n);
+            size_t begin = 0;
+            for (size_t b = 0; b < buckets; b++) {
+                size_t end = (b + 1) * n / buckets;
+                const std::string& upper = *values[end - 1];
+                if (!col.bucketBounds.empty() &&
+                    !Table::compareValues(col.bucketBounds.back(), upper, type)) {
+                    col.bucketCounts.back() += end - begin;
+                } else {
+                    col.bucketBounds.push_back(upper);
+                    col.bucketCounts.push_back(end - begin);
+                }
+                begin = end;
+            }
+        }
+        stats.columns.push_back(std::move(col));
+    }
+    return stats;
+}
+
+void TableStats::addRow(const TableRow& row) {
+    if (!analyzed || row.size() != columns.size()) {
+        return;
+    }
+
+    rowCount++;
+    for (size_t c = 0; c < columns.size(); c++) {
+        ColumnStats& col = columns[c];
+        const std::string& value = row[c];
+        if (value.empty()) {
+            col.nullCount++;
+            continue;
+        }
+        col.distinct.add(value);
+
+        if (col.bucketBounds.empty()) {
+            col.minValue = value;
+            col.maxValue = value;
+            col.bucketBounds.push_back(value);
+            col.bucketCounts.push_back(1);
+            continue;
+        }
+        if (Table::compareValues(value, col.minValue, col.type)) {
+            col.minValue = value;
+        }
+        if (Table::compareValues(col.maxValue, value, col.type)) {
+            col.maxValue = value;
+        }
+
+        // 计入第一个上界不小于该值的桶，超过所有上界时扩展最后一个桶
+        auto it = std::lower_bound(col.bucketBounds.begin(), col.bucketBounds.end(), value,
+            [&col](const std::string& bound, const std::string& v) {
+                return Table::compareValues(bound, v, col.type);
+            });
+        if (it == col.bucketBounds.end()) {
+            col.bucketBounds.back() = value;
+            col.bucketCounts.back()++;
+        } else {
+            col.bucketCounts[it - col.bucketBounds.begin()]++;
+        }
+    }
+}
+
+void TableStats::removeRows(uint64_t count) {
+    if (!analyzed) {
+        return;
+    }
+    rowCount -= std::min(count, rowCount);
+    modifiedRows += count;
+}
+
+void TableStats::recordModification(uint64_t count) {
+    if (analyzed) {
+        modifiedRows += count;
+    }
+}
+
+uint64_t TableStats::estimateDistinct(size_t column) const {
+    if (!analyzed || column >= columns.size()) {
+        return 0;
+    }
+    const ColumnStats& col = columns[column];
+    uint64_t nonNull = rowCount > col.nullCount ? rowCount - col.nullCount : 0;
+    if (nonNull == 0) {
+        return 0;
+    }
+    uint64_t estimate = static_cast<uint64_t>(std::llround(col.distinct.estimate()));
+    return std::max<uint64_t>(1, std::min(estimate, nonNull));
+}
+
+double TableStats::nonNullFraction(const ColumnStats& col) const {
+    if (rowCount == 0) {
+        return 0;
+    }
+    uint64_t nonNull = rowCount > col.nullCount ? rowCount - col.nullCount : 0;
+    return static_cast<double>(nonNull) / rowCount;
+}
+
+double TableStats::equalFraction(size_t column, const std::string& value) const {
+    const ColumnStats& col = columns[column];
+    uint64_t distinct = estimateDistinct(column);
+    if (distinct == 0 ||
+        Table::compareValues(value, col.minValue, col.type) ||
+        Table::compareValues(col.maxValue, value, col.type)) {
+        return 0;
+    }
+    // 假设各个不同值出现的次数相同
+    return nonNullFraction(col) / distinct;
+}
+
+double TableStats::fractionBelow(const ColumnStats& col, const std::string& value) {
+    uint64_t total = 0;
+    for (uint64_t count : col.bucketCounts) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    double below = 0;
+    for (size_t i = 0; i < col.bucketBounds.size(); i++) {
+        const std::string& upper = col.bucketBounds[i];
+        if (Table::compareValues(upper, value, col.type)) {
+            below += col.bucketCounts[i];
+            continue;
+        }
+
+        // 值落在这个桶内：数值列在桶的上下界之间线性插值，其他类型取一半
+        const std::string& lower = i == 0 ? col.minValue : col.bucketBounds[i - 1];
+        double partial = 0.5;
+        if (!Table::compareValues(lower, value, col.type)) {
+            partial = 0;
+        } else if (isNumericType(col.type)) {
+            try {
+                double lo = std::stod(lower);
+                double hi = std::stod(upper);
+                double v = std::stod(value);
+                if (hi > lo) {
+                    partial = std::min(1.0, std::max(0.0, (v - lo) / (hi - lo)));
+                }
+            } catch (const std::exception&) {
+                // 无法转换时保留默认值
+            }
+        }
+        below += partial * col.bucketCounts[i];
+        break;
+    }
+    return below / total;
+}
+
+double TableStats::estimateSelectivity(size_t column, const std::string& op,
+                                       const std::string& value) const {
+    if (!analyzed || column >= columns.size() || rowCount == 0) {
+        return 1.0;
+    }
+
+    const ColumnStats& col = columns[column];
+    double nonNull = nonNullFraction(col);
+    double equal = equalFraction(column, value);
+    double below = fractionBelow(col, value) * nonNull;
+
+    double selectivity = 1.0;
+    if (op == "=") selectivity = equal;
+    else if (op == "!=") selectivity = nonNull - equal;
+    else if (op == "<") selectivity = below;
+    else if (op == "<=") selectivity = below + equal;
+    else if (op == ">") selectivity = nonNull - below - equal;
+    else if (op == ">=") selectivity = nonNull - below;
+    return std::min(1.0, std::max(0.0, selectivity));
+}
+
+void TableStats::save(std::ostream& out) const {
+    out << "rows\t" << rowCount << "\t" << modifiedRows << "\n";
+    for (const auto& col : columns) {
+        out << "column\t" << escape(col.name) << "\t" << col.nullCount << "\t"
+            << col.distinct.toHex() << "\n";
+        out << "min\t" << escape(col.minValue) << "\n";
+        out << "max\t" << escape(col.maxValue) << "\n";
+        for (size_t i = 0; i < col.bucketBounds.size(); i++) {
+            out << "bucket\t" << col.bucketCounts[i] << "\t" << escape(col.bucketBounds[i]) << "\n";
+        }
+    }
+}
+
+bool TableStats::load(std::istream& in, const std::vector<ColumnDef>& tableColumns) {
+    TableStats loaded;
+    loaded.analyzed = true;
+
+    std::string line;
+    try {
+        while (std::getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            auto fields = splitFields(line);
+            const std::string& kind = fields[0];
+
+            if (kind == "rows" && fields.size() == 3) {
+                loaded.rowCount = std::stoull(fields[1]);
+                loaded.modifiedRows = std::stoull(fields[2]);
+            } else if (kind == "column" && fields.size() == 4) {
+                ColumnStats col;
+                col.name = unescape(fields[1]);
+                col.nullCount = std::stoull(fields[2]);
+                if (!col.distinct.fromHex(fields[3])) {
+                    return false;
+                }
+                loaded.columns.push_back(std::move(col));
+            } else if (loaded.columns.empty()) {
+                return false;
+            } else if (kind == "min" && fields.size() == 2) {
+                loaded.columns.back().minValue = unescape(fields[1]);
+            } else if (kind == "max" && fields.size() == 2) {
+                loaded.columns.back().maxValue = unescape(fields[1]);
+            } else if (kind == "bucket" && fields.size() == 3) {
+                loaded.columns.back().bucketCounts.push_back(std::stoull(fields[1]));
+                loaded.columns.back().bucketBounds.push_back(unescape(fields[2]));
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    if (loaded.columns.size() != tableColumns.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < tableColumns.size(); i++) {
+        if (loaded.columns[i].name != tableColumns[i].name) {
+            return false;
+        }
+        loaded.columns[i].type = tableColumns[i].type;
+    }
+
+    *this = std::move(loaded);
+    return true;
+}
@@ -120,8 +120,8 @@ void TableViewDialog::refreshTableData() {
     tableWidget->blockSignals(true);
     
     try {
-        const Table& table = dbManager.getTable(tableName.toStdString());
-        const auto& data = table.getData();
+        auto table = dbManager.getTable(tableName.toStdString());
+        const auto& data = table->getData();
         
         tableWidget->setRowCount(data.size());
         
@@ -175,9 +175,6 @@ void TableViewDialog::saveChanges() {
             newData.push_back(rowData);
         }
         
-        // 获取表引用
-        Table& table = const_cast<Table&>(dbManager.getTable(tableName.toStdString()));
-        
         // 创建新表（使用相同的结构）
         Table newTable(tableName.toStdString(), columns);
         
@@ -202,15 +199,8 @@ void TableViewDialog::saveChanges() {
             throw std::runtime_error(errorMessage.toStdString());
         }
         
-        // 如果所有数据都插入成功，替换原表
-        table = std::move(newTable);
-        
-        // 保存到文件
-        SQLParser::ParsedQuery query;
-        query.type = "UPDATE";
-        query.tableName = tableName.toStdString();
-        
-        if (!dbManager.executeNonQuery(query)) {
+        // 如果所有数据都插入成功，提交为新版本替换原表并保存到文件
+        if (!dbManager.replaceTable(tableName.toStdString(), std::move(newTable))) {
             throw std::runtime_error("保存到文件失败");
         }
         
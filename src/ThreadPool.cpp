@@ -0,0 +1,70 @@
+#include "ThreadPool.h"
+#include <stdexcept>
+
+ThreadPool::ThreadPool(size_t threadCount, size_t capacity)
+    : queueCapacity(capacity) {
+    if (threadCount == 0) {
+        throw std::runtime_error("线程池至少需要一个线程");
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+bool ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return false;
+        }
+        if (queueCapacity > 0 && tasks.size() >= queueCapacity) {
+            return false;
+        }
+        tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+    return true;
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping && workers.empty()) {
+            return;
+        }
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;  // 已关闭且没有剩余任务
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        
+        try {
+            task();
+        } catch (...) {
+            // 任务自行处理错误，这里只保证工作线程不会退出
+        }
+    }
+}
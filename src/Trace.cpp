@@ -0,0 +1,164 @@
+#include "Trace.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace {
+
+std::atomic<bool> enabledFlag{false};
+
+namespace {
+
+constexpr size_t BUFFER_CAPACITY = 1 << 15;   // 每个线程保留最近的事件数
+constexpr size_t DETAIL_SIZE = 64;
+
+struct Event {
+    const char* name;
+    const char* category;
+    uint64_t startNs;
+    uint64_t endNs;
+    char detail[DETAIL_SIZE];
+};
+
+// 单生产者环形缓冲区：只有所属线程写入事件和推进 head
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::atomic<uint64_t> head{0};   // 已写入的事件总数
+    uint64_t clearedAt = 0;          // start() 时的 head，之前的事件不再导出（受 registryMutex 保护）
+    std::unique_ptr<Event[]> events{new Event[BUFFER_CAPACITY]};
+};
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;   // 线程退出后缓冲区仍保留到导出
+
+thread_local std::shared_ptr<ThreadBuffer> localBuffer;
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+ThreadBuffer& threadBuffer() {
+    if (!localBuffer) {
+        // 每个线程只在第一次记录时加锁注册一次
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->tid = static_cast<uint32_t>(registry.size() + 1);
+        registry.push_back(buffer);
+        localBuffer = buffer;
+    }
+    return *localBuffer;
+}
+
+void copyDetail(char* target, const std::string* detail) {
+    if (!detail) {
+        target[0] = '\0';
+        return;
+    }
+    size_t length = std::min(detail->size(), DETAIL_SIZE - 1);
+    // 不在 UTF-8 多字节字符中间截断
+    while (length < detail->size() && length > 0 &&
+           (static_cast<unsigned char>((*detail)[length]) & 0xC0) == 0x80) {
+        length--;
+    }
+    std::memcpy(target, detail->data(), length);
+    target[length] = '\0';
+}
+
+void writeJsonString(std::ostream& out, const char* str) {
+    out << '"';
+    for (const char* p = str; *p; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out << '\\' << *p;
+        } else if (c < 0x20) {
+            const char* hex = "0123456789abcdef";
+            out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+        } else {
+            out << *p;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+uint64_t nowNs() {
+    // 加 1 保证开启时的时间戳不为 0（Span 用 0 表示未开启）
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count()) + 1;
+}
+
+void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs,
+            const std::string* detail) {
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.head.load(std::memory_order_relaxed);
+    Event& event = buffer.events[index % BUFFER_CAPACITY];
+    event.name = name;
+    event.category = category;
+    event.startNs = startNs;
+    event.endNs = endNs;
+    copyDetail(event.detail, detail);
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+void start() {
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& buffer : registry) {
+            buffer->clearedAt = buffer->head.load(std::memory_order_acquire);
+        }
+    }
+    enabledFlag.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+    enabledFlag.store(false, std::memory_order_relaxed);
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& buffer : registry) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = std::max(buffer->clearedAt,
+                                  head > BUFFER_CAPACITY ? head - BUFFER_CAPACITY : 0);
+        if (begin == head) {
+            continue;
+        }
+
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"线程 " << buffer->tid << "\"}}";
+
+        for (uint64_t i = begin; i < head; i++) {
+            const Event& event = buffer->events[i % BUFFER_CAPACITY];
+            out << ",\n{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            // 完整事件（ph=X），时间单位为微秒
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << event.startNs / 1000.0
+                << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0;
+            if (event.detail[0] != '\0') {
+                out << ",\"args\":{\"detail\":";
+                writeJsonString(out, event.detail);
+                out << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace Trace
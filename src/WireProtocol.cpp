@@ -0,0 +1,150 @@
+#include "WireProtocol.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+namespace WireProtocol {
+
+namespace {
+
+// 读满 size 字节，在任何数据之前遇到 EOF 时返回 false
+bool readFully(int fd, char* buffer, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::read(fd, buffer + done, size - done);
+        if (n == 0) {
+            if (done == 0) return false;
+            throw std::runtime_error("连接意外关闭");
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("读取失败: " + std::string(std::strerror(errno)));
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void writeFully(int fd, const char* buffer, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::write(fd, buffer + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("写入失败: " + std::string(std::strerror(errno)));
+        }
+        done += static_cast<size_t>(n);
+    }
+}
+
+void appendUint32(std::string& out, uint32_t value) {
+    uint32_t net = htonl(value);
+    out.append(reinterpret_cast<const char*>(&net), sizeof(net));
+}
+
+void appendString(std::string& out, const std::string& value) {
+    appendUint32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+uint32_t readUint32(const std::string& in, size_t& pos) {
+    if (pos + sizeof(uint32_t) > in.size()) {
+        throw std::runtime_error("结果数据不完整");
+    }
+    uint32_t net;
+    std::memcpy(&net, in.data() + pos, sizeof(net));
+    pos += sizeof(net);
+    return ntohl(net);
+}
+
+std::string readString(const std::string& in, size_t& pos) {
+    uint32_t length = readUint32(in, pos);
+    if (pos + length > in.size()) {
+        throw std::runtime_error("结果数据不完整");
+    }
+    std::string value = in.substr(pos, length);
+    pos += length;
+    return value;
+}
+
+} // namespace
+
+bool readMessage(int fd, Message& message) {
+    char header[sizeof(uint32_t)];
+    if (!readFully(fd, header, sizeof(header))) {
+        return false;
+    }
+    
+    uint32_t net;
+    std::memcpy(&net, header, sizeof(net));
+    uint32_t length = ntohl(net);
+    if (length == 0 || length > MAX_FRAME_SIZE) {
+        throw std::runtime_error("无效的帧长度: " + std::to_string(length));
+    }
+    
+    std::string body(length, '\0');
+    if (!readFully(fd, &body[0], length)) {
+        throw std::runtime_error("连接意外关闭");
+    }
+    
+    message.type = static_cast<MessageType>(static_cast<uint8_t>(body[0]));
+    message.payload = body.substr(1);
+    return true;
+}
+
+void writeMessage(int fd, const Message& message) {
+    if (message.payload.size() + 1 > MAX_FRAME_SIZE) {
+        throw std::runtime_error("消息过大");
+    }
+    
+    std::string frame;
+    frame.reserve(sizeof(uint32_t) + 1 + message.payload.size());
+    appendUint32(frame, static_cast<uint32_t>(message.payload.size() + 1));
+    frame.push_back(static_cast<char>(message.type));
+    frame += message.payload;
+    writeFully(fd, frame.data(), frame.size());
+}
+
+std::string encodeResult(const std::vector<std::string>& headers,
+                         const std::vector<std::vector<std::string>>& rows) {
+    std::string out;
+    appendUint32(out, static_cast<uint32_t>(headers.size()));
+    for (const auto& header : headers) {
+        appendString(out, header);
+    }
+    
+    appendUint32(out, static_cast<uint32_t>(rows.size()));
+    for (const auto& row : rows) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            appendString(out, i < row.size() ? row[i] : std::string());
+        }
+    }
+    return out;
+}
+
+void decodeResult(const std::string& payload,
+                  std::vector<std::string>& headers,
+                  std::vector<std::vector<std::string>>& rows) {
+    size_t pos = 0;
+    headers.clear();
+    rows.clear();
+    
+    uint32_t columnCount = readUint32(payload, pos);
+    for (uint32_t i = 0; i < columnCount; i++) {
+        headers.push_back(readString(payload, pos));
+    }
+    
+    uint32_t rowCount = readUint32(payload, pos);
+    for (uint32_t r = 0; r < rowCount; r++) {
+        std::vector<std::string> row;
+        row.reserve(columnCount);
+        for (uint32_t i = 0; i < columnCount; i++) {
+            row.push_back(readString(payload, pos));
+        }
+        rows.push_back(std::move(row));
+    }
+}
+
+} // namespace WireProtocol
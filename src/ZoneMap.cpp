@@ -0,0 +1,82 @@
+#include "ZoneMap.h"
+
+namespace {
+
+// 与 Table::evaluateCondition 相同的比较
+bool compare(const std::string& a, const std::string& op, const std::string& b) {
+    if (op == "=") return a == b;
+    if (op == "!=") return a != b;
+    if (op == ">") return a > b;
+    if (op == "<") return a < b;
+    if (op == ">=") return a >= b;
+    if (op == "<=") return a <= b;
+    return true;
+}
+
+} // namespace
+
+void ZoneMap::rebuild(const TableRows& data) {
+    blocks.clear();
+    rowCount = 0;
+    for (const auto& row : data) {
+        addRow(row);
+    }
+}
+
+void ZoneMap::addRow(const TableRow& row) {
+    if (rowCount % BLOCK_ROWS == 0) {
+        blocks.emplace_back(row.size());
+    }
+    auto& zones = blocks.back();
+    for (size_t i = 0; i < row.size() && i < zones.size(); i++) {
+        include(zones[i], row[i]);
+    }
+    rowCount++;
+}
+
+void ZoneMap::updateRow(size_t rowIndex, const TableRow& row) {
+    if (rowIndex >= rowCount) {
+        return;
+    }
+    auto& zones = blocks[rowIndex / BLOCK_ROWS];
+    for (size_t i = 0; i < row.size() && i < zones.size(); i++) {
+        include(zones[i], row[i]);
+    }
+}
+
+bool ZoneMap::mayMatch(size_t block, size_t column, const std::string& op, const std::string& value) const {
+    if (block >= blocks.size() || column >= blocks[block].size()) {
+        return true;
+    }
+
+    const ColumnZone& zone = blocks[block][column];
+    if (zone.nullCount > 0 && compare("", op, value)) {
+        return true;
+    }
+    if (!zone.hasValues) {
+        return false;
+    }
+
+    if (op == "=") return zone.minValue <= value && value <= zone.maxValue;
+    if (op == "!=") return zone.minValue != value || zone.maxValue != value;
+    if (op == ">") return zone.maxValue > value;
+    if (op == ">=") return zone.maxValue >= value;
+    if (op == "<") return zone.minValue < value;
+    if (op == "<=") return zone.minValue <= value;
+    return true;
+}
+
+void ZoneMap::include(ColumnZone& zone, const std::string& value) {
+    if (value.empty()) {
+        zone.nullCount++;
+        return;
+    }
+    if (!zone.hasValues) {
+        zone.hasValues = true;
+        zone.minValue = value;
+        zone.maxValue = value;
+        return;
+    }
+    if (value < zone.minValue) zone.minValue = value;
+    if (value > zone.maxValue) zone.maxValue = value;
+}
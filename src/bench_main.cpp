@@ -0,0 +1,633 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <functional>
+#include <filesystem>
+#include <cstdlib>
+#include "DatabaseManager.h"
+#include "SQLParser.h"
+#include "Table.h"
+#include "Checksum.h"
+
+// 引擎热点路径的微基准测试
+//
+// 数据由固定种子生成，同样的参数在不同提交之间得到完全相同的数据。
+// 输出格式与 Google Benchmark 的 JSON 输出一致，可以直接用其 compare.py 比较两次结果。
+namespace {
+
+struct BenchOptions {
+    size_t students = 10000;
+    size_t courses = 100;
+    size_t coursesPerStudent = 3;
+    size_t joinStudents = 200;   // 连接查询使用的数据集大小
+    uint64_t seed = 42;
+    double minTime = 0.5;        // 每项测试至少运行的秒数
+    std::string filter;
+    std::string dataPath;
+    std::string outputPath;
+};
+
+// ===== 合成数据（与 example.sql 的 Students/Courses/StudentCourses 结构相同） =====
+
+ColumnDef makeColumn(const std::string& name, const std::string& type,
+                     bool nullable = true, bool primaryKey = false) {
+    ColumnDef col;
+    col.name = name;
+    col.type = type;
+    col.nullable = nullable;
+    col.primaryKey = primaryKey;
+    return col;
+}
+
+std::vector<ColumnDef> studentColumns() {
+    return {
+        makeColumn("ID", "INTEGER", false, true),
+        makeColumn("Name", "TEXT", false),
+        makeColumn("Age", "INTEGER"),
+        makeColumn("Gender", "TEXT"),
+        makeColumn("Department", "TEXT"),
+        makeColumn("EnrollmentDate", "TEXT"),
+    };
+}
+
+std::vector<ColumnDef> courseColumns() {
+    return {
+        makeColumn("CourseID", "INTEGER", false, true),
+        makeColumn("CourseName", "TEXT", false),
+        makeColumn("Credits", "INTEGER"),
+        makeColumn("TeacherName", "TEXT"),
+    };
+}
+
+std::vector<ColumnDef> studentCourseColumns() {
+    auto columns = std::vector<ColumnDef>{
+        makeColumn("StudentID", "INTEGER"),
+        makeColumn("CourseID", "INTEGER"),
+        makeColumn("Grade", "FLOAT"),
+    };
+    columns[0].isForeignKey = true;
+    columns[0].referenceTable = "Students";
+    columns[0].referenceColumn = "ID";
+    columns[1].isForeignKey = true;
+    columns[1].referenceTable = "Courses";
+    columns[1].referenceColumn = "CourseID";
+    return columns;
+}
+
+using Rows = std::vector<std::vector<std::string>>;
+
+class DataGenerator {
+public:
+    explicit DataGenerator(uint64_t seed) : rng(seed) {}
+
+    Rows students(size_t count) {
+        static const std::vector<std::string> surnames = {"张", "李", "王", "赵", "陈", "刘", "杨", "黄"};
+        static const std::vector<std::string> departments = {
+            "计算机系", "数学系", "物理系", "化学系", "生物系", "经济系", "外语系", "历史系"};
+
+        Rows rows;
+        rows.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            rows.push_back({
+                std::to_string(i + 1),
+                pick(surnames) + std::to_string(i + 1),
+                std::to_string(uniform(17, 25)),
+                uniform(0, 1) ? "男" : "女",
+                pick(departments),
+                std::to_string(uniform(2018, 2024)) + "-09-01",
+            });
+        }
+        return rows;
+    }
+
+    Rows courses(size_t count) {
+        static const std::vector<std::string> teachers = {"陈教授", "李教授", "王教授", "周教授", "吴教授"};
+
+        Rows rows;
+        rows.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            rows.push_back({
+                std::to_string(101 + i),
+                "课程" + std::to_string(101 + i),
+                std::to_string(uniform(1, 5)),
+                pick(teachers),
+            });
+        }
+        return rows;
+    }
+
+    Rows studentCourses(size_t studentCount, size_t courseCount, size_t perStudent) {
+        Rows rows;
+        rows.reserve(studentCount * perStudent);
+        for (size_t s = 0; s < studentCount; s++) {
+            for (size_t k = 0; k < perStudent; k++) {
+                int grade = uniform(600, 1000);
+                rows.push_back({
+                    std::to_string(s + 1),
+                    std::to_string(101 + uniform(0, static_cast<int>(courseCount) - 1)),
+                    std::to_string(grade / 10) + "." + std::to_string(grade % 10),
+                });
+            }
+        }
+        return rows;
+    }
+
+private:
+    std::mt19937_64 rng;
+
+    int uniform(int low, int high) {
+        return std::uniform_int_distribution<int>(low, high)(rng);
+    }
+
+    const std::string& pick(const std::vector<std::string>& values) {
+        return values[uniform(0, static_cast<int>(values.size()) - 1)];
+    }
+};
+
+Table buildTable(const std::string& name, const std::vector<ColumnDef>& columns, const Rows& rows) {
+    Table table(name, columns);
+    for (const auto& row : rows) {
+        table.insertRow(row);
+    }
+    return table;
+}
+
+// ===== 测试框架 =====
+
+// 测试体可以用 pause()/resume() 把准备工作排除在计时之外
+class BenchState {
+public:
+    void pause() {
+        pausedAt = std::chrono::steady_clock::now();
+        pausedCpuAt = std::clock();
+    }
+
+    void resume() {
+        excluded += std::chrono::steady_clock::now() - pausedAt;
+        excludedCpu += std::clock() - pausedCpuAt;
+    }
+
+private:
+    friend class BenchRunner;
+    std::chrono::steady_clock::time_point pausedAt;
+    std::clock_t pausedCpuAt = 0;
+    std::chrono::steady_clock::duration excluded{};
+    std::clock_t excludedCpu = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    size_t iterations = 0;
+    double realTimeNs = 0;   // 每次迭代
+    double cpuTimeNs = 0;    // 每次迭代
+    double itemsPerSecond = 0;
+};
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : options(options) {}
+
+    // itemsPerIteration 为每次迭代处理的行数（或语句数），用于计算吞吐量
+    void run(const std::string& name, size_t itemsPerIteration,
+             const std::function<void(BenchState&)>& body) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+            return;
+        }
+
+        size_t iterations = 1;
+        while (true) {
+            BenchState state;
+            auto start = std::chrono::steady_clock::now();
+            std::clock_t cpuStart = std::clock();
+            for (size_t i = 0; i < iterations; i++) {
+                body(state);
+            }
+            double real = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start - state.excluded).count();
+            double cpu = static_cast<double>(std::clock() - cpuStart - state.excludedCpu) / CLOCKS_PER_SEC;
+
+            // 与 Google Benchmark 相同：按已测耗时估算达到最短运行时间所需的迭代次数
+            if (real >= options.minTime || iterations >= 1000000000) {
+                BenchResult result;
+                result.name = name;
+                result.iterations = iterations;
+                result.realTimeNs = real * 1e9 / iterations;
+                result.cpuTimeNs = cpu * 1e9 / iterations;
+                result.itemsPerSecond = real > 0 ? itemsPerIteration * iterations / real : 0;
+                report(result);
+                results.push_back(result);
+                return;
+            }
+            double multiplier = real > 0 ? options.minTime * 1.4 / real : 10.0;
+            multiplier = std::min(10.0, std::max(2.0, multiplier));
+            iterations = static_cast<size_t>(iterations * multiplier);
+        }
+    }
+
+    const std::vector<BenchResult>& getResults() const { return results; }
+
+private:
+    const BenchOptions& options;
+    std::vector<BenchResult> results;
+
+    static void report(const BenchResult& result) {
+        std::cerr << std::left << std::setw(56) << result.name
+                  << std::right << std::setw(16) << std::fixed << std::setprecision(0)
+                  << result.realTimeNs << " ns"
+                  << std::setw(12) << result.iterations
+                  << std::setw(16) << std::setprecision(1) << result.itemsPerSecond << " items/s\n";
+    }
+};
+
+// 防止编译器把测试结果优化掉
+volatile size_t sink = 0;
+
+void consume(const Rows& rows) {
+    sink = sink + rows.size();
+}
+
+std::string jsonEscape(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options,
+               const std::vector<BenchResult>& results) {
+    std::time_t now = std::time(nullptr);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+    out << "    \"executable\": \"dbms_bench\",\n";
+    out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+    out << "    \"library_build_type\": \"release\",\n";
+#else
+    out << "    \"library_build_type\": \"debug\",\n";
+#endif
+    out << "    \"students\": " << options.students << ",\n";
+    out << "    \"courses\": " << options.courses << ",\n";
+    out << "    \"courses_per_student\": " << options.coursesPerStudent << ",\n";
+    out << "    \"join_students\": " << options.joinStudents << ",\n";
+    out << "    \"seed\": " << options.seed << "\n";
+    out << "  },\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << std::setprecision(6) << std::defaultfloat;
+        out << "    {\n";
+        out << "      \"name\": \"" << jsonEscape(r.name) << "\",\n";
+        out << "      \"run_name\": \"" << jsonEscape(r.name) << "\",\n";
+        out << "      \"run_type\": \"iteration\",\n";
+        out << "      \"iterations\": " << r.iterations << ",\n";
+        out << "      \"real_time\": " << std::fixed << std::setprecision(1) << r.realTimeNs << ",\n";
+        out << "      \"cpu_time\": " << r.cpuTimeNs << ",\n";
+        out << "      \"time_unit\": \"ns\",\n";
+        out << "      \"items_per_second\": " << r.itemsPerSecond << "\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+void printUsage(const char* program) {
+    std::cerr << "用法: " << program << " [选项]\n"
+              << "  --students <数量>             Students 行数（默认 10000）\n"
+              << "  --courses <数量>              Courses 行数（默认 100）\n"
+              << "  --courses-per-student <数量>  每个学生的选课数（默认 3）\n"
+              << "  --join-students <数量>        连接查询使用的学生数（默认 200）\n"
+              << "  --seed <种子>                 随机种子（默认 42）\n"
+              << "  --min-time <秒>               每项测试的最短运行时间（默认 0.5）\n"
+              << "  --filter <子串>               只运行名称包含该子串的测试\n"
+              << "  --data <目录>                 读写测试使用的数据目录（默认临时目录）\n"
+              << "  --out <文件>                  JSON 结果写入文件（默认标准输出）\n";
+}
+
+bool parseArgs(int argc, char *argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--students") {
+            options.students = std::stoull(value);
+        } else if (arg == "--courses") {
+            options.courses = std::stoull(value);
+        } else if (arg == "--courses-per-student") {
+            options.coursesPerStudent = std::stoull(value);
+        } else if (arg == "--join-students") {
+            options.joinStudents = std::stoull(value);
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else if (arg == "--min-time") {
+            options.minTime = std::stod(value);
+        } else if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--data") {
+            options.dataPath = value;
+        } else if (arg == "--out") {
+            options.outputPath = value;
+        } else {
+            return false;
+        }
+    }
+    return options.students > 0 && options.courses > 0 && options.joinStudents > 0;
+}
+
+// ===== 测试项 =====
+
+void benchParser(BenchRunner& runner) {
+    const std::vector<std::pair<std::string, std::string>> statements = {
+        {"select_where", "SELECT Name, Age FROM Students WHERE Department = 计算机系 ORDER BY Age DESC;"},
+        {"select_join", "SELECT s.Name, sc.Grade FROM Students s JOIN StudentCourses sc ON s.ID = sc.StudentID;"},
+        {"select_aggregate", "SELECT Department, COUNT(*), AVG(Age) FROM Students GROUP BY Department;"},
+        {"insert", "INSERT INTO Students (ID, Name, Age, Gender, Department, EnrollmentDate) "
+                   "VALUES (1, 张三, 20, 男, 计算机系, 2022-09-01);"},
+        {"update", "UPDATE Students SET Age = 21 WHERE ID = 1;"},
+        {"create", "CREATE TABLE Students (ID INTEGER PRIMARY KEY, Name TEXT NOT NULL, Age INTEGER, "
+                   "Gender TEXT, Department TEXT, EnrollmentDate TEXT);"},
+    };
+
+    SQLParser::SQLParser parser;
+    for (const auto& statement : statements) {
+        runner.run("SQLParser::parse/" + statement.first, 1, [&](BenchState&) {
+            auto query = parser.parse(statement.second);
+            sink = sink + query.columns.size();
+        });
+    }
+}
+
+void benchTable(BenchRunner& runner, const Rows& studentRows) {
+    const auto columns = studentColumns();
+    const size_t rows = studentRows.size();
+
+    runner.run("Table::insertRow/Students/" + std::to_string(rows), rows, [&](BenchState&) {
+        Table table("Students", columns);
+        for (const auto& row : studentRows) {
+            table.insertRow(row);
+        }
+        sink = sink + table.getData().size();
+    });
+
+    const Table students = buildTable("Students", columns, studentRows);
+
+    runner.run("Table::select/all/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.select({"*"}));
+    });
+
+    runner.run("Table::select/where_eq/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.select({"Name", "Age"}, "Department = 计算机系"));
+    });
+
+    runner.run("Table::select/where_and/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.select({"Name", "Age"}, "Department = 计算机系 AND Gender = 女"));
+    });
+
+    // select 带 ORDER BY 时走 sortData
+    runner.run("Table::sortData/Age/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.select({"*"}, "", "Age", false));
+    });
+
+    runner.run("Table::sortData/Name_desc/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.select({"*"}, "", "Name", true));
+    });
+
+    SQLParser::SQLParser parser;
+    auto aggregate = parser.parse(
+        "SELECT Department, COUNT(*), AVG(Age), MAX(Age) FROM Students GROUP BY Department;");
+    runner.run("Table::selectWithAggregates/group_by/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.selectWithAggregates(
+            aggregate.columns, aggregate.whereClause, aggregate.groupByColumns, aggregate.havingClause));
+    });
+
+    auto countAll = parser.parse("SELECT COUNT(*) FROM Students;");
+    runner.run("Table::selectWithAggregates/count/" + std::to_string(rows), rows, [&](BenchState&) {
+        consume(students.selectWithAggregates(
+            countAll.columns, countAll.whereClause, countAll.groupByColumns, countAll.havingClause));
+    });
+}
+
+void benchDatabase(BenchRunner& runner, const BenchOptions& options, DataGenerator& generator,
+                   const Rows& studentRows) {
+    const std::string database = "bench";
+    DatabaseManager dbManager(options.dataPath);
+    std::filesystem::remove_all(std::filesystem::path(options.dataPath) / database);
+    dbManager.createDatabase(database);
+    dbManager.useDatabase(database);
+
+    Rows courseRows = generator.courses(options.courses);
+    Rows enrollmentRows = generator.studentCourses(
+        studentRows.size(), options.courses, options.coursesPerStudent);
+
+    // 写入全部表，供加载测试使用
+    const std::vector<std::tuple<std::string, std::vector<ColumnDef>, const Rows*>> tables = {
+        {"Students", studentColumns(), &studentRows},
+        {"Courses", courseColumns(), &courseRows},
+        {"StudentCourses", studentCourseColumns(), &enrollmentRows},
+    };
+    size_t totalRows = 0;
+    for (const auto& [name, columns, rows] : tables) {
+        dbManager.createTable(name, columns);
+        dbManager.replaceTable(name, buildTable(name, columns, *rows));
+        totalRows += rows->size();
+    }
+
+    // 连接查询使用缩小的数据集
+    size_t joinStudents = std::min(options.joinStudents, studentRows.size());
+    Rows joinStudentRows(studentRows.begin(), studentRows.begin() + joinStudents);
+    Rows joinEnrollmentRows(enrollmentRows.begin(),
+                            enrollmentRows.begin() + joinStudents * options.coursesPerStudent);
+    dbManager.createTable("SampleStudents", studentColumns());
+    dbManager.replaceTable("SampleStudents", buildTable("SampleStudents", studentColumns(), joinStudentRows));
+    dbManager.createTable("SampleStudentCourses", studentCourseColumns());
+    dbManager.replaceTable("SampleStudentCourses",
+                           buildTable("SampleStudentCourses", studentCourseColumns(), joinEnrollmentRows));
+    totalRows += joinStudentRows.size() + joinEnrollmentRows.size();
+
+    SQLParser::SQLParser parser;
+    auto join = parser.parse(
+        "SELECT SampleStudents.Name, SampleStudentCourses.Grade FROM SampleStudents "
+        "JOIN SampleStudentCourses ON SampleStudents.ID = SampleStudentCourses.StudentID;");
+    runner.run("DatabaseManager::executeMultiTableSelect/inner_join/" + std::to_string(joinStudents),
+               joinStudentRows.size() + joinEnrollmentRows.size(), [&](BenchState&) {
+        consume(dbManager.executeSelect(join));
+    });
+
+    // 两表连接算子
+    const Table joinLeft = buildTable("SampleStudents", studentColumns(), joinStudentRows);
+    const Table joinRight = buildTable("SampleStudentCourses", studentCourseColumns(), joinEnrollmentRows);
+    runner.run("Table::join/nested_loop/" + std::to_string(joinStudents),
+               joinStudentRows.size() + joinEnrollmentRows.size(), [&](BenchState&) {
+        consume(joinLeft.join(joinRight, "ID", "StudentID", JoinType::INNER, JoinMethod::NESTED_LOOP));
+    });
+    runner.run("Table::join/sort_merge/" + std::to_string(joinStudents),
+               joinStudentRows.size() + joinEnrollmentRows.size(), [&](BenchState&) {
+        consume(joinLeft.join(joinRight, "ID", "StudentID", JoinType::INNER, JoinMethod::SORT_MERGE));
+    });
+    // 文本列上的连接：同系的学生两两组合（索引嵌套循环只用于文本键）
+    runner.run("Table::join/text_sort_merge/" + std::to_string(joinStudents), joinStudentRows.size() * 2,
+               [&](BenchState&) {
+        consume(joinLeft.join(joinLeft, "Department", "Department", JoinType::INNER, JoinMethod::SORT_MERGE));
+    });
+    Table indexedLeft = joinLeft;
+    indexedLeft.createIndex("Department");
+    runner.run("Table::join/index_nested_loop/" + std::to_string(joinStudents), joinStudentRows.size() * 2,
+               [&](BenchState&) {
+        consume(joinLeft.join(indexedLeft, "Department", "Department", JoinType::INNER,
+                              JoinMethod::INDEX_NESTED_LOOP));
+    });
+    runner.run("Table::join/dictionary/" + std::to_string(joinStudents), joinStudentRows.size() * 2,
+               [&](BenchState&) {
+        consume(joinLeft.join(joinLeft, "Department", "Department", JoinType::INNER, JoinMethod::DICTIONARY));
+    });
+
+    // 表文件每块的校验和，保存和加载时各计算一遍
+    std::string checksumInput(1 << 20, '\0');
+    for (size_t i = 0; i < checksumInput.size(); i++) {
+        checksumInput[i] = static_cast<char>(i * 131);
+    }
+    runner.run(std::string("Checksum::crc32c/") + Checksum::crc32cImplementation() + "/" +
+                   std::to_string(checksumInput.size()),
+               checksumInput.size(), [&](BenchState&) {
+        sink = sink + Checksum::crc32c(checksumInput.data(), checksumInput.size());
+    });
+
+    auto studentsHandle = dbManager.getTable("Students");
+    runner.run("DatabaseManager::saveTableToFile/Students/" + std::to_string(studentRows.size()),
+               studentRows.size(), [&](BenchState& state) {
+        state.pause();
+        Table copy = *studentsHandle;
+        state.resume();
+        dbManager.replaceTable("Students", std::move(copy));
+    });
+
+    // 同步保存与延迟保存（修改只提交到内存，表文件由后台线程写入）的单次修改延迟
+    auto coursesHandle = dbManager.getTable("Courses");
+    for (bool deferred : {false, true}) {
+        dbManager.setAutoSaveInterval(std::chrono::milliseconds(deferred ? 1000 : 0));
+        runner.run(std::string("DatabaseManager::replaceTable/") + (deferred ? "deferred" : "sync") +
+                       "/Courses/" + std::to_string(coursesHandle->getData().size()),
+                   1, [&](BenchState& state) {
+            state.pause();
+            Table copy = *coursesHandle;
+            state.resume();
+            dbManager.replaceTable("Courses", std::move(copy));
+        });
+    }
+    dbManager.setAutoSaveInterval(std::chrono::milliseconds(0));
+
+    // 在线备份：完整备份复制全部表文件；修改一张表后的增量备份只复制这张表，其余从上一个备份硬链接
+    const std::filesystem::path backupRoot = std::filesystem::path(options.dataPath) / "bench_backup";
+    runner.run("DatabaseManager::backupDatabase/full/" + std::to_string(tables.size()), tables.size(),
+               [&](BenchState& state) {
+        state.pause();
+        std::filesystem::remove_all(backupRoot);
+        state.resume();
+        dbManager.backupDatabase(backupRoot.string(), false);
+    });
+    runner.run("DatabaseManager::backupDatabase/incremental/" + std::to_string(tables.size()), tables.size(),
+               [&](BenchState& state) {
+        state.pause();
+        Table copy = *coursesHandle;
+        dbManager.replaceTable("Courses", std::move(copy));
+        state.resume();
+        dbManager.backupDatabase(backupRoot.string(), true);
+    });
+    std::filesystem::remove_all(backupRoot);
+
+    // 打开数据库只读取列定义，访问各表时才加载表数据
+    runner.run("DatabaseManager::useDatabase/" + std::to_string(tables.size() + 2), tables.size() + 2,
+               [&](BenchState&) {
+        dbManager.useDatabase(database);
+    });
+    // 在两个数据库之间来回切换：已打开的数据库从缓存中取出，已加载的表数据保留
+    const std::string otherDatabase = "bench_other";
+    std::filesystem::remove_all(std::filesystem::path(options.dataPath) / otherDatabase);
+    dbManager.createDatabase(otherDatabase);
+    dbManager.useDatabase(database);
+    sink = sink + dbManager.getTable("Students")->getData().size();
+    runner.run("DatabaseManager::switchDatabase/2", 2, [&](BenchState&) {
+        dbManager.useDatabase(otherDatabase);
+        dbManager.useDatabase(database);
+        sink = sink + dbManager.getTable("Students")->getData().size();
+    });
+    runner.run("DatabaseManager::loadFromFile/" + std::to_string(totalRows), totalRows, [&](BenchState&) {
+        dbManager.useDatabase(database);
+        for (const auto& name : dbManager.getTableList()) {
+            sink = sink + dbManager.getTable(name)->getData().size();
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    bool temporaryData = options.dataPath.empty();
+    if (temporaryData) {
+        std::string pattern = (std::filesystem::temp_directory_path() / "dbms_bench.XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            std::cerr << "无法创建临时目录\n";
+            return 1;
+        }
+        options.dataPath = pattern;
+    }
+
+    BenchRunner runner(options);
+    try {
+        DataGenerator generator(options.seed);
+        Rows studentRows = generator.students(options.students);
+
+        benchParser(runner);
+        benchTable(runner, studentRows);
+        benchDatabase(runner, options, generator, studentRows);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        if (temporaryData) {
+            std::filesystem::remove_all(options.dataPath);
+        }
+        return 1;
+    }
+
+    if (temporaryData) {
+        std::filesystem::remove_all(options.dataPath);
+    }
+
+    if (options.outputPath.empty()) {
+        writeJson(std::cout, options, runner.getResults());
+    } else {
+        std::ofstream out(options.outputPath);
+        if (!out) {
+            std::cerr << "无法写入文件: " << options.outputPath << "\n";
+            return 1;
+        }
+        writeJson(out, options, runner.getResults());
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "DatabaseManager.h"
+#include "SQLParser.h"
+#include "WireProtocol.h"
+#include "Trace.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "用法: " << program
+              << " --database <名称> [--data <目录>] [--slow-query-ms <毫秒>] [--trace <文件>]\n"
+              << "      [--table-memory-mb <MB>] [--buffer-pool-mb <MB>] [--load-threads <数量>]\n"
+              << "      [--auto-save-ms <毫秒>] [--backup <目录>]\n"
+              << "      [-e <SQL>] [脚本文件]\n"
+              << "      " << program
+              << " --socket <路径> [-e <SQL>] [脚本文件]\n"
+              << "未指定 -e 和脚本文件时从标准输入读取SQL\n";
+}
+
+// 按行读取脚本，忽略注释和空行，遇到以分号结尾的行时切分出一条语句
+// （与批处理对话框的规则相同）
+std::vector<std::string> splitStatements(std::istream& in) {
+    std::vector<std::string> statements;
+    std::string buffer;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line.compare(first, 2, "--") == 0) {
+            continue;
+        }
+
+        buffer += line + "\n";
+
+        size_t last = line.find_last_not_of(" \t\r");
+        if (line[last] == ';') {
+            statements.push_back(buffer);
+            buffer.clear();
+        }
+    }
+
+    // 最后一条语句允许省略分号
+    if (buffer.find_first_not_of(" \t\r\n") != std::string::npos) {
+        statements.push_back(buffer);
+    }
+    return statements;
+}
+
+void printResults(const std::vector<std::string>& headers,
+                  const std::vector<std::vector<std::string>>& rows) {
+    for (size_t i = 0; i < headers.size(); i++) {
+        std::cout << (i > 0 ? " | " : "") << headers[i];
+    }
+    std::cout << "\n";
+
+    for (const auto& row : rows) {
+        for (size_t i = 0; i < row.size(); i++) {
+            std::cout << (i > 0 ? " | " : "") << row[i];
+        }
+        std::cout << "\n";
+    }
+    std::cout << "(" << rows.size() << " 行)\n";
+}
+
+// 在本进程内直接执行
+bool executeLocal(DatabaseManager& dbManager, const std::string& sql) {
+    SQLParser::SQLParser parser;
+    auto query = parser.parse(sql);
+
+    if (query.type == "SELECT") {
+        auto headers = dbManager.getResultHeaders(query);
+        auto results = dbManager.executeSelect(query);
+        printResults(headers, results);
+        return true;
+    }
+
+    if (!dbManager.executeNonQuery(query)) {
+        std::cerr << "执行失败: " << sql;
+        return false;
+    }
+    std::cout << "执行成功\n";
+    return true;
+}
+
+// 通过 dbms_server 的本地套接字执行
+bool executeRemote(int fd, const std::string& sql) {
+    WireProtocol::Message request;
+    request.type = WireProtocol::MessageType::QUERY;
+    request.payload = sql;
+    WireProtocol::writeMessage(fd, request);
+
+    WireProtocol::Message response;
+    if (!WireProtocol::readMessage(fd, response)) {
+        throw std::runtime_error("服务器已断开连接");
+    }
+
+    switch (response.type) {
+        case WireProtocol::MessageType::RESULT: {
+            std::vector<std::string> headers;
+            std::vector<std::vector<std::string>> rows;
+            WireProtocol::decodeResult(response.payload, headers, rows);
+            printResults(headers, rows);
+            return true;
+        }
+        case WireProtocol::MessageType::OK:
+            std::cout << "执行成功\n";
+            return true;
+        case WireProtocol::MessageType::ERROR:
+            std::cerr << "错误: " << response.payload << "\n";
+            return false;
+        default:
+            throw std::runtime_error("未知的响应类型");
+    }
+}
+
+int connectToServer(const std::string& socketPath) {
+    sockaddr_un addr{};
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("套接字路径过长: " + socketPath);
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("无法创建套接字");
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("无法连接服务器: " + socketPath);
+    }
+    return fd;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::string dataPath = "./data";
+    std::string database;
+    std::string socketPath;
+    std::string inlineSql;
+    std::string scriptPath;
+    double slowQueryMs = 100;
+    std::string tracePath;
+    size_t tableMemoryMb = 0;   // 已加载表数据的内存上限，0 表示不限制
+    size_t bufferPoolMb = DatabaseManager::DEFAULT_BUFFER_POOL_BYTES >> 20;   // 数据页缓冲池的容量
+    size_t loadThreads = 0;     // 加载表数据的线程数，0 表示按 CPU 核数
+    long autoSaveMs = 0;        // 自动保存间隔，0 表示每次修改都同步写入表文件
+    std::string backupPath;     // 执行完后增量备份数据库到这个目录
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--data" && hasValue) {
+            dataPath = argv[++i];
+        } else if (arg == "--database" && hasValue) {
+            database = argv[++i];
+        } else if (arg == "--socket" && hasValue) {
+            socketPath = argv[++i];
+        } else if (arg == "--slow-query-ms" && hasValue) {
+            slowQueryMs = std::stod(argv[++i]);
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--table-memory-mb" && hasValue) {
+            tableMemoryMb = std::stoul(argv[++i]);
+        } else if (arg == "--buffer-pool-mb" && hasValue) {
+            bufferPoolMb = std::stoul(argv[++i]);
+        } else if (arg == "--load-threads" && hasValue) {
+            loadThreads = std::stoul(argv[++i]);
+        } else if (arg == "--auto-save-ms" && hasValue) {
+            autoSaveMs = std::stol(argv[++i]);
+        } else if (arg == "--backup" && hasValue) {
+            backupPath = argv[++i];
+        } else if (arg == "-e" && hasValue) {
+            inlineSql = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-' && scriptPath.empty()) {
+            scriptPath = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (database.empty() && socketPath.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> statements;
+    if (!inlineSql.empty()) {
+        std::istringstream in(inlineSql);
+        statements = splitStatements(in);
+    } else if (!scriptPath.empty()) {
+        std::ifstream in(scriptPath);
+        if (!in) {
+            std::cerr << "无法打开文件: " << scriptPath << "\n";
+            return 1;
+        }
+        statements = splitStatements(in);
+    } else {
+        statements = splitStatements(std::cin);
+    }
+
+    int failures = 0;
+    try {
+        if (!socketPath.empty()) {
+            int fd = connectToServer(socketPath);
+            for (const auto& sql : statements) {
+                if (!executeRemote(fd, sql)) {
+                    failures++;
+                }
+            }
+            ::close(fd);
+        } else {
+            if (!tracePath.empty()) {
+                Trace::start();
+            }
+            DatabaseManager dbManager(dataPath);
+            dbManager.getQueryStats().setSlowQueryThreshold(slowQueryMs);
+            dbManager.setTableMemoryLimit(tableMemoryMb << 20);
+            dbManager.setBufferPoolSize(bufferPoolMb << 20);
+            dbManager.setLoadThreads(loadThreads);
+            dbManager.setAutoSaveInterval(std::chrono::milliseconds(autoSaveMs));
+            if (!dbManager.useDatabase(database)) {
+                std::cerr << "数据库不存在: " << database << "\n";
+                return 1;
+            }
+            for (const auto& sql : statements) {
+                try {
+                    if (!executeLocal(dbManager, sql)) {
+                        failures++;
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "错误: " << e.what() << "\n";
+                    failures++;
+                }
+            }
+            if (!backupPath.empty()) {
+                auto backup = dbManager.backupDatabase(backupPath);
+                if (backup.created) {
+                    std::cout << "备份完成: " << backup.path << "（" << backup.files << " 个文件，硬链接 "
+                              << backup.linkedFiles << " 个，复制 " << backup.copiedBytes << " 字节）\n";
+                } else {
+                    std::cout << "与上一个备份相同: " << backup.path << "\n";
+                }
+            }
+            if (!tracePath.empty()) {
+                Trace::stop();
+                if (!Trace::writeChromeTrace(tracePath)) {
+                    std::cerr << "无法写入追踪文件: " << tracePath << "\n";
+                    failures++;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -4,6 +4,7 @@
 #include "UserManagerDialog.h"
 #include "SettingsDialog.h"
 #include "BatchProcessDialog.h"
+#include "Trace.h"
 #include <QtWidgets>
 #include <QtCore/QTextStream>
 #include <QtCore/QFile>
@@ -108,9 +109,13 @@ void MainWindow::setupUi() {
     buttonLayout->addStretch();
     rightLayout->addLayout(buttonLayout);
     
-    // 结果显示区
+    // 结果显示区：查询结果和 EXPLAIN 执行计划分别显示在两个标签页
+    resultTabs = new QTabWidget;
     resultTable = new QTableWidget;
-    rightLayout->addWidget(resultTable);
+    planTable = new QTableWidget;
+    resultTabs->addTab(resultTable, "结果");
+    resultTabs->addTab(planTable, "执行计划");
+    rightLayout->addWidget(resultTabs);
     
     // 设置分割器
     QSplitter* splitter = new QSplitter(Qt::Horizontal);
@@ -515,30 +520,25 @@ void MainWindow::executeSQL() {
         
         // 执行SQL
         if (query.type == "SELECT") {
-            // 获取表的所有列
-            const Table& table = dbManager.getTable(query.tableName);
-            std::vector<std::string> headers;
-            
-            // 如果是 SELECT *，使用所有列名
-            if (query.columns.size() == 1 && query.columns[0].name == "*") {
-                for (const auto& col : table.getColumns()) {
-                    headers.push_back(col.name);
-                }
-            } else {
-                // 使用查询指定的列名
-                for (const auto& col : query.columns) {
-                    headers.push_back(col.name);
-                }
-            }
+            // 获取结果列名
+            auto headers = dbManager.getResultHeaders(query);
             
             // 执行查询
             auto results = dbManager.executeSelect(query);
             
-            // 显示结果
-            displayResults(results, headers);
-            
-            // 更新状态栏
-            statusLabel->setText(QString("查询返回 %1 行").arg(results.size()));
+            if (query.explain) {
+                // 执行计划显示在单独的标签页，保留上一次的查询结果
+                fillTable(planTable, results, headers);
+                resultTabs->setCurrentWidget(planTable);
+                statusLabel->setText(query.explainAnalyze ? "已执行并分析查询" : "已生成执行计划");
+            } else {
+                // 显示结果
+                displayResults(results, headers);
+                resultTabs->setCurrentWidget(resultTable);
+                
+                // 更新状态栏
+                statusLabel->setText(QString("查询返回 %1 行").arg(results.size()));
+            }
         } else {
             if (dbManager.executeNonQuery(query)) {
                 statusLabel->setText("执行成功");
@@ -559,28 +559,34 @@ void MainWindow::executeSQL() {
 
 void MainWindow::displayResults(const std::vector<std::vector<std::string>>& results,
                               const std::vector<std::string>& headers) {
-    resultTable->clear();
-    resultTable->setRowCount(results.size());
-    resultTable->setColumnCount(headers.size());
+    fillTable(resultTable, results, headers);
+}
+
+void MainWindow::fillTable(QTableWidget* table,
+                           const std::vector<std::vector<std::string>>& results,
+                           const std::vector<std::string>& headers) {
+    table->clear();
+    table->setRowCount(results.size());
+    table->setColumnCount(headers.size());
     
     // 设置表头
     QStringList headerLabels;
     for (const auto& header : headers) {
         headerLabels << QString::fromStdString(header);
     }
-    resultTable->setHorizontalHeaderLabels(headerLabels);
+    table->setHorizontalHeaderLabels(headerLabels);
     
     // 填充数据
     for (int i = 0; i < results.size(); i++) {
         for (int j = 0; j < results[i].size() && j < headers.size(); j++) {
             QTableWidgetItem* item = new QTableWidgetItem(
                 QString::fromStdString(results[i][j]));
-            resultTable->setItem(i, j, item);
+            table->setItem(i, j, item);
         }
     }
     
     // 自动调整列宽
-    resultTable->resizeColumnsToContents();
+    table->resizeColumnsToContents();
 }
 
 void MainWindow::showError(const QString& message) {
@@ -628,10 +634,10 @@ void MainWindow::showTableStructure() {
     
     try {
         QString tableName = item->text();
-        const Table& table = dbManager.getTable(tableName.toStdString());
+        auto table = dbManager.getTable(tableName.toStdString());
         
         QString structure = "表结构:\n\n";
-        for (const auto& col : table.getColumns()) {
+        for (const auto& col : table->getColumns()) {
             structure += QString("列名: %1\n类型: %2\n可空: %3\n主键: %4\n\n")
                 .arg(QString::fromStdString(col.name))
                 .arg(QString::fromStdString(col.type))
@@ -653,9 +659,9 @@ void MainWindow::showTableContent() {
         QString tableName = item->text();
         
         // 获取表的所有列名
-        const Table& table = dbManager.getTable(tableName.toStdString());
+        auto table = dbManager.getTable(tableName.toStdString());
         std::vector<std::string> columnNames;
-        for (const auto& col : table.getColumns()) {
+        for (const auto& col : table->getColumns()) {
             columnNames.push_back(col.name);
         }
         
@@ -778,10 +784,10 @@ void MainWindow::editTableData() {
     
     try {
         QString tableName = item->text();
-        const Table& table = dbManager.getTable(tableName.toStdString());
+        auto table = dbManager.getTable(tableName.toStdString());
         
         // 创建并显示表数据编辑对话框
-        TableViewDialog* dialog = new TableViewDialog(table, dbManager, this);
+        TableViewDialog* dialog = new TableViewDialog(*table, dbManager, this);
         dialog->setWindowModality(Qt::WindowModal);
         dialog->show();
     } catch (const std::exception& e) {
@@ -833,6 +839,9 @@ QMenu* MainWindow::createToolsMenu() {
     QMenu* menu = new QMenu("工具(&T)", this);
     
     menu->addAction("批处理(&B)", this, &MainWindow::showBatchProcessDialog);
+    QAction* traceAction = menu->addAction("性能追踪(&P)");
+    traceAction->setCheckable(true);
+    connect(traceAction, &QAction::toggled, this, &MainWindow::toggleTracing);
     menu->addSeparator();
     menu->addAction("设置(&S)", this, &MainWindow::showSettingsDialog);
     menu->addAction("清除历史记录(&C)", this, &MainWindow::clearHistory);
@@ -840,6 +849,26 @@ QMenu* MainWindow::createToolsMenu() {
     return menu;
 }
 
+void MainWindow::toggleTracing(bool enabled) {
+    if (enabled) {
+        Trace::start();
+        statusLabel->setText("性能追踪已开始");
+        return;
+    }
+    
+    Trace::stop();
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "导出追踪", "trace.json", "Chrome 追踪文件 (*.json);;所有文件 (*)");
+    
+    if (!fileName.isEmpty()) {
+        if (Trace::writeChromeTrace(fileName.toStdString())) {
+            statusLabel->setText("追踪已导出，可在 chrome://tracing 或 Perfetto 中打开");
+        } else {
+            showError("无法写入追踪文件: " + fileName);
+        }
+    }
+}
+
 QMenu* MainWindow::createHelpMenu() {
     QMenu* menu = new QMenu("帮助(&H)", this);
     
@@ -999,6 +1028,24 @@ void MainWindow::applySettings() {
     editorFont.setPointSize(settings.value("fontSize", 12).toInt());
     sqlInput->setFont(editorFont);
     
+    // 慢查询日志阈值，-1 表示关闭
+    dbManager.getQueryStats().setSlowQueryThreshold(
+        settings.value("slowQueryThreshold", 100).toInt());
+    
+    // 已加载表数据的内存上限（0 表示不限制）和数据页缓冲池的容量
+    dbManager.setTableMemoryLimit(static_cast<size_t>(settings.value("tableMemoryMb", 0).toInt()) << 20);
+    dbManager.setBufferPoolSize(static_cast<size_t>(settings.value("bufferPoolMb", 64).toInt()) << 20);
+    
+    // 自动保存：开启时修改先提交到内存，按设置的间隔（分钟）写入表文件，关闭窗口时也会写入
+    int autoSaveMinutes = settings.value("autoSave", false).toBool()
+                              ? settings.value("autoSaveInterval", 5).toInt() : 0;
+    dbManager.setAutoSaveInterval(std::chrono::minutes(autoSaveMinutes));
+    
+    // 自动备份：按自动保存的间隔增量备份当前数据库，没有变化时不产生新的备份
+    std::string backupPath = settings.value("autoBackup", false).toBool()
+                                 ? settings.value("backupPath", "./backup").toString().toStdString() : "";
+    dbManager.setAutoBackup(backupPath, std::chrono::minutes(settings.value("autoSaveInterval", 5).toInt()));
+    
     // 应用其他设置
     // TODO: 实现其他设置的应用
 }
@@ -0,0 +1,159 @@
+#ifdef DBMS_HAS_QTCORE
+#include <QtCore/QSettings>
+#endif
+#include <iostream>
+#include <string>
+#include <thread>
+#include <csignal>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "DatabaseManager.h"
+#include "DatabaseServer.h"
+#include "Trace.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "用法: " << program
+              << " --database <名称> [--data <目录>] [--socket <路径>] [--max-connections <数量>]"
+              << " [--slow-query-ms <毫秒>] [--trace <文件>] [--table-memory-mb <MB>]"
+              << " [--buffer-pool-mb <MB>] [--load-threads <数量>] [--preload] [--auto-save-ms <毫秒>]"
+              << " [--backup-dir <目录>] [--backup-interval-ms <毫秒>]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::string dataPath = "./data";
+    int maxConnections = 10;
+    double slowQueryMs = 100;
+    long autoSaveMs = 0;        // 自动保存间隔，0 表示每次修改都同步写入表文件
+    std::string backupPath;     // 自动备份的目录，为空时不备份
+    long backupIntervalMs = 60 * 60 * 1000L;
+#ifdef DBMS_HAS_QTCORE
+    // 默认值与图形界面的设置保持一致
+    QSettings settings("MyCompany", "DatabaseSystem");
+    dataPath = settings.value("dbPath", "./data").toString().toStdString();
+    maxConnections = settings.value("maxConnections", 10).toInt();
+    slowQueryMs = settings.value("slowQueryThreshold", 100).toDouble();
+    if (settings.value("autoSave", false).toBool()) {
+        autoSaveMs = settings.value("autoSaveInterval", 5).toInt() * 60 * 1000L;
+    }
+    // 图形界面没有单独的备份间隔，与自动保存使用同一个间隔
+    if (settings.value("autoBackup", false).toBool()) {
+        backupPath = settings.value("backupPath", "./backup").toString().toStdString();
+        backupIntervalMs = settings.value("autoSaveInterval", 5).toInt() * 60 * 1000L;
+    }
+#endif
+    std::string socketPath = "/tmp/dbms_system.sock";
+    std::string database;
+    std::string tracePath;   // 开启时在退出时导出追踪
+    size_t tableMemoryMb = 0;   // 已加载表数据的内存上限，0 表示不限制
+    size_t bufferPoolMb = DatabaseManager::DEFAULT_BUFFER_POOL_BYTES >> 20;   // 数据页缓冲池的容量
+    size_t loadThreads = 0;     // 加载表数据的线程数，0 表示按 CPU 核数
+    bool preload = false;       // 启动时加载全部表，而不是等第一次访问
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--preload") {
+            preload = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (arg == "--data") {
+            dataPath = argv[++i];
+        } else if (arg == "--socket") {
+            socketPath = argv[++i];
+        } else if (arg == "--database") {
+            database = argv[++i];
+        } else if (arg == "--max-connections") {
+            maxConnections = std::stoi(argv[++i]);
+        } else if (arg == "--slow-query-ms") {
+            slowQueryMs = std::stod(argv[++i]);
+        } else if (arg == "--trace") {
+            tracePath = argv[++i];
+        } else if (arg == "--table-memory-mb") {
+            tableMemoryMb = std::stoul(argv[++i]);
+        } else if (arg == "--buffer-pool-mb") {
+            bufferPoolMb = std::stoul(argv[++i]);
+        } else if (arg == "--load-threads") {
+            loadThreads = std::stoul(argv[++i]);
+        } else if (arg == "--auto-save-ms") {
+            autoSaveMs = std::stol(argv[++i]);
+        } else if (arg == "--backup-dir") {
+            backupPath = argv[++i];
+        } else if (arg == "--backup-interval-ms") {
+            backupIntervalMs = std::stol(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (database.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    // 由主线程通过 sigwait 处理退出信号，工作线程不接收这些信号
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    try {
+        if (!tracePath.empty()) {
+            Trace::start();
+        }
+        DatabaseManager dbManager(dataPath);
+        dbManager.getQueryStats().setSlowQueryThreshold(slowQueryMs);
+        dbManager.setTableMemoryLimit(tableMemoryMb << 20);
+        dbManager.setBufferPoolSize(bufferPoolMb << 20);
+        dbManager.setLoadThreads(loadThreads);
+        dbManager.setAutoSaveInterval(std::chrono::milliseconds(autoSaveMs));
+        dbManager.setAutoBackup(backupPath, std::chrono::milliseconds(backupIntervalMs));
+        if (!dbManager.useDatabase(database)) {
+            std::cerr << "数据库不存在: " << database << "\n";
+            return 1;
+        }
+        if (preload) {
+            dbManager.preloadTables();
+        }
+        
+        DatabaseServer server(dbManager, socketPath, maxConnections);
+        std::thread serverThread([&server]() {
+            try {
+                server.run();
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                kill(getpid(), SIGTERM);
+            }
+        });
+        
+        std::cout << "服务已启动: " << socketPath
+                  << " (数据库 " << database << ", 最大连接数 " << maxConnections << ")\n";
+        
+        int received = 0;
+        sigwait(&signals, &received);
+        
+        server.stop();
+        serverThread.join();
+        
+        if (!tracePath.empty()) {
+            Trace::stop();
+            if (!Trace::writeChromeTrace(tracePath)) {
+                std::cerr << "无法写入追踪文件: " << tracePath << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
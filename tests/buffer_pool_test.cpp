@@ -0,0 +1,90 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "DatabaseManager.h"
+#include "SQLParser.h"
+#include "Table.h"
+
+// 不限制已加载表数据时，比缓冲池大的未加载表经缓冲池逐页扫描：
+// 第一次扫描读入全部页并淘汰，再次扫描命中保留下来的页，结果与整张加载时相同
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "失败: " << message << "\n";
+        failures++;
+    }
+}
+
+const size_t ROWS = 20000;   // 约 20 个数据块
+const size_t POOL_BYTES = 1 << 20;
+
+std::vector<ColumnDef> columns() {
+    std::vector<ColumnDef> result(3);
+    result[0].name = "ID";
+    result[0].type = "INTEGER";
+    result[0].nullable = false;
+    result[0].primaryKey = true;
+    result[1].name = "Name";
+    result[1].type = "TEXT";
+    result[2].name = "Score";
+    result[2].type = "INTEGER";
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::filesystem::path dataPath = argc > 1 ? argv[1] : "buffer_pool_test_data";
+    std::filesystem::remove_all(dataPath);
+    std::filesystem::create_directories(dataPath);
+    SQLParser::SQLParser parser;
+    auto query = parser.parse("SELECT ID, Name FROM Scores WHERE Score < 50;");
+
+    std::vector<std::vector<std::string>> expected;
+    {
+        DatabaseManager dbManager(dataPath.string());
+        dbManager.createDatabase("test");
+        dbManager.useDatabase("test");
+        dbManager.createTable("Scores", columns());
+        Table table("Scores", columns());
+        for (size_t i = 0; i < ROWS; i++) {
+            table.insertRow({std::to_string(i), "student_" + std::to_string(i), std::to_string(i % 100)});
+        }
+        dbManager.replaceTable("Scores", std::move(table));
+        // 已加载的表直接查询，作为期望的结果
+        expected = dbManager.executeSelect(query);
+    }
+
+    // 重新打开数据库，表未加载；不设置已加载表数据的上限
+    DatabaseManager dbManager(dataPath.string());
+    dbManager.setBufferPoolSize(POOL_BYTES);
+    dbManager.useDatabase("test");
+
+    auto first = dbManager.executeSelect(query);
+    auto afterFirst = dbManager.getBufferPoolStats();
+    check(first == expected, "第一次分页扫描的结果与整张加载时不同");
+    check(afterFirst.misses > 0 && afterFirst.hits == 0, "第一次扫描应当读入全部页");
+    check(afterFirst.evictions > 0, "表比缓冲池大，第一次扫描应当淘汰页");
+    check(afterFirst.bytes <= POOL_BYTES, "缓冲池占用超出容量");
+
+    auto second = dbManager.executeSelect(query);
+    auto afterSecond = dbManager.getBufferPoolStats();
+    check(second == expected, "第二次分页扫描的结果与整张加载时不同");
+    check(afterSecond.hits > 0, "第二次扫描应当命中保留下来的页");
+    check(afterSecond.evictions > afterFirst.evictions, "第二次扫描应当继续淘汰页");
+
+    auto version = dbManager.acquireSnapshot()->tables.at("Scores");
+    check(!version->table, "分页扫描不应整张加载表");
+
+    std::filesystem::remove_all(dataPath);
+    if (failures > 0) {
+        return 1;
+    }
+    std::cout << "buffer_pool_test: 命中 " << afterSecond.hits << " 页，未命中 " << afterSecond.misses
+              << " 页，淘汰 " << afterSecond.evictions << " 页\n";
+    return 0;
+}
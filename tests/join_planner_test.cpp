@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DatabaseManager.h"
+#include "SQLParser.h"
+#include "Table.h"
+
+// 多表查询的谓词按列的类型比较：INTEGER 列上位数不同的值按数值比较（23 < 109），
+// 连接键 "007" 与 7 相等；条件中的 OR 和未加引号的非数字标识符报错，不按文本比较
+namespace {
+
+using Rows = std::vector<std::vector<std::string>>;
+
+int failures = 0;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "失败: " << message << "\n";
+        failures++;
+    }
+}
+
+const size_t STUDENTS = 2000;   // 超过一个区域映射块
+const size_t ENROLLMENTS = 300;
+
+ColumnDef column(const std::string& name, const std::string& type) {
+    ColumnDef col;
+    col.name = name;
+    col.type = type;
+    return col;
+}
+
+int age(size_t id) {
+    static const int ages[] = {3, 9, 20, 23, 100, 105};
+    return ages[id % 6];
+}
+
+size_t courseId(size_t i) {
+    return i * 7 % 150 + 1;
+}
+
+double grade(size_t i) {
+    return 50 + static_cast<double>(i % 100) / 2;
+}
+
+std::string gradeText(size_t i) {
+    std::string text = std::to_string(grade(i));
+    text.erase(text.find_last_not_of('0') + 1);
+    if (text.back() == '.') {
+        text.pop_back();
+    }
+    return text;
+}
+
+Rows query(DatabaseManager& dbManager, const std::string& sql) {
+    SQLParser::SQLParser parser;
+    auto result = dbManager.executeSelect(parser.parse(sql));
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// 查询应当失败，错误信息包含 expected
+void checkRejected(DatabaseManager& dbManager, const std::string& sql, const std::string& expected) {
+    try {
+        query(dbManager, sql);
+        check(false, "应当报错: " + sql);
+    } catch (const std::exception& e) {
+        check(std::string(e.what()).find(expected) != std::string::npos,
+              "错误信息不对: " + sql + " -> " + e.what());
+    }
+}
+
+// 按数值计算期望的结果：学生 s 与其选课 e（e.SID = s.ID）中满足 filter 的 (s.ID, e.CID)
+Rows expectedEnrollments(const std::function<bool(size_t id, size_t i)>& filter) {
+    Rows rows;
+    for (size_t i = 0; i < ENROLLMENTS; i++) {
+        size_t id = i % 60 + 1;
+        if (filter(id, i)) {
+            rows.push_back({std::to_string(id), std::to_string(courseId(i))});
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::filesystem::path dataPath = argc > 1 ? argv[1] : "join_planner_test_data";
+    std::filesystem::remove_all(dataPath);
+    std::filesystem::create_directories(dataPath);
+
+    DatabaseManager dbManager(dataPath.string());
+    dbManager.createDatabase("test");
+    dbManager.useDatabase("test");
+
+    std::vector<ColumnDef> studentColumns = {
+        column("ID", "INTEGER"), column("Name", "TEXT"), column("Age", "INTEGER"),
+    };
+    Table students("S", studentColumns);
+    for (size_t id = 1; id <= STUDENTS; id++) {
+        students.insertRow({std::to_string(id), "n" + std::to_string(id), std::to_string(age(id))});
+    }
+    dbManager.createTable("S", studentColumns);
+    dbManager.replaceTable("S", std::move(students));
+
+    // 学号写成三位（"007"），连接时与 S.ID 按数值相等
+    std::vector<ColumnDef> enrollmentColumns = {
+        column("SID", "INTEGER"), column("CID", "INTEGER"), column("Grade", "FLOAT"),
+    };
+    Table enrollments("E", enrollmentColumns);
+    for (size_t i = 0; i < ENROLLMENTS; i++) {
+        std::string sid = std::to_string(i % 60 + 1);
+        sid.insert(0, 3 - std::min<size_t>(3, sid.size()), '0');
+        enrollments.insertRow({sid, std::to_string(courseId(i)), gradeText(i)});
+    }
+    dbManager.createTable("E", enrollmentColumns);
+    dbManager.replaceTable("E", std::move(enrollments));
+
+    // 跨表的列比较
+    check(query(dbManager, "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID WHERE s.Age > e.CID;") ==
+              expectedEnrollments([](size_t id, size_t i) { return static_cast<size_t>(age(id)) > courseId(i); }),
+          "s.Age > e.CID 应当按数值比较");
+    check(query(dbManager, "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID;") ==
+              expectedEnrollments([](size_t, size_t) { return true; }),
+          "连接键 \"007\" 应当与 7 相等");
+
+    // 下推到扫描的过滤条件，每张表一个数值范围
+    auto explain = [&dbManager](const std::string& sql) {
+        SQLParser::SQLParser parser;
+        std::string plan;
+        for (const auto& row : dbManager.executeSelect(parser.parse("EXPLAIN " + sql))) {
+            for (const auto& value : row) {
+                plan += value + "\n";
+            }
+        }
+        return plan;
+    };
+    const std::string agePushed = "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID WHERE s.Age > 20;";
+    check(explain(agePushed).find("过滤: s.Age > 20") != std::string::npos, "s.Age > 20 应当下推到 S 的扫描");
+    check(query(dbManager, agePushed) ==
+              expectedEnrollments([](size_t id, size_t) { return age(id) > 20; }),
+          "下推的 s.Age > 20 应当按数值比较");
+    const std::string gradePushed = "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID WHERE e.Grade >= 99.5;";
+    check(explain(gradePushed).find("过滤: e.Grade >= 99.5") != std::string::npos,
+          "e.Grade >= 99.5 应当下推到 E 的扫描");
+    check(query(dbManager, gradePushed) ==
+              expectedEnrollments([](size_t, size_t i) { return grade(i) >= 99.5; }),
+          "下推的 e.Grade >= 99.5 应当按数值比较");
+
+    // 自连接中下推到一侧的过滤；ID 跨越多个区域映射块，按文本的最值（"999"）不能用于跳过
+    Rows expected;
+    for (size_t id = 1; id < 5; id++) {
+        for (size_t other = 1; other <= STUDENTS; other++) {
+            if (age(id) == age(other)) {
+                expected.push_back({"n" + std::to_string(id), "n" + std::to_string(other)});
+            }
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+    check(query(dbManager, "SELECT s.Name, t.Name FROM S s JOIN S t ON s.Age = t.Age WHERE s.ID < 5;") == expected,
+          "自连接中下推的 s.ID < 5 应当按数值比较");
+    Rows highIds = query(dbManager, "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID WHERE s.ID > 999;");
+    check(highIds.empty(), "s.ID > 999 不应匹配学号 1 到 60 的选课");
+    Rows scanned = query(dbManager, "SELECT s.Name, t.Name FROM S s JOIN S t ON s.ID = t.ID WHERE s.ID > 999;");
+    check(scanned.size() == STUDENTS - 999, "s.ID > 999 应当匹配 1001 行（区域映射不能按文本跳过块）");
+
+    // 不支持的条件报错，不按文本比较
+    checkRejected(dbManager, "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID "
+                             "WHERE e.Grade >= 99.5 OR s.ID = 3;", "无效的条件");
+    checkRejected(dbManager, "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID "
+                             "WHERE (s.ID = 3);", "无效的条件");
+    checkRejected(dbManager, "SELECT s.ID, e.CID FROM S s JOIN E e ON s.ID = e.SID "
+                             "WHERE s.Name = n3;", "列不存在: n3");
+
+    std::filesystem::remove_all(dataPath);
+    if (failures > 0) {
+        return 1;
+    }
+    std::cout << "join_planner_test: 通过\n";
+    return 0;
+}
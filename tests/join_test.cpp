@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Table.h"
+
+// 同一个连接在右表连接列有索引和没有索引时结果相同（行的顺序可以不同）：
+// 数值键按数值匹配（"1" 与 "01"、"1.0" 相等），文本键按文本精确匹配
+namespace {
+
+using Rows = std::vector<std::vector<std::string>>;
+
+int failures = 0;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "失败: " << message << "\n";
+        failures++;
+    }
+}
+
+Table makeTable(const std::string& name, const std::string& keyType, const Rows& rows) {
+    std::vector<ColumnDef> columns(2);
+    columns[0].name = "K";
+    columns[0].type = keyType;
+    columns[1].name = "V";
+    columns[1].type = "TEXT";
+    // 与读取表文件时一样直接追加行，空字符串为空值
+    Table table(name, columns);
+    Rows copy = rows;
+    table.appendRows(copy);
+    table.rebuildStructures();
+    return table;
+}
+
+Rows sorted(Rows rows) {
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+void checkJoin(const std::string& keyType, const Rows& leftRows, const Rows& rightRows, size_t expectedInner) {
+    const Table left = makeTable("L", keyType, leftRows);
+    const Table plain = makeTable("R", keyType, rightRows);
+    Table indexed = plain;
+    indexed.createIndex("K");
+
+    const std::vector<std::pair<JoinType, std::string>> joinTypes = {
+        {JoinType::INNER, "INNER"}, {JoinType::LEFT, "LEFT"}, {JoinType::RIGHT, "RIGHT"}, {JoinType::FULL, "FULL"},
+    };
+    for (const auto& [joinType, name] : joinTypes) {
+        std::string label = keyType + " " + name + " JOIN";
+        Rows expected = sorted(left.join(plain, "K", "K", joinType, JoinMethod::NESTED_LOOP));
+        check(sorted(left.join(plain, "K", "K", joinType)) == expected, label + "：无索引时与嵌套循环的结果不同");
+        check(sorted(left.join(indexed, "K", "K", joinType)) == expected, label + "：有索引时结果不同");
+        check(sorted(left.join(indexed, "K", "K", joinType, JoinMethod::INDEX_NESTED_LOOP)) == expected,
+              label + "：指定索引嵌套循环时结果不同");
+        if (joinType == JoinType::INNER) {
+            check(expected.size() == expectedInner, label + "：匹配的行数不对");
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    checkJoin("INTEGER", {{"1", "a"}, {"2", "b"}, {"3", "c"}, {"", "d"}},
+                         {{"01", "x"}, {"2", "y"}, {"2", "z"}, {"4", "w"}, {"", "v"}}, 3);
+    checkJoin("FLOAT", {{"1", "a"}, {"2.5", "b"}, {"3", "c"}},
+                       {{"1.0", "x"}, {"2.50", "y"}, {"4", "z"}}, 2);
+    checkJoin("TEXT", {{"a", "1"}, {"b", "2"}, {"B", "3"}, {"", "4"}},
+                      {{"a", "x"}, {"b", "y"}, {"b", "z"}, {"c", "w"}}, 3);
+
+    if (failures > 0) {
+        return 1;
+    }
+    std::cout << "join_test: 通过\n";
+    return 0;
+}